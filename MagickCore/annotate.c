@@ -72,8 +72,10 @@
 #include "MagickCore/property.h"
 #include "MagickCore/resource_.h"
 #include "MagickCore/semaphore.h"
+#include "MagickCore/splay-tree.h"
 #include "MagickCore/statistic.h"
 #include "MagickCore/string_.h"
+#include "MagickCore/string-private.h"
 #include "MagickCore/token.h"
 #include "MagickCore/token-private.h"
 #include "MagickCore/transform.h"
@@ -129,12 +131,100 @@ typedef struct _GraphemeInfo
   size_t
     cluster;
 } GraphemeInfo;
+
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+/*
+  Define declarations.
+*/
+#define FontCacheLimit  (16*1024*1024)
+#define FontCacheMaximumFaces  16
+
+/*
+  Typedef declarations.
+*/
+typedef struct _FontFaceInfo
+{
+  size_t
+    id;
+
+  FT_Memory
+    memory;
+
+  FT_Library
+    library;
+
+  FT_StreamRec
+    *stream;
+
+  FT_Face
+    face;
+
+  SemaphoreInfo
+    *semaphore;
+} FontFaceInfo;
+
+typedef struct _FontGlyphInfo
+{
+  FT_BBox
+    bounds;
+
+  FT_Int
+    left,
+    top;
+
+  FT_Bitmap
+    bitmap;
+} FontGlyphInfo;
+
+typedef struct _FontRunInfo
+{
+  GraphemeInfo
+    *grapheme;
+
+  size_t
+    length;
+} FontRunInfo;
+
+typedef struct _FontCacheInfo
+{
+  MagickBooleanType
+    initialized;
+
+  MagickSizeType
+    extent,
+    limit;
+
+  MagickSizeType
+    face_hits,
+    face_misses,
+    glyph_hits,
+    glyph_misses,
+    run_hits,
+    run_misses;
+
+  SplayTreeInfo
+    *faces,
+    *glyphs,
+    *runs;
+} FontCacheInfo;
+#endif
 
 /*
   Annotate semaphores.
 */
 static SemaphoreInfo
   *annotate_semaphore = (SemaphoreInfo *) NULL;
+
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+/*
+  Open faces, shaped runs, and rendered glyphs, shared by all threads.
+*/
+static FontCacheInfo
+  font_cache;
+
+static SemaphoreInfo
+  *font_semaphore = (SemaphoreInfo *) NULL;
+#endif
 
 /*
   Forward declarations.
@@ -148,6 +238,11 @@ static MagickBooleanType
     TypeMetric *,ExceptionInfo *),
   RenderX11(Image *,const DrawInfo *,const PointInfo *,TypeMetric *,
     ExceptionInfo *);
+
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+static void
+  DestroyFontCache(void);
+#endif
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -171,6 +266,10 @@ MagickPrivate MagickBooleanType AnnotateComponentGenesis(void)
 {
   if (annotate_semaphore == (SemaphoreInfo *) NULL)
     annotate_semaphore=AcquireSemaphoreInfo();
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+  if (font_semaphore == (SemaphoreInfo *) NULL)
+    font_semaphore=AcquireSemaphoreInfo();
+#endif
   return(MagickTrue);
 }
 
@@ -197,6 +296,10 @@ MagickPrivate void AnnotateComponentTerminus(void)
   if (annotate_semaphore == (SemaphoreInfo *) NULL)
     ActivateSemaphoreInfo(&annotate_semaphore);
   RelinquishSemaphoreInfo(&annotate_semaphore);
+#if defined(MAGICKCORE_FREETYPE_DELEGATE)
+  DestroyFontCache();
+  RelinquishSemaphoreInfo(&font_semaphore);
+#endif
 }
 
 /*
@@ -1476,6 +1579,349 @@ static FT_Error FreetypeInit(FT_Memory memory,FT_Library *alibrary)
   return(ft_status);
 }
 
+static FontFaceInfo *DestroyFontFaceInfo(FontFaceInfo *face_info)
+{
+  (void) FT_Done_Face(face_info->face);
+  FreetypeDone(face_info->memory,face_info->library,face_info->stream);
+  RelinquishSemaphoreInfo(&face_info->semaphore);
+  face_info=(FontFaceInfo *) RelinquishMagickMemory(face_info);
+  return(face_info);
+}
+
+static void *DestroyFontFace(void *face_info)
+{
+  return((void *) DestroyFontFaceInfo((FontFaceInfo *) face_info));
+}
+
+static void *DestroyFontGlyph(void *glyph_info)
+{
+  FontGlyphInfo
+    *p;
+
+  p=(FontGlyphInfo *) glyph_info;
+  if (p->bitmap.buffer != (unsigned char *) NULL)
+    p->bitmap.buffer=(unsigned char *) RelinquishMagickMemory(
+      p->bitmap.buffer);
+  return(RelinquishMagickMemory(p));
+}
+
+static void *DestroyFontRun(void *run_info)
+{
+  FontRunInfo
+    *p;
+
+  p=(FontRunInfo *) run_info;
+  if (p->grapheme != (GraphemeInfo *) NULL)
+    p->grapheme=(GraphemeInfo *) RelinquishMagickMemory(p->grapheme);
+  return(RelinquishMagickMemory(p));
+}
+
+static void DestroyFontCache(void)
+{
+  if (font_semaphore == (SemaphoreInfo *) NULL)
+    ActivateSemaphoreInfo(&font_semaphore);
+  LockSemaphoreInfo(font_semaphore);
+  if (font_cache.faces != (SplayTreeInfo *) NULL)
+    font_cache.faces=DestroySplayTree(font_cache.faces);
+  if (font_cache.glyphs != (SplayTreeInfo *) NULL)
+    font_cache.glyphs=DestroySplayTree(font_cache.glyphs);
+  if (font_cache.runs != (SplayTreeInfo *) NULL)
+    font_cache.runs=DestroySplayTree(font_cache.runs);
+  if (font_cache.extent != 0)
+    RelinquishMagickResource(MemoryResource,font_cache.extent);
+  (void) memset(&font_cache,0,sizeof(font_cache));
+  UnlockSemaphoreInfo(font_semaphore);
+}
+
+static MagickBooleanType ReserveFontCache(const MagickSizeType extent)
+{
+  /*
+    Charge an entry against the cache limit and the memory resource; once
+    the limit is reached the glyphs and runs are dropped and the cache
+    refills with whatever is in use now.  The caller holds font_semaphore.
+  */
+  if (extent > font_cache.limit)
+    return(MagickFalse);
+  if ((font_cache.extent+extent) > font_cache.limit)
+    {
+      ResetSplayTree(font_cache.glyphs);
+      ResetSplayTree(font_cache.runs);
+      RelinquishMagickResource(MemoryResource,font_cache.extent);
+      font_cache.extent=0;
+    }
+  if (AcquireMagickResource(MemoryResource,extent) == MagickFalse)
+    return(MagickFalse);
+  font_cache.extent+=extent;
+  return(MagickTrue);
+}
+
+static MagickBooleanType InitializeFontCache(void)
+{
+  char
+    *value;
+
+  /*
+    The caller holds font_semaphore.
+  */
+  if (font_cache.initialized != MagickFalse)
+    return(font_cache.faces != (SplayTreeInfo *) NULL ? MagickTrue :
+      MagickFalse);
+  font_cache.initialized=MagickTrue;
+  font_cache.limit=FontCacheLimit;
+  value=GetEnvironmentValue("MAGICK_FONT_CACHE_LIMIT");
+  if (value == (char *) NULL)
+    value=GetPolicyValue("cache:font-limit");
+  if (value != (char *) NULL)
+    {
+      font_cache.limit=StringToMagickSizeType(value,100.0);
+      value=DestroyString(value);
+    }
+  if (font_cache.limit == 0)
+    return(MagickFalse);
+  font_cache.faces=NewSplayTree(CompareSplayTreeString,RelinquishMagickMemory,
+    DestroyFontFace);
+  font_cache.glyphs=NewSplayTree(CompareSplayTreeString,
+    RelinquishMagickMemory,DestroyFontGlyph);
+  font_cache.runs=NewSplayTree(CompareSplayTreeString,RelinquishMagickMemory,
+    DestroyFontRun);
+  return(MagickTrue);
+}
+
+static FontFaceInfo *AcquireFontFace(const char *key)
+{
+  FontFaceInfo
+    *face_info;
+
+  /*
+    Return the open face for this key, locked for the caller's exclusive use.
+  */
+  face_info=(FontFaceInfo *) NULL;
+  if (font_semaphore == (SemaphoreInfo *) NULL)
+    ActivateSemaphoreInfo(&font_semaphore);
+  LockSemaphoreInfo(font_semaphore);
+  if (InitializeFontCache() != MagickFalse)
+    {
+      face_info=(FontFaceInfo *) GetValueFromSplayTree(font_cache.faces,key);
+      if (face_info != (FontFaceInfo *) NULL)
+        font_cache.face_hits++;
+      else
+        font_cache.face_misses++;
+    }
+  UnlockSemaphoreInfo(font_semaphore);
+  if (face_info != (FontFaceInfo *) NULL)
+    LockSemaphoreInfo(face_info->semaphore);
+  return(face_info);
+}
+
+static FontFaceInfo *AddFontFace(const char *key,FT_Memory memory,
+  FT_Library library,FT_StreamRec *stream,FT_Face face)
+{
+  FontFaceInfo
+    *face_info;
+
+  /*
+    Keep a newly opened face open for later calls, returned locked.  Faces
+    are never evicted, so at most FontCacheMaximumFaces are retained.
+  */
+  if (font_semaphore == (SemaphoreInfo *) NULL)
+    ActivateSemaphoreInfo(&font_semaphore);
+  LockSemaphoreInfo(font_semaphore);
+  if ((InitializeFontCache() == MagickFalse) ||
+      (GetNumberOfNodesInSplayTree(font_cache.faces) >= FontCacheMaximumFaces) ||
+      (GetValueFromSplayTree(font_cache.faces,key) != (const void *) NULL))
+    {
+      UnlockSemaphoreInfo(font_semaphore);
+      return((FontFaceInfo *) NULL);
+    }
+  face_info=(FontFaceInfo *) AcquireMagickMemory(sizeof(*face_info));
+  if (face_info == (FontFaceInfo *) NULL)
+    {
+      UnlockSemaphoreInfo(font_semaphore);
+      return((FontFaceInfo *) NULL);
+    }
+  (void) memset(face_info,0,sizeof(*face_info));
+  face_info->id=GetNumberOfNodesInSplayTree(font_cache.faces)+1;
+  face_info->memory=memory;
+  face_info->library=library;
+  face_info->stream=stream;
+  face_info->face=face;
+  face_info->semaphore=AcquireSemaphoreInfo();
+  LockSemaphoreInfo(face_info->semaphore);
+  if (AddValueToSplayTree(font_cache.faces,ConstantString(key),face_info) ==
+      MagickFalse)
+    {
+      UnlockSemaphoreInfo(face_info->semaphore);
+      RelinquishSemaphoreInfo(&face_info->semaphore);
+      face_info=(FontFaceInfo *) RelinquishMagickMemory(face_info);
+    }
+  UnlockSemaphoreInfo(font_semaphore);
+  return(face_info);
+}
+
+static void RelinquishFontFace(FontFaceInfo *face_info,FT_Memory memory,
+  FT_Library library,FT_StreamRec *stream,FT_Face face)
+{
+  if (face_info != (FontFaceInfo *) NULL)
+    {
+      UnlockSemaphoreInfo(face_info->semaphore);
+      return;
+    }
+  (void) FT_Done_Face(face);
+  FreetypeDone(memory,library,stream);
+}
+
+static MagickBooleanType GetFontGlyph(const char *key,FT_BBox *bounds,
+  FT_BitmapGlyphRec *bitmap,unsigned char **buffer,size_t *extent)
+{
+  const FontGlyphInfo
+    *glyph_info;
+
+  size_t
+    length;
+
+  /*
+    Copy a cached glyph bitmap out, so a concurrent flush cannot free it
+    while the caller rasterizes.
+  */
+  LockSemaphoreInfo(font_semaphore);
+  glyph_info=(const FontGlyphInfo *) GetValueFromSplayTree(font_cache.glyphs,
+    key);
+  if (glyph_info == (const FontGlyphInfo *) NULL)
+    {
+      font_cache.glyph_misses++;
+      UnlockSemaphoreInfo(font_semaphore);
+      return(MagickFalse);
+    }
+  length=(size_t) glyph_info->bitmap.pitch*glyph_info->bitmap.rows;
+  if (length > *extent)
+    {
+      *buffer=(unsigned char *) ResizeQuantumMemory(*buffer,length,
+        sizeof(**buffer));
+      *extent=(*buffer == (unsigned char *) NULL) ? 0 : length;
+      if (*buffer == (unsigned char *) NULL)
+        {
+          UnlockSemaphoreInfo(font_semaphore);
+          return(MagickFalse);
+        }
+    }
+  font_cache.glyph_hits++;
+  *bounds=glyph_info->bounds;
+  (void) memset(bitmap,0,sizeof(*bitmap));
+  bitmap->left=glyph_info->left;
+  bitmap->top=glyph_info->top;
+  bitmap->bitmap=glyph_info->bitmap;
+  bitmap->bitmap.buffer=(unsigned char *) NULL;
+  if (length != 0)
+    {
+      (void) memcpy(*buffer,glyph_info->bitmap.buffer,length);
+      bitmap->bitmap.buffer=(*buffer);
+    }
+  UnlockSemaphoreInfo(font_semaphore);
+  return(MagickTrue);
+}
+
+static void AddFontGlyph(const char *key,const FT_BBox *bounds,
+  const FT_BitmapGlyph bitmap,const FT_Vector *delta)
+{
+  FontGlyphInfo
+    *glyph_info;
+
+  size_t
+    length;
+
+  /*
+    The bitmap is stored relative to the whole-pixel part of the glyph
+    origin; outlines rasterize identically under whole-pixel translation.
+  */
+  if (bitmap->bitmap.pitch < 0)
+    return;
+  length=(size_t) bitmap->bitmap.pitch*bitmap->bitmap.rows;
+  glyph_info=(FontGlyphInfo *) AcquireMagickMemory(sizeof(*glyph_info));
+  if (glyph_info == (FontGlyphInfo *) NULL)
+    return;
+  (void) memset(glyph_info,0,sizeof(*glyph_info));
+  glyph_info->bounds=(*bounds);
+  glyph_info->left=bitmap->left-(FT_Int) ((delta->x-(delta->x & 63))/64);
+  glyph_info->top=bitmap->top-(FT_Int) ((delta->y-(delta->y & 63))/64);
+  glyph_info->bitmap=bitmap->bitmap;
+  glyph_info->bitmap.buffer=(unsigned char *) NULL;
+  if ((length != 0) && (bitmap->bitmap.buffer != (unsigned char *) NULL))
+    {
+      glyph_info->bitmap.buffer=(unsigned char *) AcquireQuantumMemory(length,
+        sizeof(*glyph_info->bitmap.buffer));
+      if (glyph_info->bitmap.buffer == (unsigned char *) NULL)
+        {
+          glyph_info=(FontGlyphInfo *) DestroyFontGlyph(glyph_info);
+          return;
+        }
+      (void) memcpy(glyph_info->bitmap.buffer,bitmap->bitmap.buffer,length);
+    }
+  LockSemaphoreInfo(font_semaphore);
+  if ((ReserveFontCache(sizeof(*glyph_info)+length+strlen(key)) == MagickFalse) ||
+      (AddValueToSplayTree(font_cache.glyphs,ConstantString(key),glyph_info) ==
+       MagickFalse))
+    glyph_info=(FontGlyphInfo *) DestroyFontGlyph(glyph_info);
+  UnlockSemaphoreInfo(font_semaphore);
+}
+
+static size_t GetFontRun(const char *key,GraphemeInfo **grapheme)
+{
+  const FontRunInfo
+    *run_info;
+
+  size_t
+    length;
+
+  length=0;
+  LockSemaphoreInfo(font_semaphore);
+  run_info=(const FontRunInfo *) GetValueFromSplayTree(font_cache.runs,key);
+  if (run_info == (const FontRunInfo *) NULL)
+    font_cache.run_misses++;
+  else
+    {
+      *grapheme=(GraphemeInfo *) AcquireQuantumMemory(run_info->length,
+        sizeof(**grapheme));
+      if (*grapheme != (GraphemeInfo *) NULL)
+        {
+          (void) memcpy(*grapheme,run_info->grapheme,run_info->length*
+            sizeof(**grapheme));
+          length=run_info->length;
+          font_cache.run_hits++;
+        }
+    }
+  UnlockSemaphoreInfo(font_semaphore);
+  return(length);
+}
+
+static void AddFontRun(const char *key,const GraphemeInfo *grapheme,
+  const size_t length)
+{
+  FontRunInfo
+    *run_info;
+
+  if (length == 0)
+    return;
+  run_info=(FontRunInfo *) AcquireMagickMemory(sizeof(*run_info));
+  if (run_info == (FontRunInfo *) NULL)
+    return;
+  run_info->length=length;
+  run_info->grapheme=(GraphemeInfo *) AcquireQuantumMemory(length,
+    sizeof(*run_info->grapheme));
+  if (run_info->grapheme == (GraphemeInfo *) NULL)
+    {
+      run_info=(FontRunInfo *) DestroyFontRun(run_info);
+      return;
+    }
+  (void) memcpy(run_info->grapheme,grapheme,length*sizeof(*grapheme));
+  LockSemaphoreInfo(font_semaphore);
+  if ((ReserveFontCache(sizeof(*run_info)+length*sizeof(*grapheme)+
+       strlen(key)) == MagickFalse) ||
+      (AddValueToSplayTree(font_cache.runs,ConstantString(key),run_info) ==
+       MagickFalse))
+    run_info=(FontRunInfo *) DestroyFontRun(run_info);
+  UnlockSemaphoreInfo(font_semaphore);
+}
+
 static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   const char *encoding,const PointInfo *offset,TypeMetric *metrics,
   ExceptionInfo *exception)
@@ -1509,7 +1955,11 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   } GlyphInfo;
 
   char
-    *p;
+    face_key[MagickPathExtent],
+    glyph_key[MagickPathExtent],
+    *p,
+    *run_key,
+    strike_key[MagickPathExtent];
 
   const char
     *value;
@@ -1523,6 +1973,9 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   FT_BitmapGlyph
     bitmap;
 
+  FT_BitmapGlyphRec
+    cache_bitmap;
+
   FT_Encoding
     encoding_type;
 
@@ -1559,8 +2012,12 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     missing_glyph_id;
 
   FT_Vector
+    delta,
     origin;
 
+  FontFaceInfo
+    *face_info;
+
   GlyphInfo
     glyph;
 
@@ -1568,7 +2025,9 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     *grapheme;
 
   MagickBooleanType
-    status;
+    cached,
+    status,
+    trace;
 
   PointInfo
     point,
@@ -1578,6 +2037,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     i;
 
   size_t
+    extent,
     length;
 
   ssize_t
@@ -1599,19 +2059,9 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     attributes;
 
   unsigned char
+    *buffer,
     *utf8;
 
-  /*
-    Initialize Truetype library.
-  */
-  memory=FreetypeAcquireMemoryManager();
-  if (memory == (FT_Memory) NULL)
-    ThrowBinaryException(ResourceLimitError,"UnableToInitializeFreetypeLibrary",
-      image->filename);
-  ft_status=FreetypeInit(memory,&library);
-  if (ft_status != 0)
-    ThrowFreetypeErrorException("UnableToInitializeFreetypeLibrary",ft_status,
-      image->filename);
   /*
     Open font face.
   */
@@ -1640,31 +2090,75 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
         image_info=DestroyImageInfo(image_info);
      }
   /*
-    Configure streaming interface.
+    Reuse the face opened by an earlier call while the font file is unchanged.
   */
-  stream=(FT_StreamRec *) AcquireCriticalMemory(sizeof(*stream));
-  (void) memset(stream,0,sizeof(*stream));
+  face_info=(FontFaceInfo *) NULL;
+  *face_key='\0';
   if (stat(args.pathname,&attributes) == 0)
-    stream->size=attributes.st_size >= 0 ? (unsigned long)
-      attributes.st_size : 0;
-  stream->descriptor.pointer=fopen_utf8(args.pathname,"rb");
-  stream->read=(&FreetypeReadStream);
-  stream->close=(&FreetypeCloseStream);
-  args.flags=FT_OPEN_STREAM;
-  args.stream=stream;
-  face=(FT_Face) NULL;
-  ft_status=FT_Open_Face(library,&args,face_index,&face);
-  if (ft_status != 0)
     {
-      FreetypeDone(memory,library,stream);
-      ThrowFreetypeErrorException("UnableToReadFont",ft_status,args.pathname);
+      (void) FormatLocaleString(face_key,MagickPathExtent,
+        "%s|%.20g|%s|%.20g|%.20g",args.pathname,(double) face_index,
+        draw_info->metrics != (char *) NULL ? draw_info->metrics : "",
+        (double) attributes.st_size,(double) attributes.st_mtime);
+      if (strlen(face_key) < (MagickPathExtent-1))
+        face_info=AcquireFontFace(face_key);
+      else
+        *face_key='\0';
+    }
+  if (face_info != (FontFaceInfo *) NULL)
+    {
+      memory=face_info->memory;
+      library=face_info->library;
+      stream=face_info->stream;
+      face=face_info->face;
       args.pathname=DestroyString(args.pathname);
-      return(MagickFalse);
     }
-  args.pathname=DestroyString(args.pathname);
-  if ((draw_info->metrics != (char *) NULL) &&
-      (IsPathAccessible(draw_info->metrics) != MagickFalse))
-    (void) FT_Attach_File(face,draw_info->metrics);
+  else
+    {
+      /*
+        Initialize Truetype library.
+      */
+      memory=FreetypeAcquireMemoryManager();
+      if (memory == (FT_Memory) NULL)
+        {
+          args.pathname=DestroyString(args.pathname);
+          ThrowBinaryException(ResourceLimitError,
+            "UnableToInitializeFreetypeLibrary",image->filename);
+        }
+      ft_status=FreetypeInit(memory,&library);
+      if (ft_status != 0)
+        ThrowFreetypeErrorException("UnableToInitializeFreetypeLibrary",
+          ft_status,image->filename);
+      /*
+        Configure streaming interface.
+      */
+      stream=(FT_StreamRec *) AcquireCriticalMemory(sizeof(*stream));
+      (void) memset(stream,0,sizeof(*stream));
+      if (stat(args.pathname,&attributes) == 0)
+        stream->size=attributes.st_size >= 0 ? (unsigned long)
+          attributes.st_size : 0;
+      stream->descriptor.pointer=fopen_utf8(args.pathname,"rb");
+      stream->read=(&FreetypeReadStream);
+      stream->close=(&FreetypeCloseStream);
+      args.flags=FT_OPEN_STREAM;
+      args.stream=stream;
+      face=(FT_Face) NULL;
+      ft_status=FT_Open_Face(library,&args,face_index,&face);
+      if (ft_status != 0)
+        {
+          FreetypeDone(memory,library,stream);
+          ThrowFreetypeErrorException("UnableToReadFont",ft_status,
+            args.pathname);
+          args.pathname=DestroyString(args.pathname);
+          return(MagickFalse);
+        }
+      args.pathname=DestroyString(args.pathname);
+      if ((draw_info->metrics != (char *) NULL) &&
+          (IsPathAccessible(draw_info->metrics) != MagickFalse))
+        (void) FT_Attach_File(face,draw_info->metrics);
+      if (*face_key != '\0')
+        face_info=AddFontFace(face_key,memory,library,stream,face);
+    }
   encoding_type=FT_ENCODING_UNICODE;
   ft_status=FT_Select_Charmap(face,encoding_type);
   if ((ft_status != 0) && (face->num_charmaps != 0))
@@ -1710,8 +2204,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
       ft_status=FT_Select_Charmap(face,encoding_type);
       if (ft_status != 0)
         {
-          (void) FT_Done_Face(face);
-          FreetypeDone(memory,library,stream);
+          RelinquishFontFace(face_info,memory,library,stream,face);
           ThrowFreetypeErrorException("UnrecognizedFontEncoding",ft_status,
             encoding);
           return(MagickFalse);
@@ -1742,8 +2235,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     (FT_UInt) resolution.y);
   if (ft_status != 0)
     {
-      (void) FT_Done_Face(face);
-      FreetypeDone(memory,library,stream);
+      RelinquishFontFace(face_info,memory,library,stream,face);
       ThrowFreetypeErrorException("UnableToReadFont",ft_status,
         draw_info->font);
       return(MagickFalse);
@@ -1781,8 +2273,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
   if ((draw_info->text == (char *) NULL) || (*draw_info->text == '\0') ||
       (first_glyph_id == 0))
     {
-      (void) FT_Done_Face(face);
-      FreetypeDone(memory,library,stream);
+      RelinquishFontFace(face_info,memory,library,stream,face);
       return(MagickTrue);
     }
   /*
@@ -1851,13 +2342,50 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
       if (utf8 != (unsigned char *) NULL)
         p=(char *) utf8;
     }
+  /*
+    Shaped runs and glyph bitmaps are cached for this face at this size,
+    resolution, load flags, and transform.
+  */
+  run_key=(char *) NULL;
+  if (face_info != (FontFaceInfo *) NULL)
+    {
+      (void) FormatLocaleString(strike_key,MagickPathExtent,
+        "%.20g|%.20g|%.20g,%.20g|%.20g|%.20g,%.20g,%.20g,%.20g",(double)
+        face_info->id,draw_info->pointsize,resolution.x,resolution.y,(double)
+        flags,(double) affine.xx,(double) affine.yx,(double) affine.xy,
+        (double) affine.yy);
+      run_key=AcquireString(strike_key);
+      (void) FormatLocaleString(glyph_key,MagickPathExtent,"|%s|%d|",
+        encoding != (const char *) NULL ? encoding : "",(int)
+        draw_info->direction);
+      (void) ConcatenateString(&run_key,glyph_key);
+#if defined(MAGICKCORE_RAQM_DELEGATE)
+      value=GetImageProperty(image,"type:features",exception);
+      if (value != (const char *) NULL)
+        (void) ConcatenateString(&run_key,value);
+      (void) ConcatenateString(&run_key,"|");
+#endif
+      (void) ConcatenateString(&run_key,p);
+    }
   grapheme=(GraphemeInfo *) NULL;
+  length=0;
+  if (run_key != (char *) NULL)
+    length=GetFontRun(run_key,&grapheme);
+  if (length == 0)
+    {
 #if defined(MAGICKCORE_RAQM_DELEGATE)
-  length=ComplexRaqmTextLayout(image,draw_info,p,strlen(p),face,&grapheme,
-    exception);
+      length=ComplexRaqmTextLayout(image,draw_info,p,strlen(p),face,&grapheme,
+        exception);
 #else
-  length=ComplexTextLayout(draw_info,p,strlen(p),face,flags,&grapheme);
+      length=ComplexTextLayout(draw_info,p,strlen(p),face,flags,&grapheme);
 #endif
+      if (run_key != (char *) NULL)
+        AddFontRun(run_key,grapheme,length);
+    }
+  if (run_key != (char *) NULL)
+    run_key=DestroyString(run_key);
+  buffer=(unsigned char *) NULL;
+  extent=0;
   missing_glyph_id=FT_Get_Char_Index(face,' ');
   code=0;
   last_character=(ssize_t) length-1;
@@ -1882,19 +2410,41 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
         FT_Done_Glyph(glyph.image);
         glyph.image=(FT_Glyph) NULL;
       }
-    ft_status=FT_Load_Glyph(face,glyph.id,flags);
-    if (ft_status != 0)
-      continue;
-    ft_status=FT_Get_Glyph(face->glyph,&glyph.image);
-    if (ft_status != 0)
-      continue;
-    outline=((FT_OutlineGlyph) glyph.image)->outline;
-    if ((glyph.image->format != FT_GLYPH_FORMAT_OUTLINE) &&
-        (IsEmptyOutline(outline) == MagickFalse))
-      continue;
-    ft_status=FT_Outline_Get_BBox(&outline,&bounds);
-    if (ft_status != 0)
-      continue;
+    delta=glyph.origin;
+    FT_Vector_Transform(&delta,&affine);
+    cached=MagickFalse;
+    if (face_info != (FontFaceInfo *) NULL)
+      {
+        (void) FormatLocaleString(glyph_key,MagickPathExtent,"%s|%u|%ld,%ld",
+          strike_key,glyph.id,(long) (delta.x & 63),(long) (delta.y & 63));
+        cached=GetFontGlyph(glyph_key,&bounds,&cache_bitmap,&buffer,&extent);
+      }
+    trace=(((draw_info->stroke.alpha != (MagickRealType) TransparentAlpha) ||
+      (draw_info->stroke_pattern != (Image *) NULL)) &&
+      ((status != MagickFalse) && (draw_info->render != MagickFalse))) ?
+      MagickTrue : MagickFalse;
+    if ((cached == MagickFalse) || (trace != MagickFalse))
+      {
+        /*
+          Load the glyph outline, a cached glyph only needs it to trace.
+        */
+        ft_status=FT_Load_Glyph(face,glyph.id,flags);
+        if (ft_status != 0)
+          continue;
+        ft_status=FT_Get_Glyph(face->glyph,&glyph.image);
+        if (ft_status != 0)
+          continue;
+        outline=((FT_OutlineGlyph) glyph.image)->outline;
+        if ((glyph.image->format != FT_GLYPH_FORMAT_OUTLINE) &&
+            (IsEmptyOutline(outline) == MagickFalse))
+          continue;
+        if (cached == MagickFalse)
+          {
+            ft_status=FT_Outline_Get_BBox(&outline,&bounds);
+            if (ft_status != 0)
+              continue;
+          }
+      }
     if ((bounds.xMin < metrics->bounds.x1) && (bounds.xMin != 0))
       metrics->bounds.x1=(double) bounds.xMin;
     if ((bounds.yMin < metrics->bounds.y1) && (bounds.yMin != 0))
@@ -1903,9 +2453,7 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
       metrics->bounds.x2=(double) bounds.xMax;
     if ((bounds.yMax > metrics->bounds.y2) && (bounds.yMax != 0))
       metrics->bounds.y2=(double) bounds.yMax;
-    if (((draw_info->stroke.alpha != (MagickRealType) TransparentAlpha) ||
-         (draw_info->stroke_pattern != (Image *) NULL)) &&
-        ((status != MagickFalse) && (draw_info->render != MagickFalse)))
+    if (trace != MagickFalse)
       {
         /*
           Trace the glyph.
@@ -1916,13 +2464,30 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
           ft_status=FT_Outline_Decompose(&outline,&OutlineMethods,
             annotate_info);
       }
-    FT_Vector_Transform(&glyph.origin,&affine);
-    (void) FT_Glyph_Transform(glyph.image,&affine,&glyph.origin);
-    ft_status=FT_Glyph_To_Bitmap(&glyph.image,FT_RENDER_MODE_NORMAL,
-      (FT_Vector *) NULL,MagickTrue);
-    if (ft_status != 0)
-      continue;
-    bitmap=(FT_BitmapGlyph) glyph.image;
+    if (cached != MagickFalse)
+      {
+        cache_bitmap.left+=(FT_Int) ((delta.x-(delta.x & 63))/64);
+        cache_bitmap.top+=(FT_Int) ((delta.y-(delta.y & 63))/64);
+        bitmap=(&cache_bitmap);
+      }
+    else
+      {
+        MagickBooleanType
+          cache_glyph;
+
+        cache_glyph=((face_info != (FontFaceInfo *) NULL) &&
+          (glyph.image->format == FT_GLYPH_FORMAT_OUTLINE)) ? MagickTrue :
+          MagickFalse;
+        glyph.origin=delta;
+        (void) FT_Glyph_Transform(glyph.image,&affine,&glyph.origin);
+        ft_status=FT_Glyph_To_Bitmap(&glyph.image,FT_RENDER_MODE_NORMAL,
+          (FT_Vector *) NULL,MagickTrue);
+        if (ft_status != 0)
+          continue;
+        bitmap=(FT_BitmapGlyph) glyph.image;
+        if (cache_glyph != MagickFalse)
+          AddFontGlyph(glyph_key,&bounds,bitmap,&delta);
+      }
     point.x=offset->x+bitmap->left;
     if (bitmap->bitmap.pixel_mode == ft_pixel_mode_mono)
       point.x+=(origin.x/64.0);
@@ -2087,6 +2652,8 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     grapheme=(GraphemeInfo *) RelinquishMagickMemory(grapheme);
   if (utf8 != (unsigned char *) NULL)
     utf8=(unsigned char *) RelinquishMagickMemory(utf8);
+  if (buffer != (unsigned char *) NULL)
+    buffer=(unsigned char *) RelinquishMagickMemory(buffer);
   if (glyph.image != (FT_Glyph) NULL)
     {
       FT_Done_Glyph(glyph.image);
@@ -2106,8 +2673,18 @@ static MagickBooleanType RenderFreetype(Image *image,const DrawInfo *draw_info,
     Relinquish resources.
   */
   annotate_info=DestroyDrawInfo(annotate_info);
-  (void) FT_Done_Face(face);
-  FreetypeDone(memory,library,stream);
+  if ((draw_info->debug != MagickFalse) && (face_info != (FontFaceInfo *) NULL))
+    {
+      LockSemaphoreInfo(font_semaphore);
+      (void) LogMagickEvent(AnnotateEvent,GetMagickModule(),"Font cache: "
+        "faces %g/%g, runs %g/%g, glyphs %g/%g hits/misses; extent %g",
+        (double) font_cache.face_hits,(double) font_cache.face_misses,
+        (double) font_cache.run_hits,(double) font_cache.run_misses,(double)
+        font_cache.glyph_hits,(double) font_cache.glyph_misses,(double)
+        font_cache.extent);
+      UnlockSemaphoreInfo(font_semaphore);
+    }
+  RelinquishFontFace(face_info,memory,library,stream,face);
   return(status);
 }
 #else
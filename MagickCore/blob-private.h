@@ -60,6 +60,22 @@ typedef enum
   CustomStream
 } StreamType;
 
+typedef struct _BlobReader
+{
+  Image
+    *image;
+
+  const unsigned char
+    *p,
+    *q;
+
+  size_t
+    extent;
+
+  unsigned char
+    buffer[MagickMinBufferExtent];
+} BlobReader;
+
 extern MagickExport BlobInfo
   *CloneBlobInfo(const BlobInfo *),
   *ReferenceBlob(BlobInfo *);
@@ -110,6 +126,9 @@ extern MagickExport signed short
   ReadBlobMSBSignedShort(Image *),
   ReadBlobSignedShort(Image *);
 
+extern MagickExport size_t
+  FillBlobReader(BlobReader *,const size_t);
+
 extern MagickExport ssize_t
   ReadBlob(Image *,const size_t,void *),
   WriteBlob(Image *,const size_t,const void *),
@@ -144,9 +163,78 @@ extern MagickExport void
   *DetachBlob(BlobInfo *),
   DisassociateBlob(Image *),
   GetBlobInfo(BlobInfo *),
+  GetBlobReader(Image *,BlobReader *),
   *MapBlob(int,const MapMode,const MagickOffsetType,const size_t),
   MSBOrderLong(unsigned char *,const size_t),
-  MSBOrderShort(unsigned char *,const size_t);
+  MSBOrderShort(unsigned char *,const size_t),
+  SyncBlobReader(BlobReader *);
+
+static inline const unsigned char *ReadBlobReaderBytes(BlobReader *reader,
+  const size_t length)
+{
+  const unsigned char
+    *p;
+
+  if (((size_t) (reader->q-reader->p) < length) &&
+      (FillBlobReader(reader,length) < length))
+    return((const unsigned char *) NULL);
+  p=reader->p;
+  reader->p+=length;
+  return(p);
+}
+
+static inline int ReadBlobReaderByte(BlobReader *reader)
+{
+  if ((reader->p == reader->q) && (FillBlobReader(reader,1) == 0))
+    return(EOF);
+  return((int) *reader->p++);
+}
+
+static inline unsigned int ReadBlobReaderLSBLong(BlobReader *reader)
+{
+  const unsigned char
+    *p;
+
+  p=ReadBlobReaderBytes(reader,4);
+  if (p == (const unsigned char *) NULL)
+    return(0U);
+  return((unsigned int) p[3] << 24 | (unsigned int) p[2] << 16 |
+    (unsigned int) p[1] << 8 | (unsigned int) p[0]);
+}
+
+static inline unsigned short ReadBlobReaderLSBShort(BlobReader *reader)
+{
+  const unsigned char
+    *p;
+
+  p=ReadBlobReaderBytes(reader,2);
+  if (p == (const unsigned char *) NULL)
+    return((unsigned short) 0U);
+  return((unsigned short) ((unsigned short) p[1] << 8 | p[0]));
+}
+
+static inline unsigned int ReadBlobReaderMSBLong(BlobReader *reader)
+{
+  const unsigned char
+    *p;
+
+  p=ReadBlobReaderBytes(reader,4);
+  if (p == (const unsigned char *) NULL)
+    return(0U);
+  return((unsigned int) p[0] << 24 | (unsigned int) p[1] << 16 |
+    (unsigned int) p[2] << 8 | (unsigned int) p[3]);
+}
+
+static inline unsigned short ReadBlobReaderMSBShort(BlobReader *reader)
+{
+  const unsigned char
+    *p;
+
+  p=ReadBlobReaderBytes(reader,2);
+  if (p == (const unsigned char *) NULL)
+    return((unsigned short) 0U);
+  return((unsigned short) ((unsigned short) p[0] << 8 | p[1]));
+}
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
@@ -83,6 +83,12 @@
   Define declarations.
 */
 #define MagickMaxBlobExtent  (8*8192)
+#define MagickReadAheadExtent  (4*MagickMaxBufferExtent)
+#if defined(MAGICKCORE_HAVE_GETC_UNLOCKED)
+#define ReadBlobStreamByte(file)  getc_unlocked(file)
+#else
+#define ReadBlobStreamByte(file)  getc(file)
+#endif
 #if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
 # define MAP_ANONYMOUS  MAP_ANON
 #endif
@@ -151,7 +157,8 @@ struct _BlobInfo
     error_number;
 
   MagickOffsetType
-    offset;
+    offset,
+    read_ahead;
 
   MagickSizeType
     size;
@@ -1768,6 +1775,92 @@ MagickExport MagickBooleanType FileToImage(Image *image,const char *filename,
 %                                                                             %
 %                                                                             %
 %                                                                             %
++   F i l l B l o b R e a d e r                                               %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  FillBlobReader() refills a blob reader so that at least length contiguous
+%  bytes are available, if the blob has that many left.  It returns the number
+%  of bytes available.  Memory-based blobs are served in place, other streams
+%  are read into the reader buffer.
+%
+%  The format of the FillBlobReader method is:
+%
+%      size_t FillBlobReader(BlobReader *reader,const size_t length)
+%
+%  A description of each parameter follows:
+%
+%    o reader: the blob reader.
+%
+%    o length: the number of contiguous bytes required.
+%
+*/
+MagickExport size_t FillBlobReader(BlobReader *reader,const size_t length)
+{
+  BlobInfo
+    *magick_restrict blob_info;
+
+  MagickOffsetType
+    offset;
+
+  MagickSizeType
+    size;
+
+  size_t
+    available,
+    extent;
+
+  ssize_t
+    count;
+
+  assert(reader != (BlobReader *) NULL);
+  assert(reader->image != (Image *) NULL);
+  available=(size_t) (reader->q-reader->p);
+  if ((available >= length) || (length > sizeof(reader->buffer)))
+    return(available);
+  blob_info=reader->image->blob;
+  extent=length-available;
+  if (reader->extent != 0)
+    {
+      /*
+        Read ahead, but never past the end of the blob so the end-of-file
+        state only changes when a caller asks for bytes that are not there.
+      */
+      extent=reader->extent;
+      if (available != 0)
+        extent=sizeof(reader->buffer)-available;
+      size=blob_info->size;
+      if (blob_info->type == BlobStream)
+        size=(MagickSizeType) blob_info->length;
+      offset=TellBlob(reader->image);
+      extent=(size_t) MagickMin((MagickSizeType) extent,(offset < 0) ||
+        ((MagickSizeType) offset >= size) ? 0 : size-(MagickSizeType) offset);
+      extent=MagickMax(extent,length-available);
+    }
+  if ((available == 0) && (blob_info->type == BlobStream))
+    {
+      reader->p=(const unsigned char *) ReadBlobStream(reader->image,extent,
+        reader->buffer,&count);
+      reader->q=reader->p+MagickMax(count,0);
+      return((size_t) (reader->q-reader->p));
+    }
+  if (available != 0)
+    (void) memmove(reader->buffer,reader->p,available);
+  reader->p=reader->buffer;
+  reader->q=reader->buffer+available;
+  count=ReadBlob(reader->image,extent,reader->buffer+available);
+  if (count > 0)
+    reader->q+=count;
+  return((size_t) (reader->q-reader->p));
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
 +   G e t B l o b E r r o r                                                   %
 %                                                                             %
 %                                                                             %
@@ -1898,6 +1991,62 @@ MagickExport const struct stat *GetBlobProperties(const Image *image)
 %                                                                             %
 %                                                                             %
 %                                                                             %
++   G e t B l o b R e a d e r                                                 %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  GetBlobReader() initializes a buffered reader at the current offset of the
+%  image blob.  The inline ReadBlobReader*() methods consume bytes from the
+%  reader and only call back into the blob when it is exhausted.  Seekable
+%  streams are read ahead; call SyncBlobReader() before using any other blob
+%  method so the unread bytes are returned to the blob.
+%
+%  The format of the GetBlobReader method is:
+%
+%      void GetBlobReader(Image *image,BlobReader *reader)
+%
+%  A description of each parameter follows:
+%
+%    o image: the image.
+%
+%    o reader: Specifies a pointer to a BlobReader structure.
+%
+*/
+MagickExport void GetBlobReader(Image *image,BlobReader *reader)
+{
+  assert(image != (Image *) NULL);
+  assert(image->signature == MagickCoreSignature);
+  assert(image->blob != (BlobInfo *) NULL);
+  assert(reader != (BlobReader *) NULL);
+  reader->image=image;
+  reader->p=reader->buffer;
+  reader->q=reader->buffer;
+  reader->extent=0;
+  switch (image->blob->type)
+  {
+    case BlobStream:
+    {
+      reader->extent=MagickMaxBufferExtent;
+      break;
+    }
+    case FileStream:
+    {
+      if ((image->blob->size != 0) && (IsBlobSeekable(image) != MagickFalse))
+        reader->extent=sizeof(reader->buffer);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
 +  G e t B l o b S i z e                                                      %
 %                                                                             %
 %                                                                             %
@@ -3284,6 +3433,39 @@ static inline MagickBooleanType SetStreamBuffering(const ImageInfo *image_info,
   return(status == 0 ? MagickTrue : MagickFalse);
 }
 
+static inline void SetStreamReadAhead(BlobInfo *blob_info,
+  const MagickOffsetType offset)
+{
+#if defined(MAGICKCORE_HAVE_POSIX_FADVISE)
+  int
+    file;
+
+  /*
+    Ask the kernel to fetch the next window of a regular file asynchronously
+    so reads are served from the page cache rather than blocking on the disk.
+  */
+  if ((blob_info->type != FileStream) ||
+      ((blob_info->mode != ReadBlobMode) &&
+       (blob_info->mode != ReadBinaryBlobMode)) ||
+      (S_ISREG(blob_info->properties.st_mode) == 0) ||
+      (offset < 0) || (offset >= (MagickOffsetType)
+       blob_info->properties.st_size))
+    return;
+  if ((offset > 0) && (offset >= blob_info->read_ahead) &&
+      (offset < (blob_info->read_ahead+(MagickReadAheadExtent >> 1))))
+    return;
+  file=fileno(blob_info->file_info.file);
+  if (offset == 0)
+    (void) posix_fadvise(file,0,0,POSIX_FADV_SEQUENTIAL);
+  blob_info->read_ahead=offset;
+  (void) posix_fadvise(file,(off_t) offset,(off_t) MagickReadAheadExtent,
+    POSIX_FADV_WILLNEED);
+#else
+  magick_unreferenced(blob_info);
+  magick_unreferenced(offset);
+#endif
+}
+
 #if defined(MAGICKCORE_ZLIB_DELEGATE)
 static inline gzFile gzopen_utf8(const char *path,const char *mode)
 {
@@ -3572,6 +3754,7 @@ MagickExport MagickBooleanType OpenBlob(const ImageInfo *image_info,
 
             blob_info->type=FileStream;
             (void) SetStreamBuffering(image_info,blob_info);
+            SetStreamReadAhead(blob_info,0);
             (void) memset(magick,0,sizeof(magick));
             count=fread(magick,1,sizeof(magick),blob_info->file_info.file);
             (void) fseek(blob_info->file_info.file,-((off_t) count),SEEK_CUR);
@@ -3937,7 +4120,7 @@ MagickExport ssize_t ReadBlob(Image *image,const size_t length,void *data)
         }
         case 4:
         {
-          c=getc(blob_info->file_info.file);
+          c=ReadBlobStreamByte(blob_info->file_info.file);
           if (c == EOF)
             break;
           *q++=(unsigned char) c;
@@ -3946,7 +4129,7 @@ MagickExport ssize_t ReadBlob(Image *image,const size_t length,void *data)
         }
         case 3:
         {
-          c=getc(blob_info->file_info.file);
+          c=ReadBlobStreamByte(blob_info->file_info.file);
           if (c == EOF)
             break;
           *q++=(unsigned char) c;
@@ -3955,7 +4138,7 @@ MagickExport ssize_t ReadBlob(Image *image,const size_t length,void *data)
         }
         case 2:
         {
-          c=getc(blob_info->file_info.file);
+          c=ReadBlobStreamByte(blob_info->file_info.file);
           if (c == EOF)
             break;
           *q++=(unsigned char) c;
@@ -3964,7 +4147,7 @@ MagickExport ssize_t ReadBlob(Image *image,const size_t length,void *data)
         }
         case 1:
         {
-          c=getc(blob_info->file_info.file);
+          c=ReadBlobStreamByte(blob_info->file_info.file);
           if (c == EOF)
             break;
           *q++=(unsigned char) c;
@@ -4155,7 +4338,7 @@ MagickExport int ReadBlobByte(Image *image)
     case FileStream:
     case PipeStream:
     {
-      c=getc(blob_info->file_info.file);
+      c=ReadBlobStreamByte(blob_info->file_info.file);
       if (c == EOF)
         {
           if (ferror(blob_info->file_info.file) != 0)
@@ -5198,6 +5381,7 @@ MagickExport MagickOffsetType SeekBlob(Image *image,
       if (fseek(blob_info->file_info.file,offset,whence) < 0)
         return(-1);
       blob_info->offset=TellBlob(image);
+      SetStreamReadAhead(blob_info,blob_info->offset);
       break;
     }
     case ZipStream:
@@ -5698,6 +5882,40 @@ static int SyncBlob(const Image *image)
 %                                                                             %
 %                                                                             %
 %                                                                             %
++  S y n c B l o b R e a d e r                                                %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  SyncBlobReader() returns any bytes read ahead but not consumed to the blob
+%  so its offset matches the bytes consumed through the reader.
+%
+%  The format of the SyncBlobReader method is:
+%
+%      void SyncBlobReader(BlobReader *reader)
+%
+%  A description of each parameter follows:
+%
+%    o reader: the blob reader.
+%
+*/
+MagickExport void SyncBlobReader(BlobReader *reader)
+{
+  assert(reader != (BlobReader *) NULL);
+  assert(reader->image != (Image *) NULL);
+  if (reader->q != reader->p)
+    (void) SeekBlob(reader->image,-(MagickOffsetType) (reader->q-reader->p),
+      SEEK_CUR);
+  reader->p=reader->buffer;
+  reader->q=reader->buffer;
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
 +  T e l l B l o b                                                            %
 %                                                                             %
 %                                                                             %
@@ -273,6 +273,10 @@ extern MagickPrivate MagickBooleanType
     ExceptionInfo *) magick_hot_spot,
   SyncImagePixelCache(Image *,ExceptionInfo *);
 
+extern MagickPrivate MagickOffsetType
+  SendPixelCacheRegion(const Image *,const RectangleInfo *,
+    const MagickBooleanType,const int);
+
 extern MagickPrivate MagickSizeType
   GetPixelCacheNexusExtent(const Cache,NexusInfo *magick_restrict);
 
@@ -3824,8 +3824,14 @@ static MagickBooleanType OpenPixelCache(Image *image,const MapMode mode,
         image->filename);
     }
   cache_info->length=length;
-  if (image->ping != MagickFalse)
+  if ((image->ping != MagickFalse) ||
+      (cache_info->methods.queue_authentic_pixels_handler !=
+       (QueueAuthenticPixelsHandler) NULL))
     {
+      /*
+        Pinged images have no pixels and streamed pixels are handed to the
+        stream handler a row at a time, so neither needs a pixel repository.
+      */
       cache_info->type=PingCache;
       return(MagickTrue);
     }
@@ -4632,32 +4638,13 @@ static MagickBooleanType ReadPixelCacheMetacontent(
     }
     case DistributedCache:
     {
-      RectangleInfo
-        region;
-
       /*
         Read metacontent from distributed cache.
       */
-      LockSemaphoreInfo(cache_info->file_semaphore);
-      region=nexus_info->region;
-      if ((cache_info->columns != nexus_info->region.width) ||
-          (extent > MagickMaxBufferExtent))
-        region.height=1UL;
-      else
-        {
-          length=extent;
-          rows=1UL;
-        }
-      for (y=0; y < (ssize_t) rows; y++)
-      {
-        count=ReadDistributePixelCacheMetacontent((DistributeCacheInfo *)
-          cache_info->server_info,&region,length,(unsigned char *) q);
-        if (count != (MagickOffsetType) length)
-          break;
-        q+=(ptrdiff_t) cache_info->metacontent_extent*nexus_info->region.width;
-        region.y++;
-      }
-      UnlockSemaphoreInfo(cache_info->file_semaphore);
+      count=ReadDistributePixelCacheMetacontent((DistributeCacheInfo *)
+        cache_info->server_info,&nexus_info->region,extent,(unsigned char *) q);
+      if (count == (MagickOffsetType) extent)
+        y=(ssize_t) rows;
       break;
     }
     default:
@@ -4810,32 +4797,13 @@ static MagickBooleanType ReadPixelCachePixels(
     }
     case DistributedCache:
     {
-      RectangleInfo
-        region;
-
       /*
         Read pixels from distributed cache.
       */
-      LockSemaphoreInfo(cache_info->file_semaphore);
-      region=nexus_info->region;
-      if ((cache_info->columns != nexus_info->region.width) ||
-          (extent > MagickMaxBufferExtent))
-        region.height=1UL;
-      else
-        {
-          length=extent;
-          rows=1UL;
-        }
-      for (y=0; y < (ssize_t) rows; y++)
-      {
-        count=ReadDistributePixelCachePixels((DistributeCacheInfo *)
-          cache_info->server_info,&region,length,(unsigned char *) q);
-        if (count != (MagickOffsetType) length)
-          break;
-        q+=(ptrdiff_t) cache_info->number_channels*nexus_info->region.width;
-        region.y++;
-      }
-      UnlockSemaphoreInfo(cache_info->file_semaphore);
+      count=ReadDistributePixelCachePixels((DistributeCacheInfo *)
+        cache_info->server_info,&nexus_info->region,extent,(unsigned char *) q);
+      if (count == (MagickOffsetType) extent)
+        y=(ssize_t) rows;
       break;
     }
     default:
@@ -5011,6 +4979,135 @@ MagickExport MagickBooleanType ReshapePixelCache(Image *image,
 %                                                                             %
 %                                                                             %
 %                                                                             %
++   S e n d P i x e l C a c h e R e g i o n                                   %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  SendPixelCacheRegion() copies the pixels or metacontent of a region of a
+%  disk-based pixel cache directly to a file descriptor, typically a socket,
+%  without staging them in user memory.  It returns the number of bytes sent,
+%  or -1 if the pixel cache is not on disk or the region is not wholly
+%  within the image, in which case nothing was sent.
+%
+%  The format of the SendPixelCacheRegion() method is:
+%
+%      MagickOffsetType SendPixelCacheRegion(const Image *image,
+%        const RectangleInfo *region,const MagickBooleanType metacontent,
+%        const int file)
+%
+%  A description of each parameter follows:
+%
+%    o image: the image.
+%
+%    o region: send this region of the pixel cache.
+%
+%    o metacontent: send the metacontent rather than the pixels.
+%
+%    o file: the destination file descriptor.
+%
+*/
+MagickPrivate MagickOffsetType SendPixelCacheRegion(const Image *image,
+  const RectangleInfo *region,const MagickBooleanType metacontent,
+  const int file)
+{
+#if defined(MAGICKCORE_HAVE_LINUX_SENDFILE)
+  CacheInfo
+    *magick_restrict cache_info;
+
+  MagickOffsetType
+    count,
+    extent,
+    i,
+    offset;
+
+  MagickSizeType
+    length;
+
+  size_t
+    quantum,
+    rows;
+
+  ssize_t
+    y;
+
+  assert(image != (const Image *) NULL);
+  assert(image->signature == MagickCoreSignature);
+  assert(image->cache != (Cache) NULL);
+  cache_info=(CacheInfo *) image->cache;
+  if ((cache_info->type != DiskCache) || (region->x < 0) || (region->y < 0) ||
+      ((region->x+(ssize_t) region->width) > (ssize_t) cache_info->columns) ||
+      ((region->y+(ssize_t) region->height) > (ssize_t) cache_info->rows))
+    return(-1);
+  quantum=cache_info->number_channels*sizeof(Quantum);
+  offset=cache_info->offset;
+  if (metacontent != MagickFalse)
+    {
+      quantum=cache_info->metacontent_extent;
+      offset+=(MagickOffsetType) cache_info->columns*(MagickOffsetType)
+        cache_info->rows*(MagickOffsetType) cache_info->number_channels*
+        (MagickOffsetType) sizeof(Quantum);
+    }
+  if (quantum == 0)
+    return(-1);
+  length=(MagickSizeType) region->width*quantum;
+  rows=region->height;
+  if (cache_info->columns == region->width)
+    {
+      length*=rows;
+      rows=1UL;
+    }
+  offset+=((MagickOffsetType) region->y*(MagickOffsetType) cache_info->columns+
+    region->x)*(MagickOffsetType) quantum;
+  LockSemaphoreInfo(cache_info->file_semaphore);
+  if (OpenPixelCacheOnDisk(cache_info,IOMode) == MagickFalse)
+    {
+      UnlockSemaphoreInfo(cache_info->file_semaphore);
+      return(-1);
+    }
+  extent=0;
+  for (y=0; y < (ssize_t) rows; y++)
+  {
+    off_t
+      position;
+
+    position=(off_t) offset;
+    count=0;
+    for (i=0; i < (MagickOffsetType) length; i+=count)
+    {
+      count=(MagickOffsetType) sendfile(file,cache_info->file,&position,
+        (size_t) MagickMin(length-(MagickSizeType) i,0x7ffff000));
+      if (count <= 0)
+        {
+          count=0;
+          if (errno != EINTR)
+            break;
+        }
+    }
+    extent+=i;
+    if (i != (MagickOffsetType) length)
+      break;
+    offset+=(MagickOffsetType) cache_info->columns*(MagickOffsetType) quantum;
+  }
+  if (IsFileDescriptorLimitExceeded() != MagickFalse)
+    (void) ClosePixelCacheOnDisk(cache_info);
+  UnlockSemaphoreInfo(cache_info->file_semaphore);
+  return(extent);
+#else
+  magick_unreferenced(image);
+  magick_unreferenced(region);
+  magick_unreferenced(metacontent);
+  magick_unreferenced(file);
+  return(-1);
+#endif
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
 +   S e t P i x e l C a c h e M e t h o d s                                   %
 %                                                                             %
 %                                                                             %
@@ -5813,32 +5910,13 @@ static MagickBooleanType WritePixelCacheMetacontent(CacheInfo *cache_info,
     }
     case DistributedCache:
     {
-      RectangleInfo
-        region;
-
       /*
         Write metacontent to distributed cache.
       */
-      LockSemaphoreInfo(cache_info->file_semaphore);
-      region=nexus_info->region;
-      if ((cache_info->columns != nexus_info->region.width) ||
-          (extent > MagickMaxBufferExtent))
-        region.height=1UL;
-      else
-        {
-          length=extent;
-          rows=1UL;
-        }
-      for (y=0; y < (ssize_t) rows; y++)
-      {
-        count=WriteDistributePixelCacheMetacontent((DistributeCacheInfo *)
-          cache_info->server_info,&region,length,(const unsigned char *) p);
-        if (count != (MagickOffsetType) length)
-          break;
-        p+=(ptrdiff_t) cache_info->metacontent_extent*nexus_info->region.width;
-        region.y++;
-      }
-      UnlockSemaphoreInfo(cache_info->file_semaphore);
+      count=WriteDistributePixelCacheMetacontent((DistributeCacheInfo *)
+        cache_info->server_info,&nexus_info->region,extent,(const unsigned char *) p);
+      if (count == (MagickOffsetType) extent)
+        y=(ssize_t) rows;
       break;
     }
     default:
@@ -5983,32 +6061,13 @@ static MagickBooleanType WritePixelCachePixels(
     }
     case DistributedCache:
     {
-      RectangleInfo
-        region;
-
       /*
         Write pixels to distributed cache.
       */
-      LockSemaphoreInfo(cache_info->file_semaphore);
-      region=nexus_info->region;
-      if ((cache_info->columns != nexus_info->region.width) ||
-          (extent > MagickMaxBufferExtent))
-        region.height=1UL;
-      else
-        {
-          length=extent;
-          rows=1UL;
-        }
-      for (y=0; y < (ssize_t) rows; y++)
-      {
-        count=WriteDistributePixelCachePixels((DistributeCacheInfo *)
-          cache_info->server_info,&region,length,(const unsigned char *) p);
-        if (count != (MagickOffsetType) length)
-          break;
-        p+=(ptrdiff_t) cache_info->number_channels*nexus_info->region.width;
-        region.y++;
-      }
-      UnlockSemaphoreInfo(cache_info->file_semaphore);
+      count=WriteDistributePixelCachePixels((DistributeCacheInfo *)
+        cache_info->server_info,&nexus_info->region,extent,(const unsigned char *) p);
+      if (count == (MagickOffsetType) extent)
+        y=(ssize_t) rows;
       break;
     }
     default:
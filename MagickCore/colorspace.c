@@ -78,6 +78,14 @@
 /*
   Typedef declarations.
 */
+typedef struct _ColorspaceMapInfo
+{
+  double
+    *decode,
+    *encode,
+    *root;
+} ColorspaceMapInfo;
+
 typedef struct _TransformPacket
 {
   MagickRealType
@@ -724,6 +732,309 @@ MagickExport ColorspaceType GetImageColorspaceType(const Image *image,
 %   o exception: return any errors or warnings in this structure.
 %
 */
+static ColorspaceMapInfo *DestroyColorspaceMapInfo(ColorspaceMapInfo *map_info)
+{
+  if (map_info->decode != (double *) NULL)
+    map_info->decode=(double *) RelinquishMagickMemory(map_info->decode);
+  if (map_info->encode != (double *) NULL)
+    map_info->encode=(double *) RelinquishMagickMemory(map_info->encode);
+  if (map_info->root != (double *) NULL)
+    map_info->root=(double *) RelinquishMagickMemory(map_info->root);
+  return((ColorspaceMapInfo *) RelinquishMagickMemory(map_info));
+}
+
+static double *AcquireColorspaceMap(
+  MagickRealType (*transfer)(const MagickRealType))
+{
+  double
+    *map;
+
+  ssize_t
+    i;
+
+  /*
+    Sample the transfer function at MaxMap+1 evenly spaced quantum values,
+    which are the quantum values themselves for 8 and 16-bit integer quanta.
+  */
+  map=(double *) AcquireQuantumMemory((size_t) MaxMap+2UL,sizeof(*map));
+  if (map == (double *) NULL)
+    return((double *) NULL);
+  for (i=0; i <= (ssize_t) MaxMap; i++)
+    map[i]=(double) transfer((MagickRealType) ((double) QuantumRange*
+      (double) i/(double) MaxMap));
+  map[MaxMap+1]=map[MaxMap];
+  return(map);
+}
+
+static ColorspaceMapInfo *AcquireColorspaceMapInfo(const Image *image,
+  const ColorspaceType colorspace,const MagickBooleanType inverse)
+{
+  ColorspaceMapInfo
+    *map_info;
+
+  const char
+    *artifact;
+
+  ssize_t
+    i;
+
+  artifact=GetImageArtifact(image,"colorspace:precision");
+  if ((artifact == (const char *) NULL) ||
+      (LocaleCompare(artifact,"fast") != 0))
+    return((ColorspaceMapInfo *) NULL);
+  switch (colorspace)
+  {
+    case LabColorspace:
+    case LCHColorspace:
+    case LCHabColorspace:
+    case LCHuvColorspace:
+    case LinearGRAYColorspace:
+    case LuvColorspace:
+    case RGBColorspace:
+    case scRGBColorspace:
+    case XYZColorspace:
+      break;
+    default:
+      return((ColorspaceMapInfo *) NULL);
+  }
+  if (((MagickSizeType) image->columns*image->rows) < (MagickSizeType) MaxMap)
+    return((ColorspaceMapInfo *) NULL);
+  map_info=(ColorspaceMapInfo *) AcquireMagickMemory(sizeof(*map_info));
+  if (map_info == (ColorspaceMapInfo *) NULL)
+    return((ColorspaceMapInfo *) NULL);
+  (void) memset(map_info,0,sizeof(*map_info));
+  if (inverse != MagickFalse)
+    {
+      map_info->encode=AcquireColorspaceMap(EncodePixelGamma);
+      if (map_info->encode == (double *) NULL)
+        return(DestroyColorspaceMapInfo(map_info));
+      return(map_info);
+    }
+  map_info->decode=AcquireColorspaceMap(DecodePixelGamma);
+  map_info->root=(double *) AcquireQuantumMemory((size_t) MaxMap+2UL,
+    sizeof(*map_info->root));
+  if ((map_info->decode == (double *) NULL) ||
+      (map_info->root == (double *) NULL))
+    return(DestroyColorspaceMapInfo(map_info));
+  for (i=0; i <= (ssize_t) MaxMap; i++)
+  {
+    double
+      t;
+
+    /*
+      The CIE L*a*b* companding function f(t) over [0,1].
+    */
+    t=(double) i/(double) MaxMap;
+    if (t > CIEEpsilon)
+      map_info->root[i]=pow(t,1.0/3.0);
+    else
+      map_info->root[i]=(CIEK*t+16.0)/116.0;
+  }
+  map_info->root[MaxMap+1]=map_info->root[MaxMap];
+  return(map_info);
+}
+
+static inline double InterpolateColorspaceMap(const double *magick_restrict map,
+  const double offset)
+{
+  ssize_t
+    i;
+
+  i=(ssize_t) offset;
+  return(map[i]+(offset-(double) i)*(map[i+1]-map[i]));
+}
+
+static inline double DecodeMapPixel(const ColorspaceMapInfo *map_info,
+  const double pixel)
+{
+  if ((pixel >= 0.0) && (pixel <= (double) QuantumRange))
+    return(InterpolateColorspaceMap(map_info->decode,(double) MaxMap*pixel/
+      (double) QuantumRange));
+  return((double) DecodePixelGamma((MagickRealType) pixel));
+}
+
+static inline double EncodeMapPixel(const ColorspaceMapInfo *map_info,
+  const double pixel)
+{
+  if ((pixel >= 0.0) && (pixel <= (double) QuantumRange))
+    return(InterpolateColorspaceMap(map_info->encode,(double) MaxMap*pixel/
+      (double) QuantumRange));
+  return((double) EncodePixelGamma((MagickRealType) pixel));
+}
+
+static inline double RootMapPixel(const ColorspaceMapInfo *map_info,
+  const double t)
+{
+  if ((t >= 0.0) && (t <= 1.0))
+    return(InterpolateColorspaceMap(map_info->root,(double) MaxMap*t));
+  if (t > CIEEpsilon)
+    return(pow(t,1.0/3.0));
+  return((CIEK*t+16.0)/116.0);
+}
+
+static inline void ConvertRGBToXYZMap(const ColorspaceMapInfo *map_info,
+  const double red,const double green,const double blue,double *X,double *Y,
+  double *Z)
+{
+  double
+    b,
+    g,
+    r;
+
+  r=QuantumScale*DecodeMapPixel(map_info,red);
+  g=QuantumScale*DecodeMapPixel(map_info,green);
+  b=QuantumScale*DecodeMapPixel(map_info,blue);
+  *X=(0.4123955889674142161*r)+(0.3575834307637148171*g)+
+    (0.1804926473817015735*b);
+  *Y=(0.2125862307855955516*r)+(0.7151703037034108499*g)+
+    (0.07220049864333622685*b);
+  *Z=(0.01929721549174694484*r)+(0.1191838645808485318*g)+
+    (0.9504971251315797660*b);
+}
+
+static inline void ConvertXYZToRGBMap(const ColorspaceMapInfo *map_info,
+  const double X,const double Y,const double Z,double *red,double *green,
+  double *blue)
+{
+  double
+    b,
+    g,
+    min,
+    r;
+
+  r=(3.240969941904521*X)+(-1.537383177570093*Y)+(-0.498610760293*Z);
+  g=(-0.96924363628087*X)+(1.87596750150772*Y)+(0.041555057407175*Z);
+  b=(0.055630079696993*X)+(-0.20397695888897*Y)+(1.056971514242878*Z);
+  min=MagickMin(r,MagickMin(g,b));
+  if (min < 0.0)
+    {
+      r-=min;
+      g-=min;
+      b-=min;
+    }
+  *red=EncodeMapPixel(map_info,(double) QuantumRange*r);
+  *green=EncodeMapPixel(map_info,(double) QuantumRange*g);
+  *blue=EncodeMapPixel(map_info,(double) QuantumRange*b);
+}
+
+static void ConvertRGBToGenericMap(const ColorspaceMapInfo *map_info,
+  const ColorspaceType colorspace,const double R,const double G,const double B,
+  const double white_luminance,const IlluminantType illuminant,double *X,
+  double *Y,double *Z)
+{
+  double
+    x,
+    y,
+    z;
+
+  ConvertRGBToXYZMap(map_info,R,G,B,&x,&y,&z);
+  switch (colorspace)
+  {
+    case LabColorspace:
+    case LCHColorspace:
+    case LCHabColorspace:
+    {
+      double
+        a,
+        b,
+        fx,
+        fy,
+        fz;
+
+      fx=RootMapPixel(map_info,x/illuminant_tristimulus[illuminant].x);
+      fy=RootMapPixel(map_info,y/illuminant_tristimulus[illuminant].y);
+      fz=RootMapPixel(map_info,z/illuminant_tristimulus[illuminant].z);
+      *X=((116.0*fy)-16.0)/100.0;
+      a=(500.0*(fx-fy))/255.0+0.5;
+      b=(200.0*(fy-fz))/255.0+0.5;
+      if (colorspace == LabColorspace)
+        {
+          *Y=a;
+          *Z=b;
+          break;
+        }
+      *Y=hypot(a-0.5,b-0.5)/1.0+0.5;
+      *Z=180.0*atan2(b-0.5,a-0.5)/MagickPI/360.0;
+      if (*Z < 0.0)
+        *Z+=1.0;
+      break;
+    }
+    case LCHuvColorspace:
+    {
+      ConvertXYZToLCHuv(x,y,z,illuminant,X,Y,Z);
+      break;
+    }
+    case LuvColorspace:
+    {
+      ConvertXYZToLuv(x,y,z,illuminant,X,Y,Z);
+      break;
+    }
+    case XYZColorspace:
+    {
+      *X=x;
+      *Y=y;
+      *Z=z;
+      break;
+    }
+    default:
+    {
+      ConvertRGBToGeneric(colorspace,R,G,B,white_luminance,illuminant,X,Y,Z);
+      break;
+    }
+  }
+}
+
+static void ConvertGenericToRGBMap(const ColorspaceMapInfo *map_info,
+  const ColorspaceType colorspace,const double X,const double Y,const double Z,
+  const double white_luminance,const IlluminantType illuminant,double *R,
+  double *G,double *B)
+{
+  double
+    x,
+    y,
+    z;
+
+  switch (colorspace)
+  {
+    case LabColorspace:
+    {
+      ConvertLabToXYZ(100.0*X,255.0*(Y-0.5),255.0*(Z-0.5),illuminant,&x,&y,&z);
+      break;
+    }
+    case LCHColorspace:
+    case LCHabColorspace:
+    {
+      ConvertLCHabToXYZ(100.0*X,255.0*(Y-0.5),360.0*Z,illuminant,&x,&y,&z);
+      break;
+    }
+    case LCHuvColorspace:
+    {
+      ConvertLCHuvToXYZ(100.0*X,255.0*(Y-0.5),360.0*Z,illuminant,&x,&y,&z);
+      break;
+    }
+    case LuvColorspace:
+    {
+      ConvertLuvToXYZ(100.0*X,354.0*Y-134.0,262.0*Z-140.0,illuminant,&x,&y,
+        &z);
+      break;
+    }
+    case XYZColorspace:
+    {
+      x=X;
+      y=Y;
+      z=Z;
+      break;
+    }
+    default:
+    {
+      ConvertGenericToRGB(colorspace,X,Y,Z,white_luminance,illuminant,R,G,B);
+      return;
+    }
+  }
+  ConvertXYZToRGBMap(map_info,x,y,z,R,G,B);
+}
+
+
 static MagickBooleanType sRGBTransformImage(Image *image,
   const ColorspaceType colorspace,ExceptionInfo *exception)
 {
@@ -732,6 +1043,9 @@ static MagickBooleanType sRGBTransformImage(Image *image,
   CacheView
     *image_view;
 
+  ColorspaceMapInfo
+    *map_info;
+
   const char
     *artifact;
 
@@ -857,6 +1171,7 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           if (SetImageStorageClass(image,DirectClass,exception) == MagickFalse)
             return(MagickFalse);
         }
+      map_info=AcquireColorspaceMapInfo(image,colorspace,MagickFalse);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -887,9 +1202,15 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           MagickRealType
             gray;
 
-          gray=0.212656*DecodePixelGamma(GetPixelRed(image,q))+0.715158*
-            DecodePixelGamma(GetPixelGreen(image,q))+0.072186*
-            DecodePixelGamma(GetPixelBlue(image,q));
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            gray=0.212656*DecodeMapPixel(map_info,(double)
+              GetPixelRed(image,q))+0.715158*DecodeMapPixel(map_info,(double)
+              GetPixelGreen(image,q))+0.072186*DecodeMapPixel(map_info,(double)
+              GetPixelBlue(image,q));
+          else
+            gray=0.212656*DecodePixelGamma(GetPixelRed(image,q))+0.715158*
+              DecodePixelGamma(GetPixelGreen(image,q))+0.072186*
+              DecodePixelGamma(GetPixelBlue(image,q));
           SetPixelGray(image,ClampToQuantum(gray),q);
           q+=(ptrdiff_t) GetPixelChannels(image);
         }
@@ -898,6 +1219,8 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,colorspace,exception) == MagickFalse)
         return(MagickFalse);
       image->type=GrayscaleType;
@@ -1008,6 +1331,7 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           if (SetImageStorageClass(image,DirectClass,exception) == MagickFalse)
             return(MagickFalse);
         }
+      map_info=AcquireColorspaceMapInfo(image,colorspace,MagickFalse);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -1040,9 +1364,14 @@ static MagickBooleanType sRGBTransformImage(Image *image,
             Y,
             Z;
 
-          ConvertRGBToGeneric(colorspace,(double) GetPixelRed(image,q),
-            (double) GetPixelGreen(image,q),(double) GetPixelBlue(image,q),
-            white_luminance,illuminant,&X,&Y,&Z);
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            ConvertRGBToGenericMap(map_info,colorspace,(double)
+              GetPixelRed(image,q),(double) GetPixelGreen(image,q),(double)
+              GetPixelBlue(image,q),white_luminance,illuminant,&X,&Y,&Z);
+          else
+            ConvertRGBToGeneric(colorspace,(double) GetPixelRed(image,q),
+              (double) GetPixelGreen(image,q),(double) GetPixelBlue(image,q),
+              white_luminance,illuminant,&X,&Y,&Z);
           SetPixelRed(image,ClampToQuantum((double) QuantumRange*X),q);
           SetPixelGreen(image,ClampToQuantum((double) QuantumRange*Y),q);
           SetPixelBlue(image,ClampToQuantum((double) QuantumRange*Z),q);
@@ -1053,6 +1382,8 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,colorspace,exception) == MagickFalse)
         return(MagickFalse);
       return(status);
@@ -1179,6 +1510,7 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           if (SetImageStorageClass(image,DirectClass,exception) == MagickFalse)
             return(MagickFalse);
         }
+      map_info=AcquireColorspaceMapInfo(image,colorspace,MagickFalse);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -1211,9 +1543,18 @@ static MagickBooleanType sRGBTransformImage(Image *image,
             green,
             red;
 
-          red=DecodePixelGamma((MagickRealType) GetPixelRed(image,q));
-          green=DecodePixelGamma((MagickRealType) GetPixelGreen(image,q));
-          blue=DecodePixelGamma((MagickRealType) GetPixelBlue(image,q));
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            {
+              red=DecodeMapPixel(map_info,(double) GetPixelRed(image,q));
+              green=DecodeMapPixel(map_info,(double) GetPixelGreen(image,q));
+              blue=DecodeMapPixel(map_info,(double) GetPixelBlue(image,q));
+            }
+          else
+            {
+              red=DecodePixelGamma((MagickRealType) GetPixelRed(image,q));
+              green=DecodePixelGamma((MagickRealType) GetPixelGreen(image,q));
+              blue=DecodePixelGamma((MagickRealType) GetPixelBlue(image,q));
+            }
           SetPixelRed(image,ClampToQuantum(red),q);
           SetPixelGreen(image,ClampToQuantum(green),q);
           SetPixelBlue(image,ClampToQuantum(blue),q);
@@ -1224,6 +1565,8 @@ static MagickBooleanType sRGBTransformImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,colorspace,exception) == MagickFalse)
         return(MagickFalse);
       return(status);
@@ -2070,6 +2413,9 @@ static MagickBooleanType TransformsRGBImage(Image *image,
   CacheView
     *image_view;
 
+  ColorspaceMapInfo
+    *map_info;
+
   const char
     *artifact;
 
@@ -2187,6 +2533,8 @@ static MagickBooleanType TransformsRGBImage(Image *image,
         }
       if (SetImageColorspace(image,sRGBColorspace,exception) == MagickFalse)
         return(MagickFalse);
+      map_info=AcquireColorspaceMapInfo(image,LinearGRAYColorspace,
+        MagickTrue);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -2217,9 +2565,15 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           MagickRealType
             gray;
 
-          gray=0.212656*EncodePixelGamma(GetPixelRed(image,q))+0.715158*
-            EncodePixelGamma(GetPixelGreen(image,q))+0.072186*
-            EncodePixelGamma(GetPixelBlue(image,q));
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            gray=0.212656*EncodeMapPixel(map_info,(double)
+              GetPixelRed(image,q))+0.715158*EncodeMapPixel(map_info,(double)
+              GetPixelGreen(image,q))+0.072186*EncodeMapPixel(map_info,(double)
+              GetPixelBlue(image,q));
+          else
+            gray=0.212656*EncodePixelGamma(GetPixelRed(image,q))+0.715158*
+              EncodePixelGamma(GetPixelGreen(image,q))+0.072186*
+              EncodePixelGamma(GetPixelBlue(image,q));
           SetPixelRed(image,ClampToQuantum(gray),q);
           SetPixelGreen(image,ClampToQuantum(gray),q);
           SetPixelBlue(image,ClampToQuantum(gray),q);
@@ -2230,6 +2584,8 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,sRGBColorspace,exception) == MagickFalse)
         return(MagickFalse);
       return(status);
@@ -2343,6 +2699,7 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           if (SetImageStorageClass(image,DirectClass,exception) == MagickFalse)
             return(MagickFalse);
         }
+      map_info=AcquireColorspaceMapInfo(image,image->colorspace,MagickTrue);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -2375,10 +2732,16 @@ static MagickBooleanType TransformsRGBImage(Image *image,
             green,
             red;
 
-          ConvertGenericToRGB(image->colorspace,QuantumScale*
-            GetPixelRed(image,q),QuantumScale*GetPixelGreen(image,q),
-            QuantumScale*GetPixelBlue(image,q),white_luminance,illuminant,
-            &red,&green,&blue);
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            ConvertGenericToRGBMap(map_info,image->colorspace,QuantumScale*
+              GetPixelRed(image,q),QuantumScale*GetPixelGreen(image,q),
+              QuantumScale*GetPixelBlue(image,q),white_luminance,illuminant,
+              &red,&green,&blue);
+          else
+            ConvertGenericToRGB(image->colorspace,QuantumScale*
+              GetPixelRed(image,q),QuantumScale*GetPixelGreen(image,q),
+              QuantumScale*GetPixelBlue(image,q),white_luminance,illuminant,
+              &red,&green,&blue);
           SetPixelRed(image,ClampToQuantum(red),q);
           SetPixelGreen(image,ClampToQuantum(green),q);
           SetPixelBlue(image,ClampToQuantum(blue),q);
@@ -2389,6 +2752,8 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,sRGBColorspace,exception) == MagickFalse)
         return(MagickFalse);
       return(status);
@@ -2523,6 +2888,7 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           if (SetImageStorageClass(image,DirectClass,exception) == MagickFalse)
             return(MagickFalse);
         }
+      map_info=AcquireColorspaceMapInfo(image,image->colorspace,MagickTrue);
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
       #pragma omp parallel for schedule(static) shared(status) \
@@ -2555,9 +2921,18 @@ static MagickBooleanType TransformsRGBImage(Image *image,
             green,
             red;
 
-          red=EncodePixelGamma((MagickRealType) GetPixelRed(image,q));
-          green=EncodePixelGamma((MagickRealType) GetPixelGreen(image,q));
-          blue=EncodePixelGamma((MagickRealType) GetPixelBlue(image,q));
+          if (map_info != (ColorspaceMapInfo *) NULL)
+            {
+              red=EncodeMapPixel(map_info,(double) GetPixelRed(image,q));
+              green=EncodeMapPixel(map_info,(double) GetPixelGreen(image,q));
+              blue=EncodeMapPixel(map_info,(double) GetPixelBlue(image,q));
+            }
+          else
+            {
+              red=EncodePixelGamma((MagickRealType) GetPixelRed(image,q));
+              green=EncodePixelGamma((MagickRealType) GetPixelGreen(image,q));
+              blue=EncodePixelGamma((MagickRealType) GetPixelBlue(image,q));
+            }
           SetPixelRed(image,ClampToQuantum(red),q);
           SetPixelGreen(image,ClampToQuantum(green),q);
           SetPixelBlue(image,ClampToQuantum(blue),q);
@@ -2568,6 +2943,8 @@ static MagickBooleanType TransformsRGBImage(Image *image,
           status=MagickFalse;
       }
       image_view=DestroyCacheView(image_view);
+      if (map_info != (ColorspaceMapInfo *) NULL)
+        map_info=DestroyColorspaceMapInfo(map_info);
       if (SetImageColorspace(image,sRGBColorspace,exception) == MagickFalse)
         return(MagickFalse);
       return(status);
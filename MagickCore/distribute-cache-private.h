@@ -18,8 +18,10 @@
 #ifndef MAGICKCORE_DISTRIBUTE_CACHE_PRIVATE_H
 #define MAGICKCORE_DISTRIBUTE_CACHE_PRIVATE_H
 
+#include "MagickCore/compress.h"
 #include "MagickCore/geometry.h"
 #include "MagickCore/exception.h"
+#include "MagickCore/semaphore.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
@@ -31,7 +33,11 @@ typedef struct _DistributeCacheInfo
     file;
 
   size_t
-    session_key;
+    session_key,
+    version;
+
+  CompressionType
+    compression;
 
   char
     hostname[MagickPathExtent];
@@ -39,6 +45,33 @@ typedef struct _DistributeCacheInfo
   int
     port;
 
+  size_t
+    columns,
+    rows;
+
+  ssize_t
+    first_row;
+
+  size_t
+    number_shards;
+
+  struct _DistributeCacheInfo
+    **shards;
+
+  SemaphoreInfo
+    *semaphore;
+
+  RectangleInfo
+    last_region,
+    prefetch_region;
+
+  MagickSizeType
+    prefetch_extent;
+
+  size_t
+    prefetch_requests,
+    prefetch_window;
+
   MagickBooleanType
     debug;
 
@@ -54,6 +54,7 @@
 #include "MagickCore/studio.h"
 #include "MagickCore/cache.h"
 #include "MagickCore/cache-private.h"
+#include "MagickCore/compress.h"
 #include "MagickCore/distribute-cache.h"
 #include "MagickCore/distribute-cache-private.h"
 #include "MagickCore/exception.h"
@@ -64,6 +65,7 @@
 #include "MagickCore/list.h"
 #include "MagickCore/locale_.h"
 #include "MagickCore/memory_.h"
+#include "MagickCore/option.h"
 #include "MagickCore/nt-base-private.h"
 #include "MagickCore/pixel.h"
 #include "MagickCore/policy.h"
@@ -80,6 +82,7 @@
 #if defined(MAGICKCORE_DPC_SUPPORT)
 #if defined(MAGICKCORE_HAVE_SOCKET) && defined(MAGICKCORE_THREAD_SUPPORT)
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -100,14 +103,21 @@
 #define MAGICKCORE_HAVE_WINSOCK2 1
 #endif
 #endif
+#if defined(MAGICKCORE_ZLIB_DELEGATE)
+#include "zlib.h"
+#endif
 
 /*
   Define declarations.
 */
+#define DPCBatchExtent  MagickMaxBufferExtent
 #define DPCHostname  "127.0.0.1"
+#define DPCMaximumRequests  8
 #define DPCPendingConnections  10
 #define DPCPort  6668
+#define DPCPrefetchExtent  65536
 #define DPCSessionKeyLength  8
+#define DPCVersion  3
 #ifndef MSG_NOSIGNAL
 #  define MSG_NOSIGNAL 0
 #endif
@@ -182,6 +192,152 @@ static inline MagickOffsetType dpc_read(SOCKET_TYPE file,const MagickSizeType le
 }
 #endif
 
+#if !defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
+static inline MagickOffsetType dpc_send(SOCKET_TYPE magick_unused(file),
+  const MagickSizeType magick_unused(length),
+  const void *magick_restrict magick_unused(message))
+{
+  magick_unreferenced(file);
+  magick_unreferenced(length);
+  magick_unreferenced(message);
+  return(-1);
+}
+#else
+static inline MagickOffsetType dpc_send(SOCKET_TYPE file,const MagickSizeType length,
+  const void *magick_restrict message)
+{
+  MagickOffsetType
+    i;
+
+  ssize_t
+    count;
+
+  /*
+    Ensure a complete message is sent.
+  */
+  count=0;
+  for (i=0; i < (MagickOffsetType) length; i+=count)
+  {
+    count=(ssize_t) send(file,(char *) message+i,(LENGTH_TYPE)
+      MagickMin(length-(MagickSizeType) i,(MagickSizeType) MagickMaxBufferExtent),
+      MSG_NOSIGNAL);
+    if (count <= 0)
+      {
+        count=0;
+        if (errno != EINTR)
+          break;
+      }
+  }
+  return(i);
+}
+#endif
+
+static MagickOffsetType ReceiveDistributeCachePayload(SOCKET_TYPE file,
+  const CompressionType compression,const MagickSizeType length,
+  unsigned char *magick_restrict data)
+{
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  /*
+    A compressed payload is prefixed with its size on the wire; a payload
+    that does not compress is sent as is and prefixed with its own length.
+  */
+  if (compression != ZipCompression)
+    return(dpc_read(file,length,data));
+  count=dpc_read(file,sizeof(extent),(unsigned char *) &extent);
+  if ((count != (MagickOffsetType) sizeof(extent)) || (extent > length))
+    return(-1);
+  if (extent == length)
+    return(dpc_read(file,length,data));
+#if defined(MAGICKCORE_ZLIB_DELEGATE)
+  {
+    int
+      status;
+
+    uLongf
+      size;
+
+    unsigned char
+      *buffer;
+
+    buffer=(unsigned char *) AcquireQuantumMemory((size_t) extent,
+      sizeof(*buffer));
+    if (buffer == (unsigned char *) NULL)
+      return(-1);
+    count=dpc_read(file,extent,buffer);
+    size=(uLongf) length;
+    status=Z_DATA_ERROR;
+    if (count == (MagickOffsetType) extent)
+      status=uncompress(data,&size,buffer,(uLong) extent);
+    buffer=(unsigned char *) RelinquishMagickMemory(buffer);
+    if ((status != Z_OK) || (size != (uLongf) length))
+      return(-1);
+    return((MagickOffsetType) length);
+  }
+#else
+  return(-1);
+#endif
+}
+
+static MagickOffsetType SendDistributeCachePayload(SOCKET_TYPE file,
+  const CompressionType compression,const MagickSizeType length,
+  const unsigned char *magick_restrict data)
+{
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  if (compression != ZipCompression)
+    return(dpc_send(file,length,data));
+#if defined(MAGICKCORE_ZLIB_DELEGATE)
+  if (length == (MagickSizeType) ((uLong) length))
+    {
+      int
+        status;
+
+      uLongf
+        size;
+
+      unsigned char
+        *buffer;
+
+      /*
+        Deflate at the fastest level, the network is the bottleneck.
+      */
+      size=compressBound((uLong) length);
+      buffer=(unsigned char *) AcquireQuantumMemory(sizeof(extent)+size,
+        sizeof(*buffer));
+      if (buffer != (unsigned char *) NULL)
+        {
+          status=compress2(buffer+sizeof(extent),&size,data,(uLong) length,
+            Z_BEST_SPEED);
+          if ((status == Z_OK) && ((MagickSizeType) size < length))
+            {
+              extent=(MagickSizeType) size;
+              (void) memcpy(buffer,&extent,sizeof(extent));
+              count=dpc_send(file,sizeof(extent)+extent,buffer);
+              buffer=(unsigned char *) RelinquishMagickMemory(buffer);
+              if (count != (MagickOffsetType) (sizeof(extent)+extent))
+                return(-1);
+              return((MagickOffsetType) length);
+            }
+          buffer=(unsigned char *) RelinquishMagickMemory(buffer);
+        }
+    }
+#endif
+  extent=length;
+  count=dpc_send(file,sizeof(extent),&extent);
+  if (count != (MagickOffsetType) sizeof(extent))
+    return(-1);
+  return(dpc_send(file,length,data));
+}
+
 #if defined(MAGICKCORE_HAVE_WINSOCK2)
 static void InitializeWinsock2(MagickBooleanType use_lock)
 {
@@ -202,6 +358,21 @@ static void InitializeWinsock2(MagickBooleanType use_lock)
 }
 #endif
 
+#if defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
+static void SetDistributeCacheSocketOptions(SOCKET_TYPE file)
+{
+  int
+    one;
+
+  /*
+    Requests and replies are small and latency bound, disable Nagle.
+  */
+  one=1;
+  (void) setsockopt(file,IPPROTO_TCP,TCP_NODELAY,(char *) &one,
+    (socklen_t) sizeof(one));
+}
+#endif
+
 #if !defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
 static int ConnectPixelCacheServer(const char *magick_unused(hostname),
   const int magick_unused(port),size_t *magick_unused(session_key),
@@ -275,6 +446,7 @@ static int ConnectPixelCacheServer(const char *hostname,const int port,
         "DistributedPixelCache","'%s': %s",hostname,GetExceptionMessage(errno));
       return(-1);
     }
+  SetDistributeCacheSocketOptions(client_socket);
   count=recv(client_socket,(char *) session_key,sizeof(*session_key),0);
   if (count == -1)
     {
@@ -308,12 +480,12 @@ static int ConnectPixelCacheServer(const char *hostname,const int port,
 }
 #endif
 
-static char *GetHostname(int *port,ExceptionInfo *exception)
+static char **GetHostList(size_t *number_hosts,ExceptionInfo *exception)
 {
   char
-    *host,
     *hosts,
-    **hostlist;
+    **hostlist,
+    **shardlist;
 
   int
     argc;
@@ -327,53 +499,182 @@ static char *GetHostname(int *port,ExceptionInfo *exception)
   /*
     Parse host list (e.g. 192.168.100.1:6668,192.168.100.2:6668).
   */
+  *number_hosts=0;
   hosts=(char *) GetImageRegistry(StringRegistryType,"cache:hosts",exception);
   if (hosts == (char *) NULL)
-    {
-      *port=DPCPort;
-      return(AcquireString(DPCHostname));
-    }
+    hosts=AcquireString(DPCHostname);
   (void) SubstituteString(&hosts,","," ");
   hostlist=StringToArgv(hosts,&argc);
   hosts=DestroyString(hosts);
   if (hostlist == (char **) NULL)
+    return((char **) NULL);
+  shardlist=(char **) NULL;
+  if (argc > 1)
+    shardlist=(char **) AcquireQuantumMemory((size_t) argc-1,
+      sizeof(*shardlist));
+  if (shardlist == (char **) NULL)
     {
-      *port=DPCPort;
-      return(AcquireString(DPCHostname));
+      for (i=0; i < (ssize_t) argc; i++)
+        hostlist[i]=DestroyString(hostlist[i]);
+      hostlist=(char **) RelinquishMagickMemory(hostlist);
+      return((char **) NULL);
     }
-  hosts=AcquireString(hostlist[(id++ % ((size_t) argc-1))+1]);
-  for (i=0; i < (ssize_t) argc; i++)
-    hostlist[i]=DestroyString(hostlist[i]);
+  /*
+    Rotate the list so the first shard of each image lands on the next host.
+  */
+  *number_hosts=(size_t) argc-1;
+  for (i=0; i < (ssize_t) *number_hosts; i++)
+    shardlist[i]=hostlist[((id+(size_t) i) % *number_hosts)+1];
+  id++;
+  hostlist[0]=DestroyString(hostlist[0]);
   hostlist=(char **) RelinquishMagickMemory(hostlist);
+  return(shardlist);
+}
+
+static char *GetHostname(const char *host,int *port)
+{
+  char
+    *hostname,
+    *hosts,
+    **hostlist;
+
+  int
+    argc;
+
+  ssize_t
+    i;
+
+  /*
+    Split host:port.
+  */
+  *port=DPCPort;
+  hosts=AcquireString(host);
   (void) SubstituteString(&hosts,":"," ");
   hostlist=StringToArgv(hosts,&argc);
+  hosts=DestroyString(hosts);
   if (hostlist == (char **) NULL)
-    {
-      *port=DPCPort;
-      return(AcquireString(DPCHostname));
-    }
-  host=AcquireString(hostlist[1]);
-  if (hostlist[2] == (char *) NULL)
-    *port=DPCPort;
-  else
+    return(AcquireString(DPCHostname));
+  hostname=AcquireString(argc > 1 ? hostlist[1] : DPCHostname);
+  if (argc > 2)
     *port=StringToLong(hostlist[2]);
   for (i=0; i < (ssize_t) argc; i++)
     hostlist[i]=DestroyString(hostlist[i]);
   hostlist=(char **) RelinquishMagickMemory(hostlist);
-  return(host);
+  return(hostname);
 }
 
-MagickPrivate DistributeCacheInfo *AcquireDistributeCacheInfo(
+static CompressionType GetDistributeCacheCompression(ExceptionInfo *exception)
+{
+  char
+    *value;
+
+  ssize_t
+    type;
+
+  /*
+    Wire compression is opt-in (e.g. -define registry:cache:compression=zip).
+  */
+  value=(char *) GetImageRegistry(StringRegistryType,"cache:compression",
+    exception);
+  if (value == (char *) NULL)
+    return(NoCompression);
+  type=ParseCommandOption(MagickCompressOptions,MagickFalse,value);
+  value=DestroyString(value);
+#if defined(MAGICKCORE_ZLIB_DELEGATE)
+  if (type == ZipCompression)
+    return(ZipCompression);
+#endif
+  return(NoCompression);
+}
+
+static size_t GetDistributeCacheVersion(const CompressionType compression,
   ExceptionInfo *exception)
 {
   char
-    *hostname;
+    *value;
+
+  size_t
+    version;
+
+  /*
+    The pipelined protocol is opt-in (e.g. -define registry:cache:protocol=2),
+    on a fast link the stop-and-wait protocol is as quick.  Wire compression
+    needs version 3.
+  */
+  version=1;
+  value=(char *) GetImageRegistry(StringRegistryType,"cache:protocol",
+    exception);
+  if (value != (char *) NULL)
+    {
+      version=(size_t) MagickMax(MagickMin(StringToLong(value),DPCVersion),1);
+      value=DestroyString(value);
+    }
+  if (compression != NoCompression)
+    version=DPCVersion;
+  return(version);
+}
+
+static size_t NegotiateDistributeCacheVersion(DistributeCacheInfo *server_info,
+  const size_t request,const CompressionType compression)
+{
+  MagickOffsetType
+    count;
+
+  size_t
+    version;
+
+  unsigned char
+    message[MagickPathExtent],
+    *p;
+
+  /*
+    Request the protocol version; servers that predate it drop the connection.
+  */
+  p=message;
+  *p++='v';
+  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
+  p+=(ptrdiff_t) sizeof(server_info->session_key);
+  version=request;
+  (void) memcpy(p,&version,sizeof(version));
+  p+=(ptrdiff_t) sizeof(version);
+  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
+  if (count != (MagickOffsetType) (p-message))
+    return(0);
+  version=0;
+  count=dpc_read(server_info->file,sizeof(version),(unsigned char *) &version);
+  if ((count != (MagickOffsetType) sizeof(version)) || (version < 2) ||
+      (version > request))
+    return(0);
+  if (version > 2)
+    {
+      /*
+        Request wire compression, the server answers with what it accepts.
+      */
+      count=dpc_send(server_info->file,sizeof(compression),&compression);
+      if (count != (MagickOffsetType) sizeof(compression))
+        return(0);
+      count=dpc_read(server_info->file,sizeof(server_info->compression),
+        (unsigned char *) &server_info->compression);
+      if ((count != (MagickOffsetType) sizeof(server_info->compression)) ||
+          ((server_info->compression != NoCompression) &&
+           (server_info->compression != compression)))
+        return(0);
+    }
+  return(version);
+}
+
+static DistributeCacheInfo *ConnectDistributeCache(const char *hostname,
+  const int port,ExceptionInfo *exception)
+{
+  CompressionType
+    compression;
 
   DistributeCacheInfo
     *server_info;
 
   size_t
-    session_key;
+    session_key,
+    version;
 
   /*
     Connect to the distributed pixel cache server.
@@ -382,21 +683,107 @@ MagickPrivate DistributeCacheInfo *AcquireDistributeCacheInfo(
     sizeof(*server_info));
   (void) memset(server_info,0,sizeof(*server_info));
   server_info->signature=MagickCoreSignature;
-  server_info->port=0;
-  hostname=GetHostname(&server_info->port,exception);
+  server_info->port=port;
+  server_info->compression=NoCompression;
+  server_info->version=1;
   session_key=0;
   server_info->file=ConnectPixelCacheServer(hostname,server_info->port,
     &session_key,exception);
+  compression=GetDistributeCacheCompression(exception);
+  version=GetDistributeCacheVersion(compression,exception);
+  if ((server_info->file != -1) && (version > 1))
+    {
+      server_info->session_key=session_key;
+      server_info->version=NegotiateDistributeCacheVersion(server_info,version,
+        compression);
+      if (server_info->version == 0)
+        {
+          /*
+            Reconnect and fall back to the original protocol.
+          */
+#if defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
+          CLOSE_SOCKET(server_info->file);
+#endif
+          server_info->version=1;
+          server_info->compression=NoCompression;
+          server_info->file=ConnectPixelCacheServer(hostname,server_info->port,
+            &session_key,exception);
+        }
+    }
   if (server_info->file == -1)
     server_info=DestroyDistributeCacheInfo(server_info);
   else
     {
       server_info->session_key=session_key;
       (void) CopyMagickString(server_info->hostname,hostname,MagickPathExtent);
+      server_info->semaphore=AcquireSemaphoreInfo();
       server_info->debug=(GetLogEventMask() & CacheEvent) != 0 ? MagickTrue :
         MagickFalse;
     }
-  hostname=DestroyString(hostname);
+  return(server_info);
+}
+
+MagickPrivate DistributeCacheInfo *AcquireDistributeCacheInfo(
+  ExceptionInfo *exception)
+{
+  char
+    *hostname,
+    **hostlist;
+
+  DistributeCacheInfo
+    *server_info,
+    **shards;
+
+  int
+    port;
+
+  MagickBooleanType
+    status;
+
+  size_t
+    number_hosts;
+
+  ssize_t
+    i;
+
+  /*
+    Connect to every server in the host list, each holds a band of rows.
+  */
+  hostlist=GetHostList(&number_hosts,exception);
+  if (hostlist == (char **) NULL)
+    return((DistributeCacheInfo *) NULL);
+  shards=(DistributeCacheInfo **) AcquireQuantumMemory(number_hosts,
+    sizeof(*shards));
+  if (shards != (DistributeCacheInfo **) NULL)
+    (void) memset(shards,0,number_hosts*sizeof(*shards));
+  status=shards != (DistributeCacheInfo **) NULL ? MagickTrue : MagickFalse;
+  for (i=0; i < (ssize_t) number_hosts; i++)
+  {
+    if (status != MagickFalse)
+      {
+        hostname=GetHostname(hostlist[i],&port);
+        shards[i]=ConnectDistributeCache(hostname,port,exception);
+        hostname=DestroyString(hostname);
+        if (shards[i] == (DistributeCacheInfo *) NULL)
+          status=MagickFalse;
+      }
+    hostlist[i]=DestroyString(hostlist[i]);
+  }
+  hostlist=(char **) RelinquishMagickMemory(hostlist);
+  if (status == MagickFalse)
+    {
+      if (shards != (DistributeCacheInfo **) NULL)
+        {
+          for (i=0; i < (ssize_t) number_hosts; i++)
+            if (shards[i] != (DistributeCacheInfo *) NULL)
+              shards[i]=DestroyDistributeCacheInfo(shards[i]);
+          shards=(DistributeCacheInfo **) RelinquishMagickMemory(shards);
+        }
+      return((DistributeCacheInfo *) NULL);
+    }
+  server_info=shards[0];
+  server_info->number_shards=number_hosts;
+  server_info->shards=shards;
   return(server_info);
 }
 
@@ -429,10 +816,23 @@ MagickPrivate DistributeCacheInfo *DestroyDistributeCacheInfo(
 {
   assert(server_info != (DistributeCacheInfo *) NULL);
   assert(server_info->signature == MagickCoreSignature);
+  if (server_info->shards != (DistributeCacheInfo **) NULL)
+    {
+      ssize_t
+        i;
+
+      for (i=1; i < (ssize_t) server_info->number_shards; i++)
+        server_info->shards[i]=DestroyDistributeCacheInfo(
+          server_info->shards[i]);
+      server_info->shards=(DistributeCacheInfo **) RelinquishMagickMemory(
+        server_info->shards);
+    }
 #if defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
   if (server_info->file > 0)
     CLOSE_SOCKET(server_info->file);
 #endif
+  if (server_info->semaphore != (SemaphoreInfo *) NULL)
+    RelinquishSemaphoreInfo(&server_info->semaphore);
   server_info->signature=(~MagickCoreSignature);
   server_info=(DistributeCacheInfo *) RelinquishMagickMemory(server_info);
   return(server_info);
@@ -464,46 +864,6 @@ MagickPrivate DistributeCacheInfo *DestroyDistributeCacheInfo(
 %
 */
 
-#if !defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
-static inline MagickOffsetType dpc_send(SOCKET_TYPE magick_unused(file),
-  const MagickSizeType magick_unused(length),
-  const void *magick_restrict magick_unused(message))
-{
-  magick_unreferenced(file);
-  magick_unreferenced(length);
-  magick_unreferenced(message);
-  return(-1);
-}
-#else
-static inline MagickOffsetType dpc_send(SOCKET_TYPE file,const MagickSizeType length,
-  const void *magick_restrict message)
-{
-  MagickOffsetType
-    i;
-
-  ssize_t
-    count;
-
-  /*
-    Ensure a complete message is sent.
-  */
-  count=0;
-  for (i=0; i < (MagickOffsetType) length; i+=count)
-  {
-    count=(ssize_t) send(file,(char *) message+i,(LENGTH_TYPE)
-      MagickMin(length-(MagickSizeType) i,(MagickSizeType) MagickMaxBufferExtent),
-      MSG_NOSIGNAL);
-    if (count <= 0)
-      {
-        count=0;
-        if (errno != EINTR)
-          break;
-      }
-  }
-  return(i);
-}
-#endif
-
 #if !defined(MAGICKCORE_HAVE_DISTRIBUTE_CACHE)
 MagickExport void DistributePixelCacheServer(const int magick_unused(port),
   ExceptionInfo *magick_unused(exception))
@@ -589,32 +949,99 @@ static MagickBooleanType OpenDistributeCache(SplayTreeInfo *registry,
   return(status);
 }
 
-static MagickBooleanType ReadDistributeCacheMetacontent(SplayTreeInfo *registry,
-  SOCKET_TYPE file,const size_t session_key,ExceptionInfo *exception)
+static MagickBooleanType SendDistributeCacheReply(SOCKET_TYPE file,
+  const CompressionType compression,const void *data,
+  const MagickSizeType length)
 {
-  const Quantum
-    *p;
-
-  const unsigned char
-    *metacontent;
-
-  Image
-    *image;
-
-  MagickAddressType
-    key = (MagickAddressType) session_key;
+  MagickBooleanType
+    status;
 
   MagickOffsetType
     count;
 
-  MagickSizeType
-    length;
-
-  RectangleInfo
-    region;
-
-  unsigned char
-    message[MagickPathExtent],
+  /*
+    Protocol version 2 prefixes each reply with its status so that a failed
+    request does not desynchronize the requests still in flight.
+  */
+  status=data != (const void *) NULL ? MagickTrue : MagickFalse;
+  count=dpc_send(file,sizeof(status),&status);
+  if (count != (MagickOffsetType) sizeof(status))
+    return(MagickFalse);
+  if (status == MagickFalse)
+    return(MagickTrue);
+  count=SendDistributeCachePayload(file,compression,length,
+    (const unsigned char *) data);
+  if (count != (MagickOffsetType) length)
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
+static MagickOffsetType SendDistributeCacheRegion(SOCKET_TYPE file,
+  const Image *image,const RectangleInfo *region,
+  const MagickBooleanType metacontent,const MagickSizeType length,
+  const size_t version)
+{
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  /*
+    Uncompressed replies from a disk-based cache go straight from the page
+    cache to the socket.  Returns -1 if nothing was sent.
+  */
+  if (GetImagePixelCacheType(image) != DiskCache)
+    return(-1);
+  extent=(MagickSizeType) region->width*region->height*(metacontent !=
+    MagickFalse ? image->metacontent_extent : image->number_channels*
+    sizeof(Quantum));
+  if ((extent != length) || (length == 0) || (region->x < 0) ||
+      (region->y < 0) ||
+      ((region->x+(ssize_t) region->width) > (ssize_t) image->columns) ||
+      ((region->y+(ssize_t) region->height) > (ssize_t) image->rows))
+    return(-1);
+  if (version > 1)
+    {
+      status=MagickTrue;
+      count=dpc_send(file,sizeof(status),&status);
+      if (count != (MagickOffsetType) sizeof(status))
+        return(0);
+    }
+  count=SendPixelCacheRegion(image,region,metacontent,(int) file);
+  return(MagickMax(count,0));
+}
+
+static MagickBooleanType ReadDistributeCacheMetacontent(SplayTreeInfo *registry,
+  SOCKET_TYPE file,const size_t session_key,const size_t version,
+  const CompressionType compression,ExceptionInfo *exception)
+{
+  const Quantum
+    *p;
+
+  const unsigned char
+    *metacontent;
+
+  Image
+    *image;
+
+  MagickAddressType
+    key = (MagickAddressType) session_key;
+
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    length;
+
+  RectangleInfo
+    region;
+
+  unsigned char
+    message[MagickPathExtent],
     *q;
 
   /*
@@ -639,8 +1066,18 @@ static MagickBooleanType ReadDistributeCacheMetacontent(SplayTreeInfo *registry,
   q+=(ptrdiff_t) sizeof(region.y);
   (void) memcpy(&length,q,sizeof(length));
   q+=(ptrdiff_t) sizeof(length);
+  if (compression != ZipCompression)
+    {
+      count=SendDistributeCacheRegion(file,image,&region,MagickTrue,length,
+        version);
+      if (count >= 0)
+        return(count == (MagickOffsetType) length ? MagickTrue : MagickFalse);
+    }
   p=GetVirtualPixels(image,region.x,region.y,region.width,region.height,
     exception);
+  if (version > 1)
+    return(SendDistributeCacheReply(file,compression,p != (const Quantum *)
+      NULL ? GetVirtualMetacontent(image) : (const void *) NULL,length));
   if (p == (const Quantum *) NULL)
     return(MagickFalse);
   metacontent=(const unsigned char *) GetVirtualMetacontent(image);
@@ -651,7 +1088,8 @@ static MagickBooleanType ReadDistributeCacheMetacontent(SplayTreeInfo *registry,
 }
 
 static MagickBooleanType ReadDistributeCachePixels(SplayTreeInfo *registry,
-  SOCKET_TYPE file,const size_t session_key,ExceptionInfo *exception)
+  SOCKET_TYPE file,const size_t session_key,const size_t version,
+  const CompressionType compression,ExceptionInfo *exception)
 {
   const Quantum
     *p;
@@ -697,8 +1135,17 @@ static MagickBooleanType ReadDistributeCachePixels(SplayTreeInfo *registry,
   q+=(ptrdiff_t) sizeof(region.y);
   (void) memcpy(&length,q,sizeof(length));
   q+=(ptrdiff_t) sizeof(length);
+  if (compression != ZipCompression)
+    {
+      count=SendDistributeCacheRegion(file,image,&region,MagickFalse,length,
+        version);
+      if (count >= 0)
+        return(count == (MagickOffsetType) length ? MagickTrue : MagickFalse);
+    }
   p=GetVirtualPixels(image,region.x,region.y,region.width,region.height,
     exception);
+  if (version > 1)
+    return(SendDistributeCacheReply(file,compression,p,length));
   if (p == (const Quantum *) NULL)
     return(MagickFalse);
   count=dpc_send(file,length,p);
@@ -714,7 +1161,7 @@ static void *RelinquishImageRegistry(void *image)
 
 static MagickBooleanType WriteDistributeCacheMetacontent(
   SplayTreeInfo *registry,SOCKET_TYPE file,const size_t session_key,
-  ExceptionInfo *exception)
+  const CompressionType compression,ExceptionInfo *exception)
 {
   Image
     *image;
@@ -767,14 +1214,15 @@ static MagickBooleanType WriteDistributeCacheMetacontent(
   if (q == (Quantum *) NULL)
     return(MagickFalse);
   metacontent=(unsigned char *) GetAuthenticMetacontent(image);
-  count=dpc_read(file,length,metacontent);
+  count=ReceiveDistributeCachePayload(file,compression,length,metacontent);
   if (count != (MagickOffsetType) length)
     return(MagickFalse);
   return(SyncAuthenticPixels(image,exception));
 }
 
 static MagickBooleanType WriteDistributeCachePixels(SplayTreeInfo *registry,
-  SOCKET_TYPE file,const size_t session_key,ExceptionInfo *exception)
+  SOCKET_TYPE file,const size_t session_key,const CompressionType compression,
+  ExceptionInfo *exception)
 {
   Image
     *image;
@@ -824,7 +1272,8 @@ static MagickBooleanType WriteDistributeCachePixels(SplayTreeInfo *registry,
     exception);
   if (q == (Quantum *) NULL)
     return(MagickFalse);
-  count=dpc_read(file,length,(unsigned char *) q);
+  count=ReceiveDistributeCachePayload(file,compression,length,
+    (unsigned char *) q);
   if (count != (MagickOffsetType) length)
     return(MagickFalse);
   return(SyncAuthenticPixels(image,exception));
@@ -835,6 +1284,9 @@ static HANDLER_RETURN_TYPE DistributePixelCacheClient(void *socket)
   char
     *shared_secret;
 
+  CompressionType
+    compression;
+
   ExceptionInfo
     *exception;
 
@@ -846,7 +1298,8 @@ static HANDLER_RETURN_TYPE DistributePixelCacheClient(void *socket)
 
   size_t
     key,
-    session_key;
+    session_key,
+    version;
 
   SOCKET_TYPE
     client_socket;
@@ -877,7 +1330,10 @@ static HANDLER_RETURN_TYPE DistributePixelCacheClient(void *socket)
   registry=NewSplayTree((int (*)(const void *,const void *)) NULL,
     (void *(*)(void *)) NULL,RelinquishImageRegistry);
   client_socket=(*(SOCKET_TYPE *) socket);
+  SetDistributeCacheSocketOptions(client_socket);
   count=dpc_send(client_socket,sizeof(session_key),&session_key);
+  compression=NoCompression;
+  version=1;
   for (status=MagickFalse; ; )
   {
     count=dpc_read(client_socket,1,(unsigned char *) &command);
@@ -898,25 +1354,56 @@ static HANDLER_RETURN_TYPE DistributePixelCacheClient(void *socket)
       case 'r':
       {
         status=ReadDistributeCachePixels(registry,client_socket,session_key,
-          exception);
+          version,compression,exception);
         break;
       }
       case 'R':
       {
         status=ReadDistributeCacheMetacontent(registry,client_socket,
-          session_key,exception);
+          session_key,version,compression,exception);
+        break;
+      }
+      case 'v':
+      {
+        status=MagickFalse;
+        count=dpc_read(client_socket,sizeof(version),(unsigned char *)
+          &version);
+        if (count != (MagickOffsetType) sizeof(version))
+          break;
+        version=MagickMax(MagickMin(version,DPCVersion),1);
+        count=dpc_send(client_socket,sizeof(version),&version);
+        if (count != (MagickOffsetType) sizeof(version))
+          break;
+        if (version > 2)
+          {
+            /*
+              Accept the requested wire compression if it is supported.
+            */
+            count=dpc_read(client_socket,sizeof(compression),(unsigned char *)
+              &compression);
+            if (count != (MagickOffsetType) sizeof(compression))
+              break;
+#if defined(MAGICKCORE_ZLIB_DELEGATE)
+            if (compression != ZipCompression)
+#endif
+              compression=NoCompression;
+            count=dpc_send(client_socket,sizeof(compression),&compression);
+            if (count != (MagickOffsetType) sizeof(compression))
+              break;
+          }
+        status=MagickTrue;
         break;
       }
       case 'w':
       {
         status=WriteDistributeCachePixels(registry,client_socket,session_key,
-          exception);
+          compression,exception);
         break;
       }
       case 'W':
       {
         status=WriteDistributeCacheMetacontent(registry,client_socket,
-          session_key,exception);
+          session_key,compression,exception);
         break;
       }
       case 'd':
@@ -1022,6 +1509,9 @@ MagickExport void DistributePixelCacheServer(const int port,
   status=listen(server_socket,DPCPendingConnections);
   if (status != 0)
     ThrowFatalException(CacheFatalError,"UnableToListen");
+#if defined(SIGPIPE)
+  (void) signal(SIGPIPE,SIG_IGN);  /* sendfile() to a closed client socket */
+#endif
 #if defined(MAGICKCORE_THREAD_SUPPORT)
   pthread_attr_init(&attributes);
 #endif
@@ -1199,8 +1689,8 @@ MagickPrivate int GetDistributeCachePort(const DistributeCacheInfo *server_info)
 %    o image: the image.
 %
 */
-MagickPrivate MagickBooleanType OpenDistributePixelCache(
-  DistributeCacheInfo *server_info,Image *image)
+static MagickBooleanType OpenDistributeCacheShard(
+  DistributeCacheInfo *server_info,Image *image,const size_t rows)
 {
   MagickBooleanType
     status;
@@ -1212,13 +1702,6 @@ MagickPrivate MagickBooleanType OpenDistributePixelCache(
     message[MagickPathExtent],
     *p;
 
-  /*
-    Open distributed pixel cache.
-  */
-  assert(server_info != (DistributeCacheInfo *) NULL);
-  assert(server_info->signature == MagickCoreSignature);
-  assert(image != (Image *) NULL);
-  assert(image->signature == MagickCoreSignature);
   p=message;
   *p++='o';  /* open */
   /*
@@ -1236,8 +1719,8 @@ MagickPrivate MagickBooleanType OpenDistributePixelCache(
   p+=(ptrdiff_t) sizeof(image->channels);
   (void) memcpy(p,&image->columns,sizeof(image->columns));
   p+=(ptrdiff_t) sizeof(image->columns);
-  (void) memcpy(p,&image->rows,sizeof(image->rows));
-  p+=(ptrdiff_t) sizeof(image->rows);
+  (void) memcpy(p,&rows,sizeof(rows));
+  p+=(ptrdiff_t) sizeof(rows);
   (void) memcpy(p,&image->number_channels,sizeof(image->number_channels));
   p+=(ptrdiff_t) sizeof(image->number_channels);
   (void) memcpy(p,image->channel_map,MaxPixelChannels*
@@ -1254,6 +1737,45 @@ MagickPrivate MagickBooleanType OpenDistributePixelCache(
     return(MagickFalse);
   return(status);
 }
+
+MagickPrivate MagickBooleanType OpenDistributePixelCache(
+  DistributeCacheInfo *server_info,Image *image)
+{
+  MagickBooleanType
+    status;
+
+  size_t
+    rows;
+
+  ssize_t
+    i;
+
+  /*
+    Open distributed pixel cache, one band of rows per server.
+  */
+  assert(server_info != (DistributeCacheInfo *) NULL);
+  assert(server_info->signature == MagickCoreSignature);
+  assert(image != (Image *) NULL);
+  assert(image->signature == MagickCoreSignature);
+  rows=(image->rows+server_info->number_shards-1)/server_info->number_shards;
+  status=MagickTrue;
+  for (i=0; i < (ssize_t) server_info->number_shards; i++)
+  {
+    DistributeCacheInfo
+      *shard;
+
+    shard=server_info->shards[i];
+    shard->first_row=(ssize_t) MagickMin((size_t) i*rows,image->rows);
+    shard->columns=image->columns;
+    shard->rows=MagickMin(rows,image->rows-(size_t) shard->first_row);
+    if (shard->rows == 0)
+      continue;
+    status=OpenDistributeCacheShard(shard,image,shard->rows);
+    if (status == MagickFalse)
+      break;
+  }
+  return(status);
+}
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -1288,9 +1810,10 @@ MagickPrivate MagickBooleanType OpenDistributePixelCache(
 %    o metacontent: read these metacontent from the pixel cache.
 %
 */
-MagickPrivate MagickOffsetType ReadDistributePixelCacheMetacontent(
-  DistributeCacheInfo *server_info,const RectangleInfo *region,
-  const MagickSizeType length,unsigned char *metacontent)
+
+static MagickBooleanType SendDistributeCacheRequest(
+  DistributeCacheInfo *server_info,const unsigned char command,
+  const RectangleInfo *region,const MagickSizeType length)
 {
   MagickOffsetType
     count;
@@ -1299,17 +1822,8 @@ MagickPrivate MagickOffsetType ReadDistributePixelCacheMetacontent(
     message[MagickPathExtent],
     *p;
 
-  /*
-    Read distributed pixel cache metacontent.
-  */
-  assert(server_info != (DistributeCacheInfo *) NULL);
-  assert(server_info->signature == MagickCoreSignature);
-  assert(region != (RectangleInfo *) NULL);
-  assert(metacontent != (unsigned char *) NULL);
-  if (length > (MagickSizeType) MAGICK_SSIZE_MAX)
-    return(-1);
   p=message;
-  *p++='R';
+  *p++=command;
   (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
   p+=(ptrdiff_t) sizeof(server_info->session_key);
   (void) memcpy(p,&region->width,sizeof(region->width));
@@ -1324,8 +1838,552 @@ MagickPrivate MagickOffsetType ReadDistributePixelCacheMetacontent(
   p+=(ptrdiff_t) sizeof(length);
   count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
   if (count != (MagickOffsetType) (p-message))
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
+static MagickOffsetType ReceiveDistributeCacheReply(
+  DistributeCacheInfo *server_info,const MagickSizeType length,
+  unsigned char *data)
+{
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  if (server_info->version > 1)
+    {
+      status=MagickFalse;
+      count=dpc_read(server_info->file,sizeof(status),(unsigned char *)
+        &status);
+      if ((count != (MagickOffsetType) sizeof(status)) ||
+          (status == MagickFalse))
+        return(-1);
+    }
+  return(ReceiveDistributeCachePayload(server_info->file,
+    server_info->compression,length,data));
+}
+
+static MagickBooleanType DrainDistributePixelCache(
+  DistributeCacheInfo *server_info)
+{
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  size_t
+    rows;
+
+  ssize_t
+    y;
+
+  unsigned char
+    *data;
+
+  /*
+    Discard the replies to outstanding prefetch requests.
+  */
+  if (server_info->prefetch_requests == 0)
+    return(MagickTrue);
+  data=(unsigned char *) AcquireQuantumMemory(
+    server_info->prefetch_region.height,(size_t) server_info->prefetch_extent);
+  if (data == (unsigned char *) NULL)
+    return(MagickFalse);
+  for (y=server_info->prefetch_region.y; server_info->prefetch_requests != 0; )
+  {
+    rows=MagickMin(server_info->prefetch_region.height,server_info->rows-
+      (size_t) y);
+    count=ReceiveDistributeCacheReply(server_info,rows*
+      server_info->prefetch_extent,data);
+    if (count != (MagickOffsetType) (rows*server_info->prefetch_extent))
+      break;
+    y+=(ssize_t) rows;
+    server_info->prefetch_requests--;
+  }
+  data=(unsigned char *) RelinquishMagickMemory(data);
+  status=server_info->prefetch_requests == 0 ? MagickTrue : MagickFalse;
+  server_info->prefetch_requests=0;
+  server_info->prefetch_window=0;
+  return(status);
+}
+
+static MagickBooleanType PrefetchDistributePixelCache(
+  DistributeCacheInfo *server_info)
+{
+  RectangleInfo
+    band;
+
+  size_t
+    number_requests;
+
+  /*
+    Keep the rows that follow a sequential scan in flight.  The window
+    doubles with each prefetch hit, and the replies are bounded by
+    DPCPrefetchExtent so they always fit in the socket buffers while the
+    client interleaves writes.
+  */
+  number_requests=(size_t) MagickMin(DPCPrefetchExtent/
+    (server_info->prefetch_region.height*server_info->prefetch_extent),
+    server_info->prefetch_window);
+  band=server_info->prefetch_region;
+  band.y+=(ssize_t) (server_info->prefetch_requests*band.height);
+  while ((server_info->prefetch_requests < number_requests) &&
+         (band.y < (ssize_t) server_info->rows))
+  {
+    band.height=MagickMin(server_info->prefetch_region.height,
+      server_info->rows-(size_t) band.y);
+    if (SendDistributeCacheRequest(server_info,'r',&band,band.height*
+        server_info->prefetch_extent) == MagickFalse)
+      return(MagickFalse);
+    server_info->prefetch_requests++;
+    band.y+=(ssize_t) band.height;
+  }
+  return(MagickTrue);
+}
+
+static MagickOffsetType ReadDistributeCacheRegion(
+  DistributeCacheInfo *server_info,const unsigned char command,
+  const RectangleInfo *region,const MagickSizeType length,unsigned char *data)
+{
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  RectangleInfo
+    band;
+
+  size_t
+    number_requests,
+    rows,
+    window;
+
+  ssize_t
+    reply_y,
+    request_y,
+    y;
+
+  /*
+    Split the region into bands of whole rows.  Protocol version 2 keeps up
+    to DPCMaximumRequests bands in flight, version 1 is stop-and-wait.
+  */
+  if ((region->height == 0) || ((length % region->height) != 0))
+    return(-1);
+  extent=length/region->height;
+  rows=(size_t) MagickMax(DPCBatchExtent/MagickMax(extent,1),1);
+  window=server_info->version > 1 ? DPCMaximumRequests : 1;
+  y=region->y+(ssize_t) region->height;
+  number_requests=0;
+  status=MagickTrue;
+  band=(*region);
+  for (request_y=region->y, reply_y=region->y; reply_y < y; )
+  {
+    while ((status != MagickFalse) && (request_y < y) &&
+           (number_requests < window))
+    {
+      band.y=request_y;
+      band.height=MagickMin(rows,(size_t) (y-request_y));
+      if (SendDistributeCacheRequest(server_info,command,&band,
+          band.height*extent) == MagickFalse)
+        return(-1);
+      request_y+=(ssize_t) band.height;
+      number_requests++;
+    }
+    if (number_requests == 0)
+      break;
+    band.height=MagickMin(rows,(size_t) (y-reply_y));
+    count=ReceiveDistributeCacheReply(server_info,band.height*extent,data+
+      (MagickSizeType) (reply_y-region->y)*extent);
+    if (count != (MagickOffsetType) (band.height*extent))
+      status=MagickFalse;
+    reply_y+=(ssize_t) band.height;
+    number_requests--;
+  }
+  if (status == MagickFalse)
+    return(-1);
+  return((MagickOffsetType) length);
+}
+
+static MagickOffsetType WriteDistributeCacheRegion(
+  DistributeCacheInfo *server_info,const unsigned char command,
+  const RectangleInfo *region,const MagickSizeType length,
+  const unsigned char *data)
+{
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  RectangleInfo
+    band;
+
+  size_t
+    rows;
+
+  ssize_t
+    y;
+
+  /*
+    Writes are not acknowledged so the bands are streamed back-to-back.
+  */
+  if ((region->height == 0) || ((length % region->height) != 0))
+    return(-1);
+  extent=length/region->height;
+  rows=(size_t) MagickMax(DPCBatchExtent/MagickMax(extent,1),1);
+  band=(*region);
+  for (y=region->y; y < (region->y+(ssize_t) region->height); )
+  {
+    band.y=y;
+    band.height=MagickMin(rows,(size_t) (region->y+(ssize_t) region->height-
+      y));
+    if (SendDistributeCacheRequest(server_info,command,&band,
+        band.height*extent) == MagickFalse)
+      return(-1);
+    count=SendDistributeCachePayload(server_info->file,
+      server_info->compression,band.height*extent,data+(MagickSizeType)
+      (y-region->y)*extent);
+    if (count != (MagickOffsetType) (band.height*extent))
+      return(-1);
+    y+=(ssize_t) band.height;
+  }
+  return((MagickOffsetType) length);
+}
+
+static MagickOffsetType ReadDistributeCacheShardMetacontent(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,
+  const MagickSizeType length,unsigned char *metacontent)
+{
+  /*
+    Read distributed pixel cache metacontent.
+  */
+  if (DrainDistributePixelCache(server_info) == MagickFalse)
     return(-1);
-  return(dpc_read(server_info->file,length,metacontent));
+  return(ReadDistributeCacheRegion(server_info,'R',region,length,metacontent));
+}
+
+static MagickOffsetType ReadDistributeCacheShardPixels(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,
+  const MagickSizeType length,unsigned char *magick_restrict pixels)
+{
+  MagickOffsetType
+    count;
+
+  size_t
+    rows;
+
+  /*
+    Read distributed pixel cache pixels.
+  */
+  rows=0;
+  if (server_info->prefetch_requests != 0)
+    rows=MagickMin(server_info->prefetch_region.height,server_info->rows-
+      (size_t) server_info->prefetch_region.y);
+  if ((server_info->prefetch_requests != 0) &&
+      (region->x == server_info->prefetch_region.x) &&
+      (region->y == server_info->prefetch_region.y) &&
+      (region->width == server_info->prefetch_region.width) &&
+      (region->height == rows) &&
+      (length == (rows*server_info->prefetch_extent)))
+    {
+      /*
+        The reply to this request is already on its way.
+      */
+      count=ReceiveDistributeCacheReply(server_info,length,pixels);
+      server_info->prefetch_requests--;
+      server_info->prefetch_region.y+=(ssize_t) rows;
+      server_info->prefetch_window=MagickMin(2*server_info->prefetch_window,
+        DPCMaximumRequests);
+    }
+  else
+    {
+      if (DrainDistributePixelCache(server_info) == MagickFalse)
+        return(-1);
+      count=ReadDistributeCacheRegion(server_info,'r',region,length,pixels);
+    }
+  if ((server_info->version > 1) && (count == (MagickOffsetType) length) &&
+      (length <= DPCPrefetchExtent) && (region->x == 0) &&
+      (region->width == server_info->columns) &&
+      (region->width == server_info->last_region.width) &&
+      (region->height != 0) && (region->y == (server_info->last_region.y+
+       (ssize_t) server_info->last_region.height)))
+    {
+      /*
+        Sequential scanline access, request the rows that follow.
+      */
+      if (server_info->prefetch_requests == 0)
+        {
+          server_info->prefetch_region=(*region);
+          server_info->prefetch_region.y+=(ssize_t) region->height;
+          server_info->prefetch_extent=length/region->height;
+          server_info->prefetch_window=MagickMax(
+            server_info->prefetch_window,1);
+        }
+      if (PrefetchDistributePixelCache(server_info) == MagickFalse)
+        return(-1);
+    }
+  server_info->last_region=(*region);
+  return(count);
+}
+
+static MagickBooleanType RelinquishDistributeCacheShard(
+  DistributeCacheInfo *server_info)
+{
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  unsigned char
+    message[MagickPathExtent],
+    *p;
+
+  /*
+    Delete distributed pixel cache.
+  */
+  if (DrainDistributePixelCache(server_info) == MagickFalse)
+    return(MagickFalse);
+  p=message;
+  *p++='d';
+  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
+  p+=(ptrdiff_t) sizeof(server_info->session_key);
+  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
+  if (count != (MagickOffsetType) (p-message))
+    return(MagickFalse);
+  status=MagickFalse;
+  count=dpc_read(server_info->file,sizeof(status),(unsigned char *) &status);
+  if (count != (MagickOffsetType) sizeof(status))
+    return(MagickFalse);
+  return(status);
+}
+
+static MagickOffsetType WriteDistributeCacheShardMetacontent(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,
+  const MagickSizeType length,const unsigned char *metacontent)
+{
+  /*
+    Write distributed pixel cache metacontent.
+  */
+  return(WriteDistributeCacheRegion(server_info,'W',region,length,
+    metacontent));
+}
+
+static MagickOffsetType WriteDistributeCacheShardPixels(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,
+  const MagickSizeType length,const unsigned char *magick_restrict pixels)
+{
+  /*
+    Write distributed pixel cache pixels.
+  */
+  if ((server_info->prefetch_requests != 0) &&
+      (region->y < (server_info->prefetch_region.y+(ssize_t)
+       (server_info->prefetch_requests*server_info->prefetch_region.height))) &&
+      ((region->y+(ssize_t) region->height) > server_info->prefetch_region.y))
+    {
+      /*
+        The prefetched rows are stale once they are overwritten.
+      */
+      if (DrainDistributePixelCache(server_info) == MagickFalse)
+        return(-1);
+    }
+  return(WriteDistributeCacheRegion(server_info,'w',region,length,pixels));
+}
+
+static DistributeCacheInfo *GetDistributeCacheShard(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,const ssize_t y,
+  RectangleInfo *band)
+{
+  DistributeCacheInfo
+    *shard;
+
+  ssize_t
+    i;
+
+  /*
+    Return the server that holds row y and the part of the region it holds.
+  */
+  for (i=0; i < (ssize_t) server_info->number_shards; i++)
+  {
+    shard=server_info->shards[i];
+    if ((y >= shard->first_row) &&
+        (y < (shard->first_row+(ssize_t) shard->rows)))
+      {
+        *band=(*region);
+        band->y=y-shard->first_row;
+        band->height=(size_t) (MagickMin(region->y+(ssize_t) region->height,
+          shard->first_row+(ssize_t) shard->rows)-y);
+        return(shard);
+      }
+  }
+  return((DistributeCacheInfo *) NULL);
+}
+
+static MagickOffsetType GatherDistributeCacheShards(
+  DistributeCacheInfo *server_info,const unsigned char command,
+  const RectangleInfo *region,const MagickSizeType extent,unsigned char *data)
+{
+  DistributeCacheInfo
+    *shard;
+
+  MagickBooleanType
+    status;
+
+  MagickOffsetType
+    count;
+
+  RectangleInfo
+    band;
+
+  ssize_t
+    request_y,
+    y;
+
+  /*
+    Send the request to every server before waiting on any reply so the round
+    trips overlap.  Locks are taken in shard order.
+  */
+  status=MagickTrue;
+  for (request_y=region->y; request_y < (region->y+(ssize_t) region->height); )
+  {
+    shard=GetDistributeCacheShard(server_info,region,request_y,&band);
+    LockSemaphoreInfo(shard->semaphore);
+    request_y+=(ssize_t) band.height;
+    if ((DrainDistributePixelCache(shard) == MagickFalse) ||
+        (SendDistributeCacheRequest(shard,command,&band,band.height*extent) ==
+         MagickFalse))
+      {
+        UnlockSemaphoreInfo(shard->semaphore);
+        request_y-=(ssize_t) band.height;
+        status=MagickFalse;
+        break;
+      }
+  }
+  for (y=region->y; y < request_y; y+=(ssize_t) band.height)
+  {
+    shard=GetDistributeCacheShard(server_info,region,y,&band);
+    count=ReceiveDistributeCacheReply(shard,band.height*extent,data+
+      (MagickSizeType) (y-region->y)*extent);
+    if (count != (MagickOffsetType) (band.height*extent))
+      status=MagickFalse;
+    shard->last_region=band;
+    UnlockSemaphoreInfo(shard->semaphore);
+  }
+  if (status == MagickFalse)
+    return(-1);
+  return((MagickOffsetType) (region->height*extent));
+}
+
+static MagickOffsetType TransferDistributeCacheShards(
+  DistributeCacheInfo *server_info,const unsigned char command,
+  const RectangleInfo *region,const MagickSizeType length,unsigned char *data)
+{
+  DistributeCacheInfo
+    *shard;
+
+  MagickBooleanType
+    gather;
+
+  MagickOffsetType
+    count;
+
+  MagickSizeType
+    extent;
+
+  RectangleInfo
+    band;
+
+  ssize_t
+    y;
+
+  /*
+    Split the region at the band boundaries.  Each server connection has its
+    own lock, so client threads that touch different bands do not wait on
+    each other.
+  */
+  if ((region->height == 0) || ((length % region->height) != 0))
+    return(-1);
+  extent=length/region->height;
+  gather=((command == 'r') || (command == 'R')) ? MagickTrue : MagickFalse;
+  for (y=region->y; y < (region->y+(ssize_t) region->height); )
+  {
+    shard=GetDistributeCacheShard(server_info,region,y,&band);
+    if (shard == (DistributeCacheInfo *) NULL)
+      return(-1);
+    if ((shard->version < 2) || ((band.height*extent) > DPCBatchExtent) ||
+        ((y == region->y) && (band.height == region->height)))
+      gather=MagickFalse;
+    y+=(ssize_t) band.height;
+  }
+  if (gather != MagickFalse)
+    return(GatherDistributeCacheShards(server_info,command,region,extent,
+      data));
+  for (y=region->y; y < (region->y+(ssize_t) region->height); )
+  {
+    shard=GetDistributeCacheShard(server_info,region,y,&band);
+    LockSemaphoreInfo(shard->semaphore);
+    switch (command)
+    {
+      case 'r':
+      {
+        count=ReadDistributeCacheShardPixels(shard,&band,band.height*extent,
+          data+(MagickSizeType) (y-region->y)*extent);
+        break;
+      }
+      case 'R':
+      {
+        count=ReadDistributeCacheShardMetacontent(shard,&band,band.height*
+          extent,data+(MagickSizeType) (y-region->y)*extent);
+        break;
+      }
+      case 'w':
+      {
+        count=WriteDistributeCacheShardPixels(shard,&band,band.height*extent,
+          data+(MagickSizeType) (y-region->y)*extent);
+        break;
+      }
+      case 'W':
+      {
+        count=WriteDistributeCacheShardMetacontent(shard,&band,band.height*
+          extent,data+(MagickSizeType) (y-region->y)*extent);
+        break;
+      }
+      default:
+      {
+        count=(-1);
+        break;
+      }
+    }
+    UnlockSemaphoreInfo(shard->semaphore);
+    if (count != (MagickOffsetType) (band.height*extent))
+      return(-1);
+    y+=(ssize_t) band.height;
+  }
+  return((MagickOffsetType) length);
+}
+
+MagickPrivate MagickOffsetType ReadDistributePixelCacheMetacontent(
+  DistributeCacheInfo *server_info,const RectangleInfo *region,
+  const MagickSizeType length,unsigned char *metacontent)
+{
+  /*
+    Read distributed pixel cache metacontent.
+  */
+  assert(server_info != (DistributeCacheInfo *) NULL);
+  assert(server_info->signature == MagickCoreSignature);
+  assert(region != (RectangleInfo *) NULL);
+  assert(metacontent != (unsigned char *) NULL);
+  if (length > (MagickSizeType) MAGICK_SSIZE_MAX)
+    return(-1);
+  return(TransferDistributeCacheShards(server_info,'R',region,length,
+    metacontent));
 }
 
 /*
@@ -1365,13 +2423,6 @@ MagickPrivate MagickOffsetType ReadDistributePixelCachePixels(
   DistributeCacheInfo *server_info,const RectangleInfo *region,
   const MagickSizeType length,unsigned char *magick_restrict pixels)
 {
-  MagickOffsetType
-    count;
-
-  unsigned char
-    message[MagickPathExtent],
-    *p;
-
   /*
     Read distributed pixel cache pixels.
   */
@@ -1381,24 +2432,7 @@ MagickPrivate MagickOffsetType ReadDistributePixelCachePixels(
   assert(pixels != (unsigned char *) NULL);
   if (length > (MagickSizeType) MAGICK_SSIZE_MAX)
     return(-1);
-  p=message;
-  *p++='r';
-  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
-  p+=(ptrdiff_t) sizeof(server_info->session_key);
-  (void) memcpy(p,&region->width,sizeof(region->width));
-  p+=(ptrdiff_t) sizeof(region->width);
-  (void) memcpy(p,&region->height,sizeof(region->height));
-  p+=(ptrdiff_t) sizeof(region->height);
-  (void) memcpy(p,&region->x,sizeof(region->x));
-  p+=(ptrdiff_t) sizeof(region->x);
-  (void) memcpy(p,&region->y,sizeof(region->y));
-  p+=(ptrdiff_t) sizeof(region->y);
-  (void) memcpy(p,&length,sizeof(length));
-  p+=(ptrdiff_t) sizeof(length);
-  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
-  if (count != (MagickOffsetType) (p-message))
-    return(-1);
-  return(dpc_read(server_info->file,length,pixels));
+  return(TransferDistributeCacheShards(server_info,'r',region,length,pixels));
 }
 
 /*
@@ -1431,29 +2465,28 @@ MagickPrivate MagickBooleanType RelinquishDistributePixelCache(
   MagickBooleanType
     status;
 
-  MagickOffsetType
-    count;
-
-  unsigned char
-    message[MagickPathExtent],
-    *p;
+  ssize_t
+    i;
 
   /*
     Delete distributed pixel cache.
   */
   assert(server_info != (DistributeCacheInfo *) NULL);
   assert(server_info->signature == MagickCoreSignature);
-  p=message;
-  *p++='d';
-  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
-  p+=(ptrdiff_t) sizeof(server_info->session_key);
-  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
-  if (count != (MagickOffsetType) (p-message))
-    return(MagickFalse);
-  status=MagickFalse;
-  count=dpc_read(server_info->file,sizeof(status),(unsigned char *) &status);
-  if (count != (MagickOffsetType) sizeof(status))
-    return(MagickFalse);
+  status=MagickTrue;
+  for (i=0; i < (ssize_t) server_info->number_shards; i++)
+  {
+    DistributeCacheInfo
+      *shard;
+
+    shard=server_info->shards[i];
+    if (shard->rows == 0)
+      continue;
+    LockSemaphoreInfo(shard->semaphore);
+    if (RelinquishDistributeCacheShard(shard) == MagickFalse)
+      status=MagickFalse;
+    UnlockSemaphoreInfo(shard->semaphore);
+  }
   return(status);
 }
 
@@ -1494,13 +2527,6 @@ MagickPrivate MagickOffsetType WriteDistributePixelCacheMetacontent(
   DistributeCacheInfo *server_info,const RectangleInfo *region,
   const MagickSizeType length,const unsigned char *metacontent)
 {
-  MagickOffsetType
-    count;
-
-  unsigned char
-    message[MagickPathExtent],
-    *p;
-
   /*
     Write distributed pixel cache metacontent.
   */
@@ -1510,24 +2536,8 @@ MagickPrivate MagickOffsetType WriteDistributePixelCacheMetacontent(
   assert(metacontent != (unsigned char *) NULL);
   if (length > (MagickSizeType) MAGICK_SSIZE_MAX)
     return(-1);
-  p=message;
-  *p++='W';
-  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
-  p+=(ptrdiff_t) sizeof(server_info->session_key);
-  (void) memcpy(p,&region->width,sizeof(region->width));
-  p+=(ptrdiff_t) sizeof(region->width);
-  (void) memcpy(p,&region->height,sizeof(region->height));
-  p+=(ptrdiff_t) sizeof(region->height);
-  (void) memcpy(p,&region->x,sizeof(region->x));
-  p+=(ptrdiff_t) sizeof(region->x);
-  (void) memcpy(p,&region->y,sizeof(region->y));
-  p+=(ptrdiff_t) sizeof(region->y);
-  (void) memcpy(p,&length,sizeof(length));
-  p+=(ptrdiff_t) sizeof(length);
-  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
-  if (count != (MagickOffsetType) (p-message))
-    return(-1);
-  return(dpc_send(server_info->file,length,metacontent));
+  return(TransferDistributeCacheShards(server_info,'W',region,length,
+    (unsigned char *) metacontent));
 }
 
 /*
@@ -1568,13 +2578,6 @@ MagickPrivate MagickOffsetType WriteDistributePixelCachePixels(
   DistributeCacheInfo *server_info,const RectangleInfo *region,
   const MagickSizeType length,const unsigned char *magick_restrict pixels)
 {
-  MagickOffsetType
-    count;
-
-  unsigned char
-    message[MagickPathExtent],
-    *p;
-
   /*
     Write distributed pixel cache pixels.
   */
@@ -1584,22 +2587,6 @@ MagickPrivate MagickOffsetType WriteDistributePixelCachePixels(
   assert(pixels != (const unsigned char *) NULL);
   if (length > (MagickSizeType) MAGICK_SSIZE_MAX)
     return(-1);
-  p=message;
-  *p++='w';
-  (void) memcpy(p,&server_info->session_key,sizeof(server_info->session_key));
-  p+=(ptrdiff_t) sizeof(server_info->session_key);
-  (void) memcpy(p,&region->width,sizeof(region->width));
-  p+=(ptrdiff_t) sizeof(region->width);
-  (void) memcpy(p,&region->height,sizeof(region->height));
-  p+=(ptrdiff_t) sizeof(region->height);
-  (void) memcpy(p,&region->x,sizeof(region->x));
-  p+=(ptrdiff_t) sizeof(region->x);
-  (void) memcpy(p,&region->y,sizeof(region->y));
-  p+=(ptrdiff_t) sizeof(region->y);
-  (void) memcpy(p,&length,sizeof(length));
-  p+=(ptrdiff_t) sizeof(length);
-  count=dpc_send(server_info->file,(MagickSizeType) (p-message),message);
-  if (count != (MagickOffsetType) (p-message))
-    return(-1);
-  return(dpc_send(server_info->file,length,pixels));
+  return(TransferDistributeCacheShards(server_info,'w',region,length,
+    (unsigned char *) pixels));
 }
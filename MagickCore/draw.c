@@ -4808,15 +4808,16 @@ static size_t DestroyEdge(PolygonInfo *polygon_info,const ssize_t edge)
   return(polygon_info->number_edges);
 }
 
-static double GetFillAlpha(PolygonInfo *polygon_info,const double mid,
-  const MagickBooleanType fill,const FillRule fill_rule,const ssize_t x,
-  const ssize_t y,double *stroke_alpha)
+static void GetScanlineAlpha(PolygonInfo *polygon_info,const double mid,
+  const MagickBooleanType fill,const FillRule fill_rule,const ssize_t x1,
+  const ssize_t x2,const ssize_t y,double *fill_alpha,double *stroke_alpha,
+  ssize_t *winding)
 {
   double
     alpha,
     beta,
     distance,
-    subpath_alpha;
+    radius;
 
   const PointInfo
     *q;
@@ -4830,13 +4831,19 @@ static double GetFillAlpha(PolygonInfo *polygon_info,const double mid,
   ssize_t
     i,
     j,
-    winding_number;
+    lo,
+    hi,
+    winding_number,
+    x;
 
   /*
-    Compute fill & stroke opacity for this (x,y) point.
+    Compute fill & stroke opacity for the (x1..x2,y) scanline.  Each pixel
+    only visits the edge segments within reach of its stroke or antialiased
+    fill, and the winding number is accumulated across the scanline.
   */
-  *stroke_alpha=0.0;
-  subpath_alpha=0.0;
+  (void) memset(fill_alpha,0,(size_t) (x2-x1+1)*sizeof(*fill_alpha));
+  (void) memset(stroke_alpha,0,(size_t) (x2-x1+1)*sizeof(*stroke_alpha));
+  radius=fabs(mid)+1.0;
   p=polygon_info->edges;
   for (j=0; j < (ssize_t) polygon_info->number_edges; j++, p++)
   {
@@ -4848,12 +4855,17 @@ static double GetFillAlpha(PolygonInfo *polygon_info,const double mid,
         (void) DestroyEdge(polygon_info,j--);
         continue;
       }
-    if (((double) x <= (p->bounds.x1-mid-0.5)) ||
-        ((double) x > (p->bounds.x2+mid+0.5)))
+    lo=MagickMax(CastDoubleToSsizeT(floor(p->bounds.x1-mid-0.5))+1,x1);
+    hi=MagickMin(CastDoubleToSsizeT(floor(p->bounds.x2+mid+0.5)),x2);
+    if (lo > hi)
       continue;
     i=(ssize_t) MagickMax((double) p->highwater,1.0);
     for ( ; i < (ssize_t) p->number_points; i++)
     {
+      ssize_t
+        segment_lo,
+        segment_hi;
+
       if ((double) y <= (p->points[i-1].y-mid-0.5))
         break;
       if ((double) y > (p->points[i].y+mid+0.5))
@@ -4863,128 +4875,150 @@ static double GetFillAlpha(PolygonInfo *polygon_info,const double mid,
           p->scanline=(double) y;
           p->highwater=(size_t) i;
         }
-      /*
-        Compute distance between a point and an edge.
-      */
       q=p->points+i-1;
-      delta.x=(q+1)->x-q->x;
-      delta.y=(q+1)->y-q->y;
-      beta=delta.x*(x-q->x)+delta.y*(y-q->y);  /* segLen*point-cos(theta) */
-      if (beta <= 0.0)
-        {
-          /*
-            Cosine <= 0, point is closest to q.
-          */
-          delta.x=(double) x-q->x;
-          delta.y=(double) y-q->y;
-          distance=delta.x*delta.x+delta.y*delta.y;
-        }
-      else
-        {
-          alpha=delta.x*delta.x+delta.y*delta.y;  /* segLen*segLen */
-          if (beta >= alpha)
-            {
-              /*
-                Point is closest to q+1.
-              */
-              delta.x=(double) x-(q+1)->x;
-              delta.y=(double) y-(q+1)->y;
-              distance=delta.x*delta.x+delta.y*delta.y;
-            }
-          else
-            {
-              /*
-                Point is closest to point between q & q+1.
-              */
-              alpha=MagickSafeReciprocal(alpha);
-              beta=delta.x*(y-q->y)-delta.y*(x-q->x);
-              distance=alpha*beta*beta;
-            }
-        }
-      /*
-        Compute stroke & subpath opacity.
-      */
-      beta=0.0;
-      if (p->ghostline == MagickFalse)
-        {
-          alpha=mid+0.5;
-          if ((*stroke_alpha < 1.0) &&
-              (distance <= ((alpha+0.25)*(alpha+0.25))))
-            {
-              alpha=mid-0.5;
-              if (distance <= ((alpha+0.25)*(alpha+0.25)))
-                *stroke_alpha=1.0;
-              else
-                {
-                  beta=1.0;
-                  if (fabs(distance-1.0) >= MagickEpsilon)
-                    beta=sqrt((double) distance);
-                  alpha=beta-mid-0.5;
-                  if (*stroke_alpha < ((alpha-0.25)*(alpha-0.25)))
-                    *stroke_alpha=(alpha-0.25)*(alpha-0.25);
-                }
-            }
-        }
-      if ((fill == MagickFalse) || (distance > 1.0) || (subpath_alpha >= 1.0))
-        continue;
-      if (distance <= 0.0)
-        {
-          subpath_alpha=1.0;
+      segment_lo=MagickMax(CastDoubleToSsizeT(floor(MagickMin(q->x,(q+1)->x)-
+        radius)),lo);
+      segment_hi=MagickMin(CastDoubleToSsizeT(ceil(MagickMax(q->x,(q+1)->x)+
+        radius)),hi);
+      for (x=segment_lo; x <= segment_hi; x++)
+      {
+        double
+          *subpath_alpha;
+
+        /*
+          Compute distance between a point and an edge.
+        */
+        subpath_alpha=fill_alpha+(x-x1);
+        delta.x=(q+1)->x-q->x;
+        delta.y=(q+1)->y-q->y;
+        beta=delta.x*(x-q->x)+delta.y*(y-q->y);  /* segLen*point-cos(theta) */
+        if (beta <= 0.0)
+          {
+            /*
+              Cosine <= 0, point is closest to q.
+            */
+            delta.x=(double) x-q->x;
+            delta.y=(double) y-q->y;
+            distance=delta.x*delta.x+delta.y*delta.y;
+          }
+        else
+          {
+            alpha=delta.x*delta.x+delta.y*delta.y;  /* segLen*segLen */
+            if (beta >= alpha)
+              {
+                /*
+                  Point is closest to q+1.
+                */
+                delta.x=(double) x-(q+1)->x;
+                delta.y=(double) y-(q+1)->y;
+                distance=delta.x*delta.x+delta.y*delta.y;
+              }
+            else
+              {
+                /*
+                  Point is closest to point between q & q+1.
+                */
+                alpha=MagickSafeReciprocal(alpha);
+                beta=delta.x*(y-q->y)-delta.y*(x-q->x);
+                distance=alpha*beta*beta;
+              }
+          }
+        /*
+          Compute stroke & subpath opacity.
+        */
+        beta=0.0;
+        if (p->ghostline == MagickFalse)
+          {
+            alpha=mid+0.5;
+            if ((stroke_alpha[x-x1] < 1.0) &&
+                (distance <= ((alpha+0.25)*(alpha+0.25))))
+              {
+                alpha=mid-0.5;
+                if (distance <= ((alpha+0.25)*(alpha+0.25)))
+                  stroke_alpha[x-x1]=1.0;
+                else
+                  {
+                    beta=1.0;
+                    if (fabs(distance-1.0) >= MagickEpsilon)
+                      beta=sqrt((double) distance);
+                    alpha=beta-mid-0.5;
+                    if (stroke_alpha[x-x1] < ((alpha-0.25)*(alpha-0.25)))
+                      stroke_alpha[x-x1]=(alpha-0.25)*(alpha-0.25);
+                  }
+              }
+          }
+        if ((fill == MagickFalse) || (distance > 1.0) ||
+            (*subpath_alpha >= 1.0))
           continue;
-        }
-      if (distance > 1.0)
-        continue;
-      if (fabs(beta) < MagickEpsilon)
-        {
-          beta=1.0;
-          if (fabs(distance-1.0) >= MagickEpsilon)
-            beta=sqrt(distance);
-        }
-      alpha=beta-1.0;
-      if (subpath_alpha < (alpha*alpha))
-        subpath_alpha=alpha*alpha;
+        if (distance <= 0.0)
+          {
+            *subpath_alpha=1.0;
+            continue;
+          }
+        if (fabs(beta) < MagickEpsilon)
+          {
+            beta=1.0;
+            if (fabs(distance-1.0) >= MagickEpsilon)
+              beta=sqrt(distance);
+          }
+        alpha=beta-1.0;
+        if (*subpath_alpha < (alpha*alpha))
+          *subpath_alpha=alpha*alpha;
+      }
     }
   }
   /*
     Compute fill opacity.
   */
   if (fill == MagickFalse)
-    return(0.0);
-  if (subpath_alpha >= 1.0)
-    return(1.0);
+    return;
   /*
-    Determine winding number.
+    Determine winding number: an edge counts for pixels right of its bounds
+    and, within its bounds, for pixels right of the segment crossing y.
   */
-  winding_number=0;
+  (void) memset(winding,0,(size_t) (x2-x1+2)*sizeof(*winding));
   p=polygon_info->edges;
   for (j=0; j < (ssize_t) polygon_info->number_edges; j++, p++)
   {
+    ssize_t
+      direction;
+
     if ((double) y <= p->bounds.y1)
       break;
-    if (((double) y > p->bounds.y2) || ((double) x <= p->bounds.x1))
+    if ((double) y > p->bounds.y2)
       continue;
-    if ((double) x > p->bounds.x2)
-      {
-        winding_number+=p->direction != 0 ? 1 : -1;
-        continue;
-      }
+    direction=p->direction != 0 ? 1 : -1;
     i=(ssize_t) MagickMax((double) p->highwater,1.0);
     for ( ; i < (ssize_t) (p->number_points-1); i++)
       if ((double) y <= p->points[i].y)
         break;
     q=p->points+i-1;
-    if ((((q+1)->x-q->x)*(y-q->y)) <= (((q+1)->y-q->y)*(x-q->x)))
-      winding_number+=p->direction != 0 ? 1 : -1;
+    lo=MagickMax(CastDoubleToSsizeT(floor(p->bounds.x1))+1,x1);
+    hi=CastDoubleToSsizeT(floor(p->bounds.x2));
+    for (x=lo; x <= MagickMin(hi,x2); x++)
+      if ((((q+1)->x-q->x)*(y-q->y)) <= (((q+1)->y-q->y)*(x-q->x)))
+        {
+          winding[x-x1]+=direction;
+          winding[x-x1+1]-=direction;
+        }
+    if (hi < x2)
+      winding[MagickMax(hi+1,lo)-x1]+=direction;
+  }
+  winding_number=0;
+  for (x=x1; x <= x2; x++)
+  {
+    winding_number+=winding[x-x1];
+    if (fill_alpha[x-x1] >= 1.0)
+      continue;
+    if (fill_rule != NonZeroRule)
+      {
+        if ((MagickAbsoluteValue(winding_number) & 0x01) != 0)
+          fill_alpha[x-x1]=1.0;
+      }
+    else
+      if (MagickAbsoluteValue(winding_number) != 0)
+        fill_alpha[x-x1]=1.0;
   }
-  if (fill_rule != NonZeroRule)
-    {
-      if ((MagickAbsoluteValue(winding_number) & 0x01) != 0)
-        return(1.0);
-    }
-  else
-    if (MagickAbsoluteValue(winding_number) != 0)
-      return(1.0);
-  return(subpath_alpha);
 }
 
 static MagickBooleanType DrawPolygonPrimitive(Image *image,
@@ -5007,6 +5041,7 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     *artifact;
 
   double
+    *alpha_tls,
     mid;
 
   EdgeInfo
@@ -5026,10 +5061,12 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     bounds;
 
   size_t
-    number_threads;
+    number_threads,
+    width;
 
   ssize_t
     i,
+    *winding_tls,
     y;
 
   assert(image != (Image *) NULL);
@@ -5156,6 +5193,22 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
   /*
     Draw polygon or line.
   */
+  width=(size_t) (poly_extent.x2-poly_extent.x1+1);
+  alpha_tls=(double *) AcquireQuantumMemory(2*number_threads*width,
+    sizeof(*alpha_tls));
+  winding_tls=(ssize_t *) AcquireQuantumMemory(number_threads*(width+1),
+    sizeof(*winding_tls));
+  if ((alpha_tls == (double *) NULL) || (winding_tls == (ssize_t *) NULL))
+    {
+      if (winding_tls != (ssize_t *) NULL)
+        winding_tls=(ssize_t *) RelinquishMagickMemory(winding_tls);
+      if (alpha_tls != (double *) NULL)
+        alpha_tls=(double *) RelinquishMagickMemory(alpha_tls);
+      image_view=DestroyCacheView(image_view);
+      polygon_info=DestroyPolygonTLS(polygon_info);
+      ThrowBinaryException(ResourceLimitError,"MemoryAllocationFailed",
+        image->filename);
+    }
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
   #pragma omp parallel for schedule(static) shared(status) \
     num_threads((int) number_threads)
@@ -5165,6 +5218,10 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     const int
       id = GetOpenMPThreadId();
 
+    double
+      *fill_alphas,
+      *stroke_alphas;
+
     Quantum
       *magick_restrict q;
 
@@ -5180,6 +5237,11 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
         status=MagickFalse;
         continue;
       }
+    fill_alphas=alpha_tls+2*(size_t) id*width;
+    stroke_alphas=fill_alphas+width;
+    GetScanlineAlpha(polygon_info[id],mid,fill,draw_info->fill_rule,
+      poly_extent.x1,poly_extent.x2,y,fill_alphas,stroke_alphas,winding_tls+
+      (size_t) id*(width+1));
     for (x=poly_extent.x1; x <= poly_extent.x2; x++)
     {
       double
@@ -5193,8 +5255,8 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
       /*
         Fill and/or stroke.
       */
-      fill_alpha=GetFillAlpha(polygon_info[id],mid,fill,draw_info->fill_rule,
-        x,y,&stroke_alpha);
+      fill_alpha=fill_alphas[x-poly_extent.x1];
+      stroke_alpha=stroke_alphas[x-poly_extent.x1];
       if (draw_info->stroke_antialias == MagickFalse)
         {
           fill_alpha=fill_alpha >= AntialiasThreshold ? 1.0 : 0.0;
@@ -5213,6 +5275,8 @@ static MagickBooleanType DrawPolygonPrimitive(Image *image,
     if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
       status=MagickFalse;
   }
+  winding_tls=(ssize_t *) RelinquishMagickMemory(winding_tls);
+  alpha_tls=(double *) RelinquishMagickMemory(alpha_tls);
   image_view=DestroyCacheView(image_view);
   polygon_info=DestroyPolygonTLS(polygon_info);
   if (draw_info->debug != MagickFalse)
@@ -405,6 +405,9 @@ static void InterpolateCLAHE(const RectangleInfo *clahe_info,const size_t *Q12,
   const size_t *Q22,const size_t *Q11,const size_t *Q21,
   const RectangleInfo *tile,const unsigned short *lut,unsigned short *pixels)
 {
+  double
+    scale;
+
   ssize_t
     y;
 
@@ -414,6 +417,7 @@ static void InterpolateCLAHE(const RectangleInfo *clahe_info,const size_t *Q12,
   /*
     Bilinear interpolate four tiles to eliminate boundary artifacts.
   */
+  scale=MagickSafeReciprocal((double) tile->width*tile->height);
   for (y=(ssize_t) tile->height; y > 0; y--)
   {
     ssize_t
@@ -422,15 +426,27 @@ static void InterpolateCLAHE(const RectangleInfo *clahe_info,const size_t *Q12,
     for (x=(ssize_t) tile->width; x > 0; x--)
     {
       intensity=lut[*pixels];
-      *pixels++=(unsigned short) (MagickSafeReciprocal((double) tile->width*
-        tile->height)*(y*((double) x*Q12[intensity]+((double) tile->width-x)*
-        Q22[intensity])+((double) tile->height-y)*((double) x*Q11[intensity]+
-        ((double) tile->width-x)*Q21[intensity])));
+      *pixels++=(unsigned short) (scale*(y*((double) x*Q12[intensity]+
+        ((double) tile->width-x)*Q22[intensity])+((double) tile->height-y)*
+        ((double) x*Q11[intensity]+((double) tile->width-x)*Q21[intensity])));
     }
     pixels+=(clahe_info->width-tile->width);
   }
 }
 
+static void LogCLAHEStage(const Image *image,const char *stage,
+  TimerInfo *timer)
+{
+  /*
+    Report the time spent in a CLAHE stage and restart the stopwatch.
+  */
+  if (IsEventLogging() != MagickFalse)
+    (void) LogMagickEvent(TraceEvent,GetMagickModule(),
+      "%s: CLAHE %s %.6fs (user %.6fs)",image->filename,stage,
+      GetElapsedTime(timer),GetUserTime(timer));
+  StartTimer(timer,MagickTrue);
+}
+
 static void GenerateCLAHELut(const RangeInfo *range_info,
   const size_t number_bins,unsigned short *lut)
 {
@@ -472,9 +488,10 @@ static void MapCLAHEHistogram(const RangeInfo *range_info,
   }
 }
 
-static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
-  const RectangleInfo *tile_info,const RangeInfo *range_info,
-  const size_t number_bins,const double clip_limit,unsigned short *pixels)
+static MagickBooleanType CLAHE(const Image *image,
+  const RectangleInfo *clahe_info,const RectangleInfo *tile_info,
+  const RangeInfo *range_info,const size_t number_bins,const double clip_limit,
+  unsigned short *pixels,TimerInfo *timer)
 {
   MemoryInfo
     *tile_cache;
@@ -484,11 +501,11 @@ static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
     *tiles;
 
   ssize_t
-    y;
+    i,
+    number_tiles;
 
   unsigned short
-    *lut,
-    *p;
+    *lut;
 
   /*
     Contrast limited adapted histogram equalization.
@@ -511,35 +528,54 @@ static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
   if (limit < 1UL)
     limit=1UL;
   /*
-    Generate greylevel mappings for each tile.
+    Generate greylevel mappings for each tile, the tiles are independent.
   */
   GenerateCLAHELut(range_info,number_bins,lut);
-  p=pixels;
-  for (y=0; y < (ssize_t) clahe_info->y; y++)
+  number_tiles=clahe_info->x*clahe_info->y;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) \
+    magick_number_threads(image,image,clahe_info->height,1)
+#endif
+  for (i=0; i < number_tiles; i++)
   {
+    size_t
+      *histogram;
+
     ssize_t
-      x;
+      x,
+      y;
 
-    for (x=0; x < (ssize_t) clahe_info->x; x++)
-    {
-      size_t
-        *histogram;
-
-      histogram=tiles+((ssize_t) number_bins*(y*clahe_info->x+x));
-      GenerateCLAHEHistogram(clahe_info,tile_info,number_bins,lut,p,histogram);
-      ClipCLAHEHistogram((double) limit,number_bins,histogram);
-      MapCLAHEHistogram(range_info,number_bins,tile_info->width*
-        tile_info->height,histogram);
-      p+=(ptrdiff_t) tile_info->width;
-    }
-    p+=CastDoubleToPtrdiffT((double) clahe_info->width*(tile_info->height-1));
+    unsigned short
+      *p;
+
+    x=i % clahe_info->x;
+    y=i/clahe_info->x;
+    p=pixels+CastDoubleToPtrdiffT((double) clahe_info->width*y*
+      tile_info->height+x*(ssize_t) tile_info->width);
+    histogram=tiles+((ssize_t) number_bins*i);
+    GenerateCLAHEHistogram(clahe_info,tile_info,number_bins,lut,p,histogram);
+    ClipCLAHEHistogram((double) limit,number_bins,histogram);
+    MapCLAHEHistogram(range_info,number_bins,tile_info->width*
+      tile_info->height,histogram);
   }
+  LogCLAHEStage(image,"histograms",timer);
   /*
-    Interpolate greylevel mappings to get CLAHE image.
+    Interpolate greylevel mappings to get CLAHE image, each interpolation
+    tile updates its own pixels.
   */
-  p=pixels;
-  for (y=0; y <= (ssize_t) clahe_info->y; y++)
+  number_tiles=(clahe_info->x+1)*(clahe_info->y+1);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) \
+    magick_number_threads(image,image,clahe_info->height,1)
+#endif
+  for (i=0; i < number_tiles; i++)
   {
+    double
+      Q11,
+      Q12,
+      Q21,
+      Q22;
+
     OffsetInfo
       offset;
 
@@ -547,11 +583,17 @@ static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
       tile;
 
     ssize_t
-      x;
+      columns,
+      rows,
+      x,
+      y;
 
+    x=i % (clahe_info->x+1);
+    y=i/(clahe_info->x+1);
     tile.height=tile_info->height;
     tile.y=y-1;
     offset.y=tile.y+1;
+    rows=(ssize_t) (tile_info->height >> 1)+(y-1)*(ssize_t) tile_info->height;
     if (y == 0)
       {
         /*
@@ -560,6 +602,7 @@ static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
         tile.height=tile_info->height >> 1;
         tile.y=0;
         offset.y=0;
+        rows=0;
       }
     else
       if (y == (ssize_t) clahe_info->y)
@@ -571,47 +614,40 @@ static MagickBooleanType CLAHE(const RectangleInfo *clahe_info,
           tile.y=clahe_info->y-1;
           offset.y=tile.y;
         }
-    for (x=0; x <= (ssize_t) clahe_info->x; x++)
-    {
-      double
-        Q11,
-        Q12,
-        Q21,
-        Q22;
-
-      tile.width=tile_info->width;
-      tile.x=x-1;
-      offset.x=tile.x+1;
-      if (x == 0)
+    tile.width=tile_info->width;
+    tile.x=x-1;
+    offset.x=tile.x+1;
+    columns=(ssize_t) (tile_info->width >> 1)+(x-1)*(ssize_t) tile_info->width;
+    if (x == 0)
+      {
+        /*
+          Left column.
+        */
+        tile.width=tile_info->width >> 1;
+        tile.x=0;
+        offset.x=0;
+        columns=0;
+      }
+    else
+      if (x == (ssize_t) clahe_info->x)
         {
           /*
-            Left column.
+            Right column.
           */
-          tile.width=tile_info->width >> 1;
-          tile.x=0;
-          offset.x=0;
+          tile.width=(tile_info->width+1) >> 1;
+          tile.x=clahe_info->x-1;
+          offset.x=tile.x;
         }
-      else
-        if (x == (ssize_t) clahe_info->x)
-          {
-            /*
-              Right column.
-            */
-            tile.width=(tile_info->width+1) >> 1;
-            tile.x=clahe_info->x-1;
-            offset.x=tile.x;
-          }
-      Q12=(double) number_bins*(tile.y*clahe_info->x+tile.x);
-      Q22=(double) number_bins*(tile.y*clahe_info->x+offset.x);
-      Q11=(double) number_bins*(offset.y*clahe_info->x+tile.x);
-      Q21=(double) number_bins*(offset.y*clahe_info->x+offset.x);
-      InterpolateCLAHE(clahe_info,tiles+CastDoubleToPtrdiffT(Q12),
-        tiles+CastDoubleToPtrdiffT(Q22),tiles+CastDoubleToPtrdiffT(Q11),
-        tiles+CastDoubleToPtrdiffT(Q21),&tile,lut,p);
-      p+=(ptrdiff_t) tile.width;
-    }
-    p+=CastDoubleToPtrdiffT((double) clahe_info->width*(tile.height-1));
+    Q12=(double) number_bins*(tile.y*clahe_info->x+tile.x);
+    Q22=(double) number_bins*(tile.y*clahe_info->x+offset.x);
+    Q11=(double) number_bins*(offset.y*clahe_info->x+tile.x);
+    Q21=(double) number_bins*(offset.y*clahe_info->x+offset.x);
+    InterpolateCLAHE(clahe_info,tiles+CastDoubleToPtrdiffT(Q12),
+      tiles+CastDoubleToPtrdiffT(Q22),tiles+CastDoubleToPtrdiffT(Q11),
+      tiles+CastDoubleToPtrdiffT(Q21),&tile,lut,pixels+CastDoubleToPtrdiffT(
+      (double) clahe_info->width*rows+columns));
   }
+  LogCLAHEStage(image,"interpolation",timer);
   lut=(unsigned short *) RelinquishMagickMemory(lut);
   tile_cache=RelinquishVirtualMemory(tile_cache);
   return(MagickTrue);
@@ -645,12 +681,12 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
     clahe_info,
     tile_info;
 
-  size_t
-    n;
-
   ssize_t
     y;
 
+  TimerInfo
+    timer;
+
   unsigned short
     *pixels;
 
@@ -698,15 +734,22 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
   /*
     Initialize CLAHE pixels.
   */
+  GetTimerInfo(&timer);
   image_view=AcquireVirtualCacheView(image,exception);
   progress=0;
   status=MagickTrue;
-  n=0;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) shared(progress,status) \
+    magick_number_threads(image,image,clahe_info.height,1)
+#endif
   for (y=0; y < (ssize_t) clahe_info.height; y++)
   {
     const Quantum
       *magick_restrict p;
 
+    size_t
+      n;
+
     ssize_t
       x;
 
@@ -719,6 +762,7 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
         status=MagickFalse;
         continue;
       }
+    n=clahe_info.width*(size_t) y;
     for (x=0; x < (ssize_t) clahe_info.width; x++)
     {
       pixels[n++]=ScaleQuantumToShort(p[0]);
@@ -729,6 +773,9 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
         MagickBooleanType
           proceed;
 
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+        #pragma omp atomic
+#endif
         progress++;
         proceed=SetImageProgress(image,CLAHEImageTag,progress,2*
           GetPixelChannels(image));
@@ -737,8 +784,9 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
       }
   }
   image_view=DestroyCacheView(image_view);
-  status=CLAHE(&clahe_info,&tile_info,&range_info,number_bins == 0 ?
-    (size_t) 128 : MagickMin(number_bins,256),clip_limit,pixels);
+  LogCLAHEStage(image,"initialization",&timer);
+  status=CLAHE(image,&clahe_info,&tile_info,&range_info,number_bins == 0 ?
+    (size_t) 128 : MagickMin(number_bins,256),clip_limit,pixels,&timer);
   if (status == MagickFalse)
     (void) ThrowMagickException(exception,GetMagickModule(),
       ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
@@ -746,12 +794,18 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
     Push CLAHE pixels to CLAHE image.
   */
   image_view=AcquireAuthenticCacheView(image,exception);
-  n=clahe_info.width*(size_t) (tile_info.y/2);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) shared(progress,status) \
+    magick_number_threads(image,image,image->rows,1)
+#endif
   for (y=0; y < (ssize_t) image->rows; y++)
   {
     Quantum
       *magick_restrict q;
 
+    size_t
+      n;
+
     ssize_t
       x;
 
@@ -763,14 +817,12 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
         status=MagickFalse;
         continue;
       }
-    n+=(size_t) (tile_info.x/2);
+    n=clahe_info.width*(size_t) (y+tile_info.y/2)+(size_t) (tile_info.x/2);
     for (x=0; x < (ssize_t) image->columns; x++)
     {
       q[0]=ScaleShortToQuantum(pixels[n++]);
       q+=(ptrdiff_t) GetPixelChannels(image);
     }
-    n+=(size_t) ((ssize_t) clahe_info.width-(ssize_t) image->columns-
-      (tile_info.x/2));
     if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
       status=MagickFalse;
     if (image->progress_monitor != (MagickProgressMonitor) NULL)
@@ -778,6 +830,9 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
         MagickBooleanType
           proceed;
 
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+        #pragma omp atomic
+#endif
         progress++;
         proceed=SetImageProgress(image,CLAHEImageTag,progress,2*
           GetPixelChannels(image));
@@ -786,6 +841,7 @@ MagickExport MagickBooleanType CLAHEImage(Image *image,const size_t width,
       }
   }
   image_view=DestroyCacheView(image_view);
+  LogCLAHEStage(image,"update",&timer);
   pixel_cache=RelinquishVirtualMemory(pixel_cache);
   if (TransformImageColorspace(image,colorspace,exception) == MagickFalse)
     status=MagickFalse;
@@ -57,14 +57,17 @@
 #include "MagickCore/prepress.h"
 #include "MagickCore/quantize.h"
 #include "MagickCore/registry.h"
+#include "MagickCore/resource_.h"
 #include "MagickCore/semaphore.h"
 #include "MagickCore/splay-tree.h"
 #include "MagickCore/statistic.h"
 #include "MagickCore/string_.h"
+#include "MagickCore/thread-private.h"
 
 /*
   Define declarations.
 */
+#define ClassifyBandExtent  1048576
 #define MaxTreeDepth  8
 #define HNodesInAList  1536
 
@@ -124,6 +127,7 @@ typedef struct _HCubeInfo
   Forward declarations.
 */
 static HCubeInfo
+  *DestroyHCubeInfo(const Image *,HCubeInfo *),
   *GetHCubeInfo(void);
 
 static HNodeInfo
@@ -160,19 +164,12 @@ static void
 %
 */
 
-static inline size_t ColorToNodeId(const PixelInfo *pixel,size_t index)
+static inline size_t ColorToNodeId(const unsigned char *magick_restrict color,
+  const size_t index)
 {
-  size_t
-    id;
-
-  id=(size_t) (
-    ((ScaleQuantumToChar(ClampToQuantum(pixel->red)) >> index) & 0x01) |
-    ((ScaleQuantumToChar(ClampToQuantum(pixel->green)) >> index) & 0x01) << 1 |
-    ((ScaleQuantumToChar(ClampToQuantum(pixel->blue)) >> index) & 0x01) << 2);
-  if (pixel->alpha_trait != UndefinedPixelTrait)
-    id|=((size_t) ((ScaleQuantumToChar(ClampToQuantum(pixel->alpha)) >> index) &
-      0x01) << 3);
-  return(id);
+  return((size_t) (((color[0] >> index) & 0x01) |
+    ((color[1] >> index) & 0x01) << 1 | ((color[2] >> index) & 0x01) << 2 |
+    ((color[3] >> index) & 0x01) << 3));
 }
 
 static inline MagickBooleanType IsPixelInfoColorMatch(
@@ -202,9 +199,111 @@ static inline MagickBooleanType IsPixelInfoColorMatch(
   return(MagickTrue);
 }
 
+static MagickBooleanType InsertHCubeColor(HCubeInfo *cube_info,
+  const PixelInfo *pixel,const MagickSizeType count)
+{
+  HNodeInfo
+    *node_info;
 
-static HCubeInfo *ClassifyImageColors(const Image *image,
-  ExceptionInfo *exception)
+  size_t
+    id,
+    index,
+    level;
+
+  ssize_t
+    i;
+
+  unsigned char
+    color[4];
+
+  /*
+    Start at the root and proceed level by level.
+  */
+  color[0]=ScaleQuantumToChar(ClampToQuantum(pixel->red));
+  color[1]=ScaleQuantumToChar(ClampToQuantum(pixel->green));
+  color[2]=ScaleQuantumToChar(ClampToQuantum(pixel->blue));
+  color[3]=0;
+  if (pixel->alpha_trait != UndefinedPixelTrait)
+    color[3]=ScaleQuantumToChar(ClampToQuantum(pixel->alpha));
+  node_info=cube_info->root;
+  index=MaxTreeDepth-1;
+  for (level=1; level < MaxTreeDepth; level++)
+  {
+    id=ColorToNodeId(color,index);
+    if (node_info->child[id] == (HNodeInfo *) NULL)
+      {
+        node_info->child[id]=GetHNodeInfo(cube_info,level);
+        if (node_info->child[id] == (HNodeInfo *) NULL)
+          return(MagickFalse);
+      }
+    node_info=node_info->child[id];
+    index--;
+  }
+  for (i=0; i < (ssize_t) node_info->number_unique; i++)
+    if (IsPixelInfoColorMatch(pixel,node_info->list+i) != MagickFalse)
+      {
+        node_info->list[i].count+=count;
+        return(MagickTrue);
+      }
+  /*
+    Add this unique color to the color list.
+  */
+  if (node_info->number_unique == 0)
+    {
+      node_info->extent=1;
+      node_info->list=(PixelInfo *) AcquireQuantumMemory(node_info->extent,
+        sizeof(*node_info->list));
+    }
+  else
+    if (i >= (ssize_t) node_info->extent)
+      {
+        node_info->extent<<=1;
+        node_info->list=(PixelInfo *) ResizeQuantumMemory(node_info->list,
+          node_info->extent,sizeof(*node_info->list));
+      }
+  if (node_info->list == (PixelInfo *) NULL)
+    {
+      node_info->number_unique=0;
+      return(MagickFalse);
+    }
+  node_info->list[i]=(*pixel);
+  node_info->list[i].count=count;
+  node_info->number_unique++;
+  cube_info->colors++;
+  return(MagickTrue);
+}
+
+static MagickBooleanType MergeHCubeInfo(const Image *image,
+  HCubeInfo *cube_info,const HNodeInfo *node_info,const size_t max_colors)
+{
+  ssize_t
+    i;
+
+  size_t
+    number_children;
+
+  /*
+    Add the colors of a band's tree in their order of first appearance.
+  */
+  number_children=image->alpha_trait == UndefinedPixelTrait ? 8UL : 16UL;
+  for (i=0; i < (ssize_t) number_children; i++)
+    if (node_info->child[i] != (HNodeInfo *) NULL)
+      if (MergeHCubeInfo(image,cube_info,node_info->child[i],max_colors) ==
+          MagickFalse)
+        return(MagickFalse);
+  for (i=0; i < (ssize_t) node_info->number_unique; i++)
+  {
+    if (InsertHCubeColor(cube_info,node_info->list+i,
+        node_info->list[i].count) == MagickFalse)
+      return(MagickFalse);
+    if ((max_colors != 0) && (cube_info->colors > max_colors))
+      return(MagickFalse);
+  }
+  return(MagickTrue);
+}
+
+static MagickBooleanType ClassifyImageBands(const Image *image,
+  HCubeInfo *cube_info,const size_t max_colors,ExceptionInfo *exception)
 {
 #define EvaluateImageTag  "  Compute image colors...  "
 
@@ -212,124 +311,165 @@ static HCubeInfo *ClassifyImageColors(const Image *image,
     *image_view;
 
   HCubeInfo
-    *cube_info;
+    **band_info;
 
   MagickBooleanType
-    proceed;
-
-  PixelInfo
-    pixel;
-
-  HNodeInfo
-    *node_info;
-
-  const Quantum
-    *p;
+    status;
 
   size_t
-    id,
-    index,
-    level;
+    number_bands,
+    rows;
 
   ssize_t
     i,
-    x;
-
-  ssize_t
-    y;
+    n;
 
   /*
-    Initialize color description tree.
+    Classify bands of rows into partial trees in parallel, then merge them in
+    row order so each color list keeps the order the colors first appear in.
+    A max_colors other than zero stops as soon as any band, or the merged
+    tree, has more unique colors than that.
   */
-  assert(image != (const Image *) NULL);
-  assert(image->signature == MagickCoreSignature);
-  if (IsEventLogging() != MagickFalse)
-    (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",image->filename);
-  cube_info=GetHCubeInfo();
-  if (cube_info == (HCubeInfo *) NULL)
+  number_bands=MagickMax((size_t) GetMagickResourceLimit(ThreadResource),1);
+  rows=MagickMax((image->rows+number_bands-1)/number_bands,
+    ClassifyBandExtent/MagickMax(image->columns,1));
+  rows=MagickMax(rows,1);
+  n=(ssize_t) ((image->rows+rows-1)/rows);
+  band_info=(HCubeInfo **) AcquireQuantumMemory((size_t) MagickMax(n,1),
+    sizeof(*band_info));
+  if (band_info == (HCubeInfo **) NULL)
     {
       (void) ThrowMagickException(exception,GetMagickModule(),
         ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
-      return(cube_info);
+      return(MagickFalse);
     }
-  GetPixelInfo(image,&pixel);
+  (void) memset(band_info,0,(size_t) MagickMax(n,1)*sizeof(*band_info));
+  status=MagickTrue;
   image_view=AcquireVirtualCacheView(image,exception);
-  for (y=0; y < (ssize_t) image->rows; y++)
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) shared(status) \
+    magick_number_threads(image,image,image->rows,1)
+#endif
+  for (i=0; i < n; i++)
   {
-    p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
-    if (p == (const Quantum *) NULL)
-      break;
-    for (x=0; x < (ssize_t) image->columns; x++)
+    PixelInfo
+      pixel;
+
+    ssize_t
+      y;
+
+    if (status == MagickFalse)
+      continue;
+    band_info[i]=GetHCubeInfo();
+    if (band_info[i] == (HCubeInfo *) NULL)
+      {
+        (void) ThrowMagickException(exception,GetMagickModule(),
+          ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+        status=MagickFalse;
+        continue;
+      }
+    GetPixelInfo(image,&pixel);
+    for (y=i*(ssize_t) rows; y < MagickMin((i+1)*(ssize_t) rows,
+         (ssize_t) image->rows); y++)
     {
-      /*
-        Start at the root and proceed level by level.
-      */
-      node_info=cube_info->root;
-      index=MaxTreeDepth-1;
-      for (level=1; level < MaxTreeDepth; level++)
+      const Quantum
+        *magick_restrict p;
+
+      ssize_t
+        x;
+
+      if (status == MagickFalse)
+        break;
+      p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
+      if (p == (const Quantum *) NULL)
+        {
+          status=MagickFalse;
+          break;
+        }
+      for (x=0; x < (ssize_t) image->columns; x++)
       {
         GetPixelInfoPixel(image,p,&pixel);
-        id=ColorToNodeId(&pixel,index);
-        if (node_info->child[id] == (HNodeInfo *) NULL)
+        if (InsertHCubeColor(band_info[i],&pixel,1) == MagickFalse)
           {
-            node_info->child[id]=GetHNodeInfo(cube_info,level);
-            if (node_info->child[id] == (HNodeInfo *) NULL)
-              {
-                (void) ThrowMagickException(exception,GetMagickModule(),
-                  ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                  image->filename);
-                return(0);
-              }
+            (void) ThrowMagickException(exception,GetMagickModule(),
+              ResourceLimitError,"MemoryAllocationFailed","`%s'",
+              image->filename);
+            status=MagickFalse;
+            break;
+          }
+        if ((max_colors != 0) && (band_info[i]->colors > max_colors))
+          {
+            status=MagickFalse;
+            break;
           }
-        node_info=node_info->child[id];
-        index--;
+        p+=(ptrdiff_t) GetPixelChannels(image);
       }
-      for (i=0; i < (ssize_t) node_info->number_unique; i++)
-        if (IsPixelInfoColorMatch(&pixel,node_info->list+i) != MagickFalse)
-          break;
-      if (i < (ssize_t) node_info->number_unique)
-        node_info->list[i].count++;
-      else
-        {
-          if (node_info->number_unique == 0)
-            {
-              node_info->extent=1;
-              node_info->list=(PixelInfo *) AcquireQuantumMemory(
-                node_info->extent,sizeof(*node_info->list));
-            }
-          else
-            if (i >= (ssize_t) node_info->extent)
-              {
-                node_info->extent<<=1;
-                node_info->list=(PixelInfo *) ResizeQuantumMemory(
-                  node_info->list,node_info->extent,sizeof(*node_info->list));
-              }
-          if (node_info->list == (PixelInfo *) NULL)
-            {
-              (void) ThrowMagickException(exception,GetMagickModule(),
-                ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                image->filename);
-              return(0);
-            }
-          node_info->list[i]=pixel;
-          node_info->list[i].red=(double) GetPixelRed(image,p);
-          node_info->list[i].green=(double) GetPixelGreen(image,p);
-          node_info->list[i].blue=(double) GetPixelBlue(image,p);
-          if (image->colorspace == CMYKColorspace)
-            node_info->list[i].black=(double) GetPixelBlack(image,p);
-          node_info->list[i].alpha=(double) GetPixelAlpha(image,p);
-          node_info->list[i].count=1;
-          node_info->number_unique++;
-          cube_info->colors++;
-        }
-      p+=(ptrdiff_t) GetPixelChannels(image);
     }
-    proceed=SetImageProgress(image,EvaluateImageTag,(MagickOffsetType) y,
-      image->rows);
-    if (proceed == MagickFalse)
-      break;
   }
   image_view=DestroyCacheView(image_view);
+  for (i=0; i < n; i++)
+  {
+    if (band_info[i] == (HCubeInfo *) NULL)
+      continue;
+    if ((status != MagickFalse) && (cube_info->colors == 0))
+      {
+        HCubeInfo
+          swap;
+
+        /*
+          The first band becomes the tree, there is nothing to merge it with.
+        */
+        swap=(*cube_info);
+        *cube_info=(*band_info[i]);
+        *band_info[i]=swap;
+      }
+    else
+      if ((status != MagickFalse) && (MergeHCubeInfo(image,cube_info,
+           band_info[i]->root,max_colors) == MagickFalse))
+        {
+          if ((max_colors == 0) || (cube_info->colors <= max_colors))
+            (void) ThrowMagickException(exception,GetMagickModule(),
+              ResourceLimitError,"MemoryAllocationFailed","`%s'",
+              image->filename);
+          status=MagickFalse;
+        }
+    band_info[i]=DestroyHCubeInfo(image,band_info[i]);
+    if ((status != MagickFalse) && (max_colors == 0))
+      {
+        MagickBooleanType
+          proceed;
+
+        proceed=SetImageProgress(image,EvaluateImageTag,(MagickOffsetType)
+          MagickMin((i+1)*(ssize_t) rows,(ssize_t) image->rows)-1,image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
+  }
+  band_info=(HCubeInfo **) RelinquishMagickMemory(band_info);
+  return(status);
+}
+
+static HCubeInfo *ClassifyImageColors(const Image *image,
+  ExceptionInfo *exception)
+{
+  HCubeInfo
+    *cube_info;
+
+  /*
+    Initialize color description tree.
+  */
+  assert(image != (const Image *) NULL);
+  assert(image->signature == MagickCoreSignature);
+  if (IsEventLogging() != MagickFalse)
+    (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",image->filename);
+  cube_info=GetHCubeInfo();
+  if (cube_info == (HCubeInfo *) NULL)
+    {
+      (void) ThrowMagickException(exception,GetMagickModule(),
+        ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
+      return(cube_info);
+    }
+  (void) ClassifyImageBands(image,cube_info,0,exception);
   return(cube_info);
 }
 
@@ -670,30 +810,11 @@ static HNodeInfo *GetHNodeInfo(HCubeInfo *cube_info,const size_t level)
 static MagickBooleanType CheckImageColors(const Image *image,
   const size_t max_colors,ExceptionInfo *exception)
 {
-  CacheView
-    *image_view;
-
-  const Quantum
-    *p;
-
   HCubeInfo
     *cube_info;
 
-  HNodeInfo
-    *node_info;
-
-  PixelInfo
-    pixel,
-    target;
-
-  size_t
-    id,
-    index,
-    level;
-
-  ssize_t
-    i,
-    y;
+  MagickBooleanType
+    status;
 
   if (image->storage_class == PseudoClass)
     return((image->colors <= max_colors) ? MagickTrue : MagickFalse);
@@ -707,91 +828,9 @@ static MagickBooleanType CheckImageColors(const Image *image,
         ResourceLimitError,"MemoryAllocationFailed","`%s'",image->filename);
       return(MagickFalse);
     }
-  GetPixelInfo(image,&pixel);
-  GetPixelInfo(image,&target);
-  image_view=AcquireVirtualCacheView(image,exception);
-  for (y=0; y < (ssize_t) image->rows; y++)
-  {
-    ssize_t
-      x;
-
-    p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
-    if (p == (const Quantum *) NULL)
-      break;
-    for (x=0; x < (ssize_t) image->columns; x++)
-    {
-      /*
-        Start at the root and proceed level by level.
-      */
-      node_info=cube_info->root;
-      index=MaxTreeDepth-1;
-      for (level=1; level < MaxTreeDepth; level++)
-      {
-        GetPixelInfoPixel(image,p,&pixel);
-        id=ColorToNodeId(&pixel,index);
-        if (node_info->child[id] == (HNodeInfo *) NULL)
-          {
-            node_info->child[id]=GetHNodeInfo(cube_info,level);
-            if (node_info->child[id] == (HNodeInfo *) NULL)
-              {
-                (void) ThrowMagickException(exception,GetMagickModule(),
-                  ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                  image->filename);
-                break;
-              }
-          }
-        node_info=node_info->child[id];
-        index--;
-      }
-      if (level < MaxTreeDepth)
-        break;
-      for (i=0; i < (ssize_t) node_info->number_unique; i++)
-      {
-        target=node_info->list[i];
-        if (IsPixelInfoColorMatch(&pixel,&target) != MagickFalse)
-          break;
-      }
-      if (i < (ssize_t) node_info->number_unique)
-        node_info->list[i].count++;
-      else
-        {
-          /*
-            Add this unique color to the color list.
-          */
-          if (node_info->list == (PixelInfo *) NULL)
-            node_info->list=(PixelInfo *) AcquireQuantumMemory(1,
-              sizeof(*node_info->list));
-          else
-            node_info->list=(PixelInfo *) ResizeQuantumMemory(node_info->list,
-              (size_t) (i+1),sizeof(*node_info->list));
-          if (node_info->list == (PixelInfo *) NULL)
-            {
-              (void) ThrowMagickException(exception,GetMagickModule(),
-                ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                image->filename);
-              break;
-            }
-          GetPixelInfo(image,&node_info->list[i]);
-          node_info->list[i].red=(double) GetPixelRed(image,p);
-          node_info->list[i].green=(double) GetPixelGreen(image,p);
-          node_info->list[i].blue=(double) GetPixelBlue(image,p);
-          if (image->colorspace == CMYKColorspace)
-            node_info->list[i].black=(double) GetPixelBlack(image,p);
-          node_info->list[i].alpha=(double) GetPixelAlpha(image,p);
-          node_info->list[i].count=1;
-          node_info->number_unique++;
-          cube_info->colors++;
-          if (cube_info->colors > max_colors)
-            break;
-        }
-      p+=(ptrdiff_t) GetPixelChannels(image);
-    }
-    if (x < (ssize_t) image->columns)
-      break;
-  }
-  image_view=DestroyCacheView(image_view);
+  status=ClassifyImageBands(image,cube_info,max_colors,exception);
   cube_info=DestroyHCubeInfo(image,cube_info);
-  return(y < (ssize_t) image->rows ? MagickFalse : MagickTrue);
+  return(status);
 }
 
 MagickExport MagickBooleanType IdentifyPaletteImage(const Image *image,
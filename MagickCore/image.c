@@ -2292,6 +2292,8 @@ MagickExport MagickBooleanType ResetImagePixels(Image *image,
   assert(image->signature == MagickCoreSignature);
   if (IsEventLogging() != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"...");
+  if (GetImagePixelCacheType(image) == PingCache)
+    return(MagickTrue);
   pixels=AcquirePixelCachePixels(image,&length,exception);
   if (pixels != (void *) NULL)
     {
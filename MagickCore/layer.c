@@ -41,6 +41,7 @@
 #include "MagickCore/artifact.h"
 #include "MagickCore/attribute.h"
 #include "MagickCore/cache.h"
+#include "MagickCore/cache-view.h"
 #include "MagickCore/channel.h"
 #include "MagickCore/color.h"
 #include "MagickCore/color-private.h"
@@ -615,51 +616,109 @@ static MagickBooleanType ComparePixels(const LayerMethod method,
 %
 */
 
+static inline MagickBooleanType IsLayerPixelChanged(const LayerMethod method,
+  const Image *alpha_image,const Quantum *magick_restrict p,
+  const Image *beta_image,const Quantum *magick_restrict q,
+  PixelInfo *alpha_pixel,PixelInfo *beta_pixel)
+{
+  /*
+    Identical pixels never differ, whatever the method or fuzz.
+  */
+  if ((GetPixelRed(alpha_image,p) == GetPixelRed(beta_image,q)) &&
+      (GetPixelGreen(alpha_image,p) == GetPixelGreen(beta_image,q)) &&
+      (GetPixelBlue(alpha_image,p) == GetPixelBlue(beta_image,q)) &&
+      (GetPixelBlack(alpha_image,p) == GetPixelBlack(beta_image,q)) &&
+      (GetPixelAlpha(alpha_image,p) == GetPixelAlpha(beta_image,q)))
+    return(MagickFalse);
+  GetPixelInfoPixel(alpha_image,p,alpha_pixel);
+  GetPixelInfoPixel(beta_image,q,beta_pixel);
+  return(ComparePixels(method,alpha_pixel,beta_pixel));
+}
+
 static RectangleInfo CompareImagesBounds(const Image *alpha_image,
   const Image *beta_image,const LayerMethod method,ExceptionInfo *exception)
 {
-  const Quantum
-    *p,
-    *q;
-
-  PixelInfo
-    alpha_pixel,
-    beta_pixel;
+  CacheView
+    *alpha_view,
+    *beta_view;
 
   RectangleInfo
     bounds;
 
   ssize_t
-    x,
     y;
 
   /*
-    Set bounding box of the differences between images.
+    Set bounding box of the differences between images.  Each row is
+    scanned from both ends in parallel, only up to its first difference.
   */
   if (IsEventLogging() != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",
       alpha_image->filename);
-  GetPixelInfo(alpha_image,&alpha_pixel);
-  GetPixelInfo(beta_image,&beta_pixel);
-  for (x=0; x < (ssize_t) alpha_image->columns; x++)
+  bounds.x=(ssize_t) alpha_image->columns;
+  bounds.y=(ssize_t) alpha_image->rows;
+  bounds.width=0;
+  bounds.height=0;
+  alpha_view=AcquireVirtualCacheView(alpha_image,exception);
+  beta_view=AcquireVirtualCacheView(beta_image,exception);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) shared(bounds) \
+    magick_number_threads(alpha_image,beta_image,alpha_image->rows,2)
+#endif
+  for (y=0; y < (ssize_t) alpha_image->rows; y++)
   {
-    p=GetVirtualPixels(alpha_image,x,0,1,alpha_image->rows,exception);
-    q=GetVirtualPixels(beta_image,x,0,1,beta_image->rows,exception);
-    if ((p == (const Quantum *) NULL) || (q == (Quantum *) NULL))
-      break;
-    for (y=0; y < (ssize_t) alpha_image->rows; y++)
-    {
-      GetPixelInfoPixel(alpha_image,p,&alpha_pixel);
-      GetPixelInfoPixel(beta_image,q,&beta_pixel);
-      if (ComparePixels(method,&alpha_pixel,&beta_pixel) != MagickFalse)
+    const Quantum
+      *magick_restrict p,
+      *magick_restrict q;
+
+    PixelInfo
+      alpha_pixel,
+      beta_pixel;
+
+    ssize_t
+      x,
+      x_offset;
+
+    p=GetCacheViewVirtualPixels(alpha_view,0,y,alpha_image->columns,1,
+      exception);
+    q=GetCacheViewVirtualPixels(beta_view,0,y,alpha_image->columns,1,
+      exception);
+    if ((p == (const Quantum *) NULL) || (q == (const Quantum *) NULL))
+      continue;
+    GetPixelInfo(alpha_image,&alpha_pixel);
+    GetPixelInfo(beta_image,&beta_pixel);
+    for (x=0; x < (ssize_t) alpha_image->columns; x++)
+      if (IsLayerPixelChanged(method,alpha_image,p+x*(ssize_t)
+          GetPixelChannels(alpha_image),beta_image,q+x*(ssize_t)
+          GetPixelChannels(beta_image),&alpha_pixel,&beta_pixel) != MagickFalse)
+        break;
+    if (x >= (ssize_t) alpha_image->columns)
+      continue;
+    for (x_offset=(ssize_t) alpha_image->columns-1; x_offset > x; x_offset--)
+      if (IsLayerPixelChanged(method,alpha_image,p+x_offset*(ssize_t)
+          GetPixelChannels(alpha_image),beta_image,q+x_offset*(ssize_t)
+          GetPixelChannels(beta_image),&alpha_pixel,&beta_pixel) != MagickFalse)
         break;
-      p+=(ptrdiff_t) GetPixelChannels(alpha_image);
-      q+=(ptrdiff_t) GetPixelChannels(beta_image);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+    #pragma omp critical (MagickCore_CompareImagesBounds)
+#endif
+    {
+      /*
+        Width and height hold the right and bottom edges until the end.
+      */
+      if (x < bounds.x)
+        bounds.x=x;
+      if ((size_t) x_offset >= bounds.width)
+        bounds.width=(size_t) x_offset+1;
+      if (y < bounds.y)
+        bounds.y=y;
+      if ((size_t) y >= bounds.height)
+        bounds.height=(size_t) y+1;
     }
-    if (y < (ssize_t) alpha_image->rows)
-      break;
   }
-  if (x >= (ssize_t) alpha_image->columns)
+  beta_view=DestroyCacheView(beta_view);
+  alpha_view=DestroyCacheView(alpha_view);
+  if (bounds.width == 0)
     {
       /*
         Images are identical, return a null image.
@@ -670,64 +729,8 @@ static RectangleInfo CompareImagesBounds(const Image *alpha_image,
       bounds.height=1;
       return(bounds);
     }
-  bounds.x=x;
-  for (x=(ssize_t) alpha_image->columns-1; x >= 0; x--)
-  {
-    p=GetVirtualPixels(alpha_image,x,0,1,alpha_image->rows,exception);
-    q=GetVirtualPixels(beta_image,x,0,1,beta_image->rows,exception);
-    if ((p == (const Quantum *) NULL) || (q == (Quantum *) NULL))
-      break;
-    for (y=0; y < (ssize_t) alpha_image->rows; y++)
-    {
-      GetPixelInfoPixel(alpha_image,p,&alpha_pixel);
-      GetPixelInfoPixel(beta_image,q,&beta_pixel);
-      if (ComparePixels(method,&alpha_pixel,&beta_pixel) != MagickFalse)
-        break;
-      p+=(ptrdiff_t) GetPixelChannels(alpha_image);
-      q+=(ptrdiff_t) GetPixelChannels(beta_image);
-    }
-    if (y < (ssize_t) alpha_image->rows)
-      break;
-  }
-  bounds.width=(size_t) (x-bounds.x+1);
-  for (y=0; y < (ssize_t) alpha_image->rows; y++)
-  {
-    p=GetVirtualPixels(alpha_image,0,y,alpha_image->columns,1,exception);
-    q=GetVirtualPixels(beta_image,0,y,beta_image->columns,1,exception);
-    if ((p == (const Quantum *) NULL) || (q == (Quantum *) NULL))
-      break;
-    for (x=0; x < (ssize_t) alpha_image->columns; x++)
-    {
-      GetPixelInfoPixel(alpha_image,p,&alpha_pixel);
-      GetPixelInfoPixel(beta_image,q,&beta_pixel);
-      if (ComparePixels(method,&alpha_pixel,&beta_pixel) != MagickFalse)
-        break;
-      p+=(ptrdiff_t) GetPixelChannels(alpha_image);
-      q+=(ptrdiff_t) GetPixelChannels(beta_image);
-    }
-    if (x < (ssize_t) alpha_image->columns)
-      break;
-  }
-  bounds.y=y;
-  for (y=(ssize_t) alpha_image->rows-1; y >= 0; y--)
-  {
-    p=GetVirtualPixels(alpha_image,0,y,alpha_image->columns,1,exception);
-    q=GetVirtualPixels(beta_image,0,y,beta_image->columns,1,exception);
-    if ((p == (const Quantum *) NULL) || (q == (Quantum *) NULL))
-      break;
-    for (x=0; x < (ssize_t) alpha_image->columns; x++)
-    {
-      GetPixelInfoPixel(alpha_image,p,&alpha_pixel);
-      GetPixelInfoPixel(beta_image,q,&beta_pixel);
-      if (ComparePixels(method,&alpha_pixel,&beta_pixel) != MagickFalse)
-        break;
-      p+=(ptrdiff_t) GetPixelChannels(alpha_image);
-      q+=(ptrdiff_t) GetPixelChannels(beta_image);
-    }
-    if (x < (ssize_t) alpha_image->columns)
-      break;
-  }
-  bounds.height=(size_t) (y-bounds.y+1);
+  bounds.width-=(size_t) bounds.x;
+  bounds.height-=(size_t) bounds.y;
   return(bounds);
 }
 
@@ -86,6 +86,17 @@ typedef struct _MagicMapInfo
     skip_spaces;
 } MagicMapInfo;
 
+typedef struct _MagicIndexInfo
+{
+  MagickOffsetType
+    offset;
+
+  size_t
+    buckets[257],
+    number_entries,
+    *entries;
+} MagicIndexInfo;
+
 struct _MagicInfo
 {
   char
@@ -120,13 +131,21 @@ static const MagicMapInfo
     MagickCoderHeader("ILBM", 8, "ILBM")
   };
 
+static const MagicInfo
+  **magic_table = (const MagicInfo **) NULL;
+
 static LinkedListInfo
-  *magic_cache = (LinkedListInfo *) NULL,
   *magic_list = (LinkedListInfo *) NULL;
 
+static MagicIndexInfo
+  *magic_index = (MagicIndexInfo *) NULL;
+
 static SemaphoreInfo
-  *magic_cache_semaphore = (SemaphoreInfo *) NULL,
   *magic_list_semaphore = (SemaphoreInfo *) NULL;
+
+static size_t
+  number_indexes = 0,
+  number_magic = 0;
 
 /*
   Forward declarations.
@@ -231,6 +250,135 @@ static LinkedListInfo *AcquireMagicList(ExceptionInfo *exception)
   }
   return(list);
 }
+
+static void DestroyMagicIndex(void)
+{
+  ssize_t
+    i;
+
+  if (magic_index != (MagicIndexInfo *) NULL)
+    {
+      for (i=0; i < (ssize_t) number_indexes; i++)
+        if (magic_index[i].entries != (size_t *) NULL)
+          magic_index[i].entries=(size_t *) RelinquishMagickMemory(
+            magic_index[i].entries);
+      magic_index=(MagicIndexInfo *) RelinquishMagickMemory(magic_index);
+    }
+  if (magic_table != (const MagicInfo **) NULL)
+    magic_table=(const MagicInfo **) RelinquishMagickMemory((void *)
+      magic_table);
+  number_indexes=0;
+  number_magic=0;
+}
+
+static MagickBooleanType AcquireMagicIndex(LinkedListInfo *list)
+{
+  ElementInfo
+    *p;
+
+  MagicIndexInfo
+    *index;
+
+  size_t
+    cursor[256];
+
+  ssize_t
+    i,
+    j,
+    k;
+
+  /*
+    Compile the magic list into one index per distinct offset.  Magic that
+    may be preceded by white space cannot be bucketed and is kept in a final
+    index that is always searched.
+  */
+  number_magic=GetNumberOfElementsInLinkedList(list);
+  if (number_magic == 0)
+    return(MagickTrue);
+  magic_table=(const MagicInfo **) AcquireQuantumMemory(number_magic,
+    sizeof(*magic_table));
+  magic_index=(MagicIndexInfo *) AcquireQuantumMemory(number_magic+1,
+    sizeof(*magic_index));
+  if ((magic_table == (const MagicInfo **) NULL) ||
+      (magic_index == (MagicIndexInfo *) NULL))
+    {
+      DestroyMagicIndex();
+      return(MagickFalse);
+    }
+  (void) memset(magic_index,0,(number_magic+1)*sizeof(*magic_index));
+  p=GetHeadElementInLinkedList(list);
+  for (i=0; p != (ElementInfo *) NULL; p=p->next)
+  {
+    const MagicInfo
+      *magic_info;
+
+    MagickOffsetType
+      offset;
+
+    magic_info=(const MagicInfo *) p->value;
+    magic_table[i++]=magic_info;
+    offset=magic_info->offset;
+    if ((magic_info->skip_spaces != MagickFalse) || (magic_info->length == 0))
+      offset=(-1);
+    for (j=0; j < (ssize_t) number_indexes; j++)
+      if (magic_index[j].offset == offset)
+        break;
+    if (j == (ssize_t) number_indexes)
+      magic_index[number_indexes++].offset=offset;
+    index=magic_index+j;
+    index->number_entries++;
+    if (offset >= 0)
+      index->buckets[magic_info->magic[0]+1]++;
+  }
+  /*
+    Move the unbucketed index last, it costs the most to search.
+  */
+  for (j=0; j < (ssize_t) number_indexes; j++)
+    if (magic_index[j].offset < 0)
+      {
+        MagicIndexInfo
+          swap;
+
+        swap=magic_index[j];
+        magic_index[j]=magic_index[number_indexes-1];
+        magic_index[number_indexes-1]=swap;
+        break;
+      }
+  for (j=0; j < (ssize_t) number_indexes; j++)
+  {
+    index=magic_index+j;
+    index->entries=(size_t *) AcquireQuantumMemory(index->number_entries,
+      sizeof(*index->entries));
+    if (index->entries == (size_t *) NULL)
+      {
+        DestroyMagicIndex();
+        return(MagickFalse);
+      }
+    for (k=0; k < 256; k++)
+      index->buckets[k+1]+=index->buckets[k];
+    (void) memcpy(cursor,index->buckets,sizeof(cursor));
+    for (i=0; i < (ssize_t) number_magic; i++)
+    {
+      const MagicInfo
+        *magic_info;
+
+      MagickOffsetType
+        offset;
+
+      magic_info=magic_table[i];
+      offset=magic_info->offset;
+      if ((magic_info->skip_spaces != MagickFalse) || (magic_info->length == 0))
+        offset=(-1);
+      if (offset != index->offset)
+        continue;
+      if (offset < 0)
+        index->entries[cursor[0]++]=(size_t) i;
+      else
+        index->entries[cursor[magic_info->magic[0]]++]=(size_t) i;
+    }
+  }
+  return(MagickTrue);
+}
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -286,83 +434,61 @@ static inline MagickBooleanType CompareMagic(const unsigned char *magic,
   return(MagickFalse);
 }
 
-static MagickBooleanType IsMagicCacheInstantiated(void)
-{
-  if (magic_cache == (LinkedListInfo *) NULL)
-    {
-      if (magic_cache_semaphore == (SemaphoreInfo *) NULL)
-        ActivateSemaphoreInfo(&magic_cache_semaphore);
-      LockSemaphoreInfo(magic_cache_semaphore);
-      if (magic_cache == (LinkedListInfo *) NULL)
-        magic_cache=NewLinkedList(0);
-      UnlockSemaphoreInfo(magic_cache_semaphore);
-    }
-  return(magic_cache != (LinkedListInfo *) NULL ? MagickTrue : MagickFalse);
-}
-
 MagickExport const MagicInfo *GetMagicInfo(const unsigned char *magic,
   const size_t length,ExceptionInfo *exception)
 {
-  const MagicInfo *
-    magic_info;
+  const MagicIndexInfo
+    *index;
 
-  ElementInfo
-    *p;
+  size_t
+    first,
+    last,
+    match;
+
+  ssize_t
+    i,
+    j;
 
   assert(exception != (ExceptionInfo *) NULL);
   if (IsMagicListInstantiated(exception) == MagickFalse)
     return((const MagicInfo *) NULL);
-  if (IsMagicCacheInstantiated() == MagickFalse)
+  if (number_magic == 0)
     return((const MagicInfo *) NULL);
+  if (magic == (const unsigned char *) NULL)
+    return(magic_table[0]);
   /*
-    Search for cached entries.
+    Search for magic tag.  Each index holds the entries at one offset,
+    bucketed by their first byte, so only plausible candidates are compared.
+    The entries are in list order and the earliest match wins.
   */
-  magic_info=(const MagicInfo *) NULL;
-  if (magic != (const unsigned char *) NULL)
-    {
-      LockSemaphoreInfo(magic_cache_semaphore);
-      p=GetHeadElementInLinkedList(magic_cache);
-      while (p != (ElementInfo *) NULL)
+  match=number_magic;
+  for (i=0; i < (ssize_t) number_indexes; i++)
+  {
+    index=magic_index+i;
+    first=0;
+    last=index->number_entries;
+    if (index->offset >= 0)
       {
-        magic_info=(const MagicInfo *) p->value;
-        if (CompareMagic(magic,length,magic_info) != MagickFalse)
-          break;
-        p=p->next;
+        if (index->offset >= (MagickOffsetType) length)
+          continue;
+        first=index->buckets[magic[index->offset]];
+        last=index->buckets[magic[index->offset]+1];
       }
-      UnlockSemaphoreInfo(magic_cache_semaphore);
-      if (p != (ElementInfo *) NULL)
-        return(magic_info);
-    }
-  /*
-    Search for magic tag.
-  */
-  LockSemaphoreInfo(magic_list_semaphore);
-  p=GetHeadElementInLinkedList(magic_list);
-  if (magic == (const unsigned char *) NULL)
+    for (j=(ssize_t) first; j < (ssize_t) last; j++)
     {
-      UnlockSemaphoreInfo(magic_list_semaphore);
-      if (p != (ElementInfo *) NULL)
-        magic_info=(const MagicInfo *) p->value;
-      return(magic_info);
+      if (index->entries[j] >= match)
+        break;
+      if (CompareMagic(magic,length,magic_table[index->entries[j]]) !=
+          MagickFalse)
+        {
+          match=index->entries[j];
+          break;
+        }
     }
-  while (p != (ElementInfo *) NULL)
-  {
-    magic_info=(const MagicInfo *) p->value;
-    if (CompareMagic(magic,length,magic_info) != MagickFalse)
-      break;
-    p=p->next;
   }
-  UnlockSemaphoreInfo(magic_list_semaphore);
-  if (p == (ElementInfo *) NULL)
-    magic_info=(const MagicInfo *) NULL;
-  else
-    {
-      LockSemaphoreInfo(magic_cache_semaphore);
-      (void) InsertValueInSortedLinkedList(magic_cache,CompareMagickInfoExtent,
-        NULL,magic_info);
-      UnlockSemaphoreInfo(magic_cache_semaphore);
-    }
-  return(magic_info);
+  if (match == number_magic)
+    return((const MagicInfo *) NULL);
+  return(magic_table[match]);
 }
 
 /*
@@ -678,7 +804,16 @@ static MagickBooleanType IsMagicListInstantiated(ExceptionInfo *exception)
         ActivateSemaphoreInfo(&magic_list_semaphore);
       LockSemaphoreInfo(magic_list_semaphore);
       if (magic_list == (LinkedListInfo *) NULL)
-        magic_list=AcquireMagicList(exception);
+        {
+          LinkedListInfo
+            *list;
+
+          list=AcquireMagicList(exception);
+          if (AcquireMagicIndex(list) == MagickFalse)
+            (void) ThrowMagickException(exception,GetMagickModule(),
+              ResourceLimitError,"MemoryAllocationFailed","`%s'","magic");
+          magic_list=list;
+        }
       UnlockSemaphoreInfo(magic_list_semaphore);
     }
   return(magic_list != (LinkedListInfo *) NULL ? MagickTrue : MagickFalse);
@@ -809,15 +944,9 @@ MagickPrivate void MagicComponentTerminus(void)
   if (magic_list_semaphore == (SemaphoreInfo *) NULL)
     ActivateSemaphoreInfo(&magic_list_semaphore);
   LockSemaphoreInfo(magic_list_semaphore);
+  DestroyMagicIndex();
   if (magic_list != (LinkedListInfo *) NULL)
     magic_list=DestroyLinkedList(magic_list,DestroyMagicElement);
   UnlockSemaphoreInfo(magic_list_semaphore);
   RelinquishSemaphoreInfo(&magic_list_semaphore);
-  if (magic_cache_semaphore == (SemaphoreInfo *) NULL)
-    ActivateSemaphoreInfo(&magic_cache_semaphore);
-  LockSemaphoreInfo(magic_cache_semaphore);
-  if (magic_cache != (LinkedListInfo *) NULL)
-    magic_cache=DestroyLinkedList(magic_cache,(void *(*)(void *)) NULL);
-  UnlockSemaphoreInfo(magic_cache_semaphore);
-  RelinquishSemaphoreInfo(&magic_cache_semaphore);
 }
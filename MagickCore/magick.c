@@ -77,6 +77,7 @@
 #include "MagickCore/resource-private.h"
 #include "MagickCore/policy.h"
 #include "MagickCore/policy-private.h"
+#include "MagickCore/profile-private.h"
 #include "MagickCore/mutex.h"
 #include "MagickCore/semaphore.h"
 #include "MagickCore/semaphore-private.h"
@@ -1583,6 +1584,7 @@ MagickExport void MagickCoreGenesis(const char *path,
   (void) TypeComponentGenesis();
   (void) MimeComponentGenesis();
   (void) AnnotateComponentGenesis();
+  (void) ProfileComponentGenesis();
 #if defined(MAGICKCORE_X11_DELEGATE)
   (void) XComponentGenesis();
 #endif
@@ -1643,6 +1645,7 @@ MagickExport void MagickCoreTerminus(void)
     }
   MonitorComponentTerminus();
   RegistryComponentTerminus();
+  ProfileComponentTerminus();
   AnnotateComponentTerminus();
   MimeComponentTerminus();
   TypeComponentTerminus();
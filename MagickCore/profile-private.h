@@ -27,12 +27,16 @@ extern "C" {
 extern MagickExport MagickBooleanType
   SetImageProfilePrivate(Image *,StringInfo *,ExceptionInfo *);
 
+extern MagickPrivate MagickBooleanType
+  ProfileComponentGenesis(void);
+
 extern MagickExport StringInfo
   *AcquireProfileStringInfo(const char *,const size_t length,ExceptionInfo *),
   *BlobToProfileStringInfo(const char *,const void *blob,const size_t length,
     ExceptionInfo *exception);
 
 extern MagickPrivate void
+  ProfileComponentTerminus(void),
   Update8BIMClipPath(const Image *,const size_t,const size_t,
     const RectangleInfo *),
   SyncImageProfiles(Image *);
@@ -62,6 +62,8 @@
 #include "MagickCore/quantum.h"
 #include "MagickCore/quantum-private.h"
 #include "MagickCore/resource_.h"
+#include "MagickCore/semaphore.h"
+#include "MagickCore/signature-private.h"
 #include "MagickCore/splay-tree.h"
 #include "MagickCore/string_.h"
 #include "MagickCore/string-private.h"
@@ -81,6 +83,13 @@
 #  include <libxml/tree.h>
 #endif
 
+#if defined(MAGICKCORE_LCMS_DELEGATE)
+/*
+  Define declarations.
+*/
+#define ProfileCacheMaximumTransforms  16
+#endif
+
 /*
   Forward declarations
 */
@@ -117,6 +126,33 @@ typedef struct _CMSExceptionInfo
   ExceptionInfo
     *exception;
 } CMSExceptionInfo;
+
+#if defined(MAGICKCORE_LCMS_DELEGATE)
+typedef struct _LCMSTransformInfo
+{
+  cmsContext
+    context;
+
+  cmsHTRANSFORM
+    transform;
+
+  CMSExceptionInfo
+    cms_exception;
+
+  size_t
+    reference_count;
+} LCMSTransformInfo;
+
+/*
+  Color transforms shared by all threads, keyed by profile digests, pixel
+  formats, intent, and flags.
+*/
+static SemaphoreInfo
+  *transform_semaphore = (SemaphoreInfo *) NULL;
+
+static SplayTreeInfo
+  *transform_cache = (SplayTreeInfo *) NULL;
+#endif
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -322,6 +358,64 @@ MagickExport char *GetNextImageProfile(const Image *image)
 %                                                                             %
 %                                                                             %
 %                                                                             %
++   P r o f i l e C o m p o n e n t G e n e s i s                             %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ProfileComponentGenesis() instantiates the profile component.
+%
+%  The format of the ProfileComponentGenesis method is:
+%
+%      MagickBooleanType ProfileComponentGenesis(void)
+%
+*/
+MagickPrivate MagickBooleanType ProfileComponentGenesis(void)
+{
+#if defined(MAGICKCORE_LCMS_DELEGATE)
+  if (transform_semaphore == (SemaphoreInfo *) NULL)
+    transform_semaphore=AcquireSemaphoreInfo();
+#endif
+  return(MagickTrue);
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
++   P r o f i l e C o m p o n e n t T e r m i n u s                           %
+%                                                                             %
+%                                                                             %
+%                                                                             %
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%
+%  ProfileComponentTerminus() destroys the profile component.
+%
+%  The format of the ProfileComponentTerminus method is:
+%
+%      ProfileComponentTerminus(void)
+%
+*/
+MagickPrivate void ProfileComponentTerminus(void)
+{
+#if defined(MAGICKCORE_LCMS_DELEGATE)
+  if (transform_semaphore == (SemaphoreInfo *) NULL)
+    ActivateSemaphoreInfo(&transform_semaphore);
+  LockSemaphoreInfo(transform_semaphore);
+  if (transform_cache != (SplayTreeInfo *) NULL)
+    transform_cache=DestroySplayTree(transform_cache);
+  UnlockSemaphoreInfo(transform_semaphore);
+  RelinquishSemaphoreInfo(&transform_semaphore);
+#endif
+}
+
+/*
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%                                                                             %
+%                                                                             %
+%                                                                             %
 %   P r o f i l e I m a g e                                                   %
 %                                                                             %
 %                                                                             %
@@ -456,47 +550,20 @@ static void **AcquirePixelTLS(const size_t columns,const size_t channels,
   return(pixels);
 }
 
-static cmsHTRANSFORM *DestroyTransformTLS(cmsHTRANSFORM *transform)
-{
-  ssize_t
-    i;
-
-  assert(transform != (cmsHTRANSFORM *) NULL);
-  for (i=0; i < (ssize_t) GetMagickResourceLimit(ThreadResource); i++)
-    if (transform[i] != (cmsHTRANSFORM) NULL)
-      cmsDeleteTransform(transform[i]);
-  transform=(cmsHTRANSFORM *) RelinquishMagickMemory(transform);
-  return(transform);
-}
-
-static cmsHTRANSFORM *AcquireTransformTLS(const LCMSInfo *source_info,
-  const LCMSInfo *target_info,const cmsUInt32Number flags,
-  cmsContext cms_context)
+static void *DestroyLCMSTransform(void *transform_info)
 {
-  cmsHTRANSFORM
-    *transform;
-
-  size_t
-    number_threads;
-
-  ssize_t
-    i;
+  LCMSTransformInfo
+    *p;
 
-  number_threads=(size_t) GetMagickResourceLimit(ThreadResource);
-  transform=(cmsHTRANSFORM *) AcquireQuantumMemory(number_threads,
-    sizeof(*transform));
-  if (transform == (cmsHTRANSFORM *) NULL)
-    return((cmsHTRANSFORM *) NULL);
-  (void) memset(transform,0,number_threads*sizeof(*transform));
-  for (i=0; i < (ssize_t) number_threads; i++)
-  {
-    transform[i]=cmsCreateTransformTHR(cms_context,source_info->profile,
-      source_info->type,target_info->profile,target_info->type,
-      (cmsUInt32Number) target_info->intent,flags);
-    if (transform[i] == (cmsHTRANSFORM) NULL)
-      return(DestroyTransformTLS(transform));
-  }
-  return(transform);
+  p=(LCMSTransformInfo *) transform_info;
+  if (p->transform != (cmsHTRANSFORM) NULL)
+    cmsDeleteTransform(p->transform);
+  if (p->context != (cmsContext) NULL)
+    cmsDeleteContext(p->context);
+  if (p->cms_exception.exception != (ExceptionInfo *) NULL)
+    p->cms_exception.exception=DestroyExceptionInfo(
+      p->cms_exception.exception);
+  return(RelinquishMagickMemory(p));
 }
 
 static void CMSExceptionHandler(cmsContext context,cmsUInt32Number severity,
@@ -521,7 +588,8 @@ static void CMSExceptionHandler(cmsContext context,cmsUInt32Number severity,
   if (image == (Image *) NULL)
     {
       (void) ThrowMagickException(exception,GetMagickModule(),ImageWarning,
-        "UnableToTransformColorspace","`%s'","unknown context");
+        "UnableToTransformColorspace","`%s', %s (#%u)","unknown context",
+        message != (char *) NULL ? message : "no message",severity);
       return;
     }
   if (image->debug != MagickFalse)
@@ -532,9 +600,157 @@ static void CMSExceptionHandler(cmsContext context,cmsUInt32Number severity,
     message != (char *) NULL ? message : "no message",severity);
 }
 
+static char *GetLCMSProfileDigest(const StringInfo *profile)
+{
+  char
+    *digest;
+
+  SignatureInfo
+    *signature_info;
+
+  if (profile == (const StringInfo *) NULL)
+    return(ConstantString("none"));
+  signature_info=AcquireSignatureInfo();
+  UpdateSignature(signature_info,profile);
+  FinalizeSignature(signature_info);
+  digest=StringInfoToHexString(GetSignatureDigest(signature_info));
+  signature_info=DestroySignatureInfo(signature_info);
+  return(digest);
+}
+
+static void GetLCMSTransformKey(const StringInfo *source_profile,
+  const StringInfo *target_profile,const LCMSInfo *source_info,
+  const LCMSInfo *target_info,const cmsUInt32Number flags,char *key)
+{
+  char
+    *source_digest,
+    *target_digest;
+
+  source_digest=GetLCMSProfileDigest(source_profile);
+  target_digest=GetLCMSProfileDigest(target_profile);
+  (void) FormatLocaleString(key,MagickPathExtent,"%s:%s:%x:%x:%d:%x",
+    source_digest,target_digest,(unsigned int) source_info->type,
+    (unsigned int) target_info->type,target_info->intent,(unsigned int) flags);
+  target_digest=DestroyString(target_digest);
+  source_digest=DestroyString(source_digest);
+}
+
+static void TrimLCMSTransformCache(void)
+{
+  char
+    key[MagickPathExtent];
+
+  const char
+    *p;
+
+  const LCMSTransformInfo
+    *transform_info;
+
+  /*
+    Drop unreferenced transforms until there is room for one more.
+  */
+  while (GetNumberOfNodesInSplayTree(transform_cache) >=
+         ProfileCacheMaximumTransforms)
+  {
+    ResetSplayTreeIterator(transform_cache);
+    p=(const char *) GetNextKeyInSplayTree(transform_cache);
+    while (p != (const char *) NULL)
+    {
+      transform_info=(const LCMSTransformInfo *) GetValueFromSplayTree(
+        transform_cache,p);
+      if (transform_info->reference_count == 0)
+        break;
+      p=(const char *) GetNextKeyInSplayTree(transform_cache);
+    }
+    if (p == (const char *) NULL)
+      break;
+    (void) CopyMagickString(key,p,MagickPathExtent);
+    (void) DeleteNodeFromSplayTree(transform_cache,key);
+  }
+}
+
+static LCMSTransformInfo *AcquireLCMSTransform(const char *key,
+  const LCMSInfo *source_info,const LCMSInfo *target_info,
+  const cmsUInt32Number flags,Image *image,ExceptionInfo *exception)
+{
+  LCMSTransformInfo
+    *cache_info,
+    *transform_info;
+
+  if (transform_semaphore == (SemaphoreInfo *) NULL)
+    ActivateSemaphoreInfo(&transform_semaphore);
+  LockSemaphoreInfo(transform_semaphore);
+  if (transform_cache == (SplayTreeInfo *) NULL)
+    transform_cache=NewSplayTree(CompareSplayTreeString,
+      RelinquishMagickMemory,DestroyLCMSTransform);
+  transform_info=(LCMSTransformInfo *) GetValueFromSplayTree(transform_cache,
+    key);
+  if (transform_info != (LCMSTransformInfo *) NULL)
+    transform_info->reference_count++;
+  UnlockSemaphoreInfo(transform_semaphore);
+  if (transform_info != (LCMSTransformInfo *) NULL)
+    return(transform_info);
+  /*
+    Create the transform outside the lock.  It outlives this call, so it gets
+    its own context; its errors collect in the transform's exception and are
+    passed on to each caller when it acquires or relinquishes the transform.
+  */
+  transform_info=(LCMSTransformInfo *) AcquireMagickMemory(
+    sizeof(*transform_info));
+  if (transform_info == (LCMSTransformInfo *) NULL)
+    return((LCMSTransformInfo *) NULL);
+  (void) memset(transform_info,0,sizeof(*transform_info));
+  transform_info->cms_exception.image=image;
+  transform_info->cms_exception.exception=AcquireExceptionInfo();
+  transform_info->context=cmsCreateContext(NULL,
+    &transform_info->cms_exception);
+  if (transform_info->context != (cmsContext) NULL)
+    {
+      cmsSetLogErrorHandlerTHR(transform_info->context,CMSExceptionHandler);
+      transform_info->transform=cmsCreateTransformTHR(transform_info->context,
+        source_info->profile,source_info->type,target_info->profile,
+        target_info->type,(cmsUInt32Number) target_info->intent,flags);
+    }
+  InheritException(exception,transform_info->cms_exception.exception);
+  ClearMagickException(transform_info->cms_exception.exception);
+  transform_info->cms_exception.image=(Image *) NULL;
+  if (transform_info->transform == (cmsHTRANSFORM) NULL)
+    return((LCMSTransformInfo *) DestroyLCMSTransform(transform_info));
+  transform_info->reference_count=1;
+  LockSemaphoreInfo(transform_semaphore);
+  cache_info=(LCMSTransformInfo *) GetValueFromSplayTree(transform_cache,key);
+  if (cache_info != (LCMSTransformInfo *) NULL)
+    {
+      /*
+        Another thread cached the same transform first.
+      */
+      cache_info->reference_count++;
+      UnlockSemaphoreInfo(transform_semaphore);
+      (void) DestroyLCMSTransform(transform_info);
+      return(cache_info);
+    }
+  TrimLCMSTransformCache();
+  (void) AddValueToSplayTree(transform_cache,ConstantString(key),
+    transform_info);
+  UnlockSemaphoreInfo(transform_semaphore);
+  return(transform_info);
+}
+
+static LCMSTransformInfo *RelinquishLCMSTransform(
+  LCMSTransformInfo *transform_info,ExceptionInfo *exception)
+{
+  LockSemaphoreInfo(transform_semaphore);
+  InheritException(exception,transform_info->cms_exception.exception);
+  ClearMagickException(transform_info->cms_exception.exception);
+  if (transform_info->reference_count > 0)
+    transform_info->reference_count--;
+  UnlockSemaphoreInfo(transform_semaphore);
+  return((LCMSTransformInfo *) NULL);
+}
+
 static void TransformDoublePixels(const int id,const Image* image,
   const LCMSInfo *source_info,const LCMSInfo *target_info,
-  const cmsHTRANSFORM *transform,Quantum *q)
+  const cmsHTRANSFORM transform,Quantum *q)
 {
 #define GetLCMSPixel(source_info,pixel,index) \
   (source_info->scale[index]*(((double) QuantumScale*(double) pixel)+ \
@@ -562,7 +778,7 @@ static void TransformDoublePixels(const int id,const Image* image,
       *p++=GetLCMSPixel(source_info,GetPixelBlack(image,q),3);
     q+=(ptrdiff_t) GetPixelChannels(image);
   }
-  cmsDoTransform(transform[id],source_info->pixels[id],target_info->pixels[id],
+  cmsDoTransform(transform,source_info->pixels[id],target_info->pixels[id],
     (unsigned int) image->columns);
   p=(double *) target_info->pixels[id];
   q-=GetPixelChannels(image)*image->columns;
@@ -591,7 +807,7 @@ static void TransformDoublePixels(const int id,const Image* image,
 
 static void TransformQuantumPixels(const int id,const Image* image,
   const LCMSInfo *source_info,const LCMSInfo *target_info,
-  const cmsHTRANSFORM *transform,Quantum *q)
+  const cmsHTRANSFORM transform,Quantum *q)
 {
   Quantum
     *p;
@@ -612,7 +828,7 @@ static void TransformQuantumPixels(const int id,const Image* image,
       *p++=GetPixelBlack(image,q);
     q+=(ptrdiff_t) GetPixelChannels(image);
   }
-  cmsDoTransform(transform[id],source_info->pixels[id],target_info->pixels[id],
+  cmsDoTransform(transform,source_info->pixels[id],target_info->pixels[id],
     (unsigned int) image->columns);
   p=(Quantum *) target_info->pixels[id];
   q-=GetPixelChannels(image)*image->columns;
@@ -1072,15 +1288,21 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
             CacheView
               *image_view;
 
+            char
+              key[MagickPathExtent];
+
             cmsColorSpaceSignature
               signature;
 
-            cmsHTRANSFORM
-              *magick_restrict transform;
-
             cmsUInt32Number
               flags;
 
+            const char
+              *artifact;
+
+            LCMSTransformInfo
+              *transform_info;
+
             MagickBooleanType
               highres;
 
@@ -1103,14 +1325,9 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
               }
             highres=MagickTrue;
 #if !defined(MAGICKCORE_HDRI_SUPPORT) || (MAGICKCORE_QUANTUM_DEPTH > 16)
-            {
-              const char
-                *artifact;
-
-              artifact=GetImageArtifact(image,"profile:highres-transform");
-              if (IsStringFalse(artifact) != MagickFalse)
-                highres=MagickFalse;
-            }
+            artifact=GetImageArtifact(image,"profile:highres-transform");
+            if (IsStringFalse(artifact) != MagickFalse)
+              highres=MagickFalse;
 #endif
             SetLCMSInfoScale(&source_info,1.0);
             SetLCMSInfoTranslate(&source_info,0.0);
@@ -1331,13 +1548,33 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
               }
             }
             flags=cmsFLAGS_HIGHRESPRECALC;
+            artifact=GetImageArtifact(image,"profile:grid-points");
+            if (artifact != (const char *) NULL)
+              {
+                ssize_t
+                  grid_points;
+
+                /*
+                  Precompute the transform as a lookup table of this many
+                  grid points per input channel.
+                */
+                grid_points=(ssize_t) StringToLong(artifact);
+                if ((grid_points >= 2) && (grid_points <= 255))
+                  flags=cmsFLAGS_GRIDPOINTS(grid_points);
+              }
 #if defined(cmsFLAGS_BLACKPOINTCOMPENSATION)
             if (image->black_point_compensation != MagickFalse)
               flags|=cmsFLAGS_BLACKPOINTCOMPENSATION;
 #endif
-            transform=AcquireTransformTLS(&source_info,&target_info,flags,
-              cms_context);
-            if (transform == (cmsHTRANSFORM *) NULL)
+            if (icc_profile != (StringInfo *) NULL)
+              GetLCMSTransformKey(icc_profile,profile,&source_info,
+                &target_info,flags,key);
+            else
+              GetLCMSTransformKey(profile,(const StringInfo *) NULL,
+                &source_info,&target_info,flags,key);
+            transform_info=AcquireLCMSTransform(key,&source_info,&target_info,
+              flags,image,exception);
+            if (transform_info == (LCMSTransformInfo *) NULL)
               ThrowProfileException(ImageError,"UnableToCreateColorTransform",
                 name);
             /*
@@ -1352,7 +1589,8 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
               {
                 target_info.pixels=DestroyPixelTLS(target_info.pixels);
                 source_info.pixels=DestroyPixelTLS(source_info.pixels);
-                transform=DestroyTransformTLS(transform);
+                transform_info=RelinquishLCMSTransform(transform_info,
+                  exception);
                 ThrowProfileException(ResourceLimitError,
                   "MemoryAllocationFailed",image->filename);
               }
@@ -1360,7 +1598,8 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
               {
                 target_info.pixels=DestroyPixelTLS(target_info.pixels);
                 source_info.pixels=DestroyPixelTLS(source_info.pixels);
-                transform=DestroyTransformTLS(transform);
+                transform_info=RelinquishLCMSTransform(transform_info,
+                  exception);
                 if (source_info.profile != (cmsHPROFILE) NULL)
                   (void) cmsCloseProfile(source_info.profile);
                 if (target_info.profile != (cmsHPROFILE) NULL)
@@ -1397,10 +1636,10 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
                 }
               if (highres != MagickFalse)
                 TransformDoublePixels(id,image,&source_info,&target_info,
-                  transform,q);
+                  transform_info->transform,q);
               else
                 TransformQuantumPixels(id,image,&source_info,&target_info,
-                  transform,q);
+                  transform_info->transform,q);
               sync=SyncCacheViewAuthenticPixels(image_view,exception);
               if (sync == MagickFalse)
                 status=MagickFalse;
@@ -1446,7 +1685,8 @@ MagickExport MagickBooleanType ProfileImage(Image *image,const char *name,
             }
             target_info.pixels=DestroyPixelTLS(target_info.pixels);
             source_info.pixels=DestroyPixelTLS(source_info.pixels);
-            transform=DestroyTransformTLS(transform);
+            transform_info=RelinquishLCMSTransform(transform_info,
+              exception);
             if ((status != MagickFalse) &&
                 (cmsGetDeviceClass(source_info.profile) != cmsSigLinkClass))
               status=SetImageProfilePrivate(image,profile,exception);
@@ -214,6 +214,9 @@
 #else
 #define CacheShift  3
 #endif
+#define ClassifyBandExtent  1048576
+#define ColorCacheLength  4096
+#define ColorKeysThreshold  16
 #define ErrorQueueLength  16
 #define ErrorRelativeWeight  MagickSafeReciprocal(16)
 #define MaxQNodes  266817
@@ -249,10 +252,30 @@ typedef struct _QNodeInfo
 
   size_t
     color_number,
+    first_color,
     id,
-    level;
+    level,
+    number_colors;
 } QNodeInfo;
 
+typedef struct _QColorKey
+{
+  double
+    red;
+
+  size_t
+    color_number;
+} QColorKey;
+
+typedef struct _QCacheInfo
+{
+  DoublePixelPacket
+    target;
+
+  size_t
+    color_number;
+} QCacheInfo;
+
 typedef struct _QNodes
 {
   QNodeInfo
@@ -302,6 +325,12 @@ typedef struct _QCubeInfo
   ssize_t
     *cache;
 
+  QColorKey
+    *color_keys;
+
+  size_t
+    number_keys;
+
   DoublePixelPacket
     error[ErrorQueueLength];
 
@@ -498,6 +527,98 @@ static inline size_t ColorToQNodeId(const QCubeInfo *cube_info,
   return(id);
 }
 
+static int ColorKeyCompare(const void *x,const void *y)
+{
+  const QColorKey
+    *p,
+    *q;
+
+  p=(const QColorKey *) x;
+  q=(const QColorKey *) y;
+  if (p->red < q->red)
+    return(-1);
+  if (p->red > q->red)
+    return(1);
+  if (p->color_number < q->color_number)
+    return(-1);
+  return(p->color_number > q->color_number ? 1 : 0);
+}
+
+static void SortColorKeys(const Image *image,QCubeInfo *cube_info,
+  const QNodeInfo *node_info)
+{
+  QColorKey
+    *keys;
+
+  size_t
+    number_children;
+
+  ssize_t
+    i;
+
+  if (node_info->number_colors < ColorKeysThreshold)
+    return;
+  keys=cube_info->color_keys+node_info->level*cube_info->number_keys+
+    node_info->first_color;
+  for (i=0; i < (ssize_t) node_info->number_colors; i++)
+  {
+    const PixelInfo
+      *p;
+
+    double
+      alpha;
+
+    keys[i].color_number=node_info->first_color+(size_t) i;
+    p=image->colormap+keys[i].color_number;
+    alpha=1.0;
+    if (cube_info->associate_alpha != MagickFalse)
+      alpha=(MagickRealType) (QuantumScale*p->alpha);
+    keys[i].red=alpha*p->red;
+  }
+  qsort(keys,node_info->number_colors,sizeof(*keys),ColorKeyCompare);
+  number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
+  for (i=0; i < (ssize_t) number_children; i++)
+    if (node_info->child[i] != (QNodeInfo *) NULL)
+      SortColorKeys(image,cube_info,node_info->child[i]);
+}
+
+static void SetColorKeys(const Image *image,QCubeInfo *cube_info)
+{
+  /*
+    For each subtree with enough colors, keep its colormap entries sorted by
+    red so ClosestColor() need not visit every one of them.  Subtrees on the
+    same tree level never overlap, so one row of keys per level suffices.
+  */
+  if (cube_info->color_keys != (QColorKey *) NULL)
+    cube_info->color_keys=(QColorKey *) RelinquishMagickMemory(
+      cube_info->color_keys);
+  cube_info->number_keys=image->colors;
+  if (image->colors < ColorKeysThreshold)
+    return;
+  cube_info->color_keys=(QColorKey *) AcquireQuantumMemory((MaxTreeDepth+1)*
+    image->colors,sizeof(*cube_info->color_keys));
+  if (cube_info->color_keys == (QColorKey *) NULL)
+    return;
+  SortColorKeys(image,cube_info,cube_info->root);
+}
+
+static inline size_t ColorCacheOffset(const DoublePixelPacket *pixel)
+{
+  MagickSizeType
+    bits,
+    hash;
+
+  (void) memcpy(&bits,&pixel->red,sizeof(bits));
+  hash=bits*0x9e3779b97f4a7c15ULL;
+  (void) memcpy(&bits,&pixel->green,sizeof(bits));
+  hash=(hash ^ bits)*0x9e3779b97f4a7c15ULL;
+  (void) memcpy(&bits,&pixel->blue,sizeof(bits));
+  hash=(hash ^ bits)*0x9e3779b97f4a7c15ULL;
+  (void) memcpy(&bits,&pixel->alpha,sizeof(bits));
+  hash=(hash ^ bits)*0x9e3779b97f4a7c15ULL;
+  return((size_t) (hash >> 40) & (ColorCacheLength-1));
+}
+
 static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
   ExceptionInfo *exception)
 {
@@ -520,6 +641,7 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
   cube_info->transparent_index=(-1);
   if (SetImageColormap(image,cube_info,exception) == MagickFalse)
     return(MagickFalse);
+  SetColorKeys(image,cube_info);
   /*
     Create a reduced color image.
   */
@@ -533,6 +655,22 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
       MagickBooleanType
         status;
 
+      QCacheInfo
+        *color_cache;
+
+      size_t
+        number_threads;
+
+      /*
+        Each thread remembers the closest color of recently seen pixels.  The
+        targets start out as NaN, which never compare equal.
+      */
+      number_threads=(size_t) GetMagickResourceLimit(ThreadResource);
+      color_cache=(QCacheInfo *) AcquireQuantumMemory(number_threads*
+        ColorCacheLength,sizeof(*color_cache));
+      if (color_cache != (QCacheInfo *) NULL)
+        (void) memset(color_cache,0xff,number_threads*ColorCacheLength*
+          sizeof(*color_cache));
       status=MagickTrue;
       image_view=AcquireAuthenticCacheView(image,exception);
 #if defined(MAGICKCORE_OPENMP_SUPPORT)
@@ -541,6 +679,12 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
 #endif
       for (y=0; y < (ssize_t) image->rows; y++)
       {
+        const int
+          id = GetOpenMPThreadId();
+
+        QCacheInfo
+          *magick_restrict cache_info;
+
         QCubeInfo
           cube;
 
@@ -561,6 +705,9 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
             continue;
           }
         cube=(*cube_info);
+        cache_info=(QCacheInfo *) NULL;
+        if (color_cache != (QCacheInfo *) NULL)
+          cache_info=color_cache+id*ColorCacheLength;
         for (x=0; x < (ssize_t) image->columns; x+=count)
         {
           DoublePixelPacket
@@ -569,12 +716,15 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
           const QNodeInfo
             *node_info;
 
+          QCacheInfo
+            *magick_restrict entry;
+
           ssize_t
             i;
 
           size_t
-            id,
-            index;
+            index,
+            node_id;
 
           /*
             Identify the deepest node containing the pixel's color.
@@ -590,22 +740,40 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
               break;
           }
           AssociateAlphaPixel(image,&cube,q,&pixel);
-          node_info=cube.root;
-          for (index=MaxTreeDepth-1; (ssize_t) index > 0; index--)
-          {
-            id=ColorToQNodeId(&cube,&pixel,index);
-            if (node_info->child[id] == (QNodeInfo *) NULL)
-              break;
-            node_info=node_info->child[id];
-          }
-          /*
-            Find closest color among siblings and their children.
-          */
-          cube.target=pixel;
-          cube.distance=(double) (4.0*((double) QuantumRange+1.0)*
-            ((double) QuantumRange+1.0)+1.0);
-          ClosestColor(image,&cube,node_info->parent);
-          index=cube.color_number;
+          entry=(QCacheInfo *) NULL;
+          if (cache_info != (QCacheInfo *) NULL)
+            entry=cache_info+ColorCacheOffset(&pixel);
+          if ((entry != (QCacheInfo *) NULL) &&
+              (entry->target.red == pixel.red) &&
+              (entry->target.green == pixel.green) &&
+              (entry->target.blue == pixel.blue) &&
+              (entry->target.alpha == pixel.alpha))
+            index=entry->color_number;
+          else
+            {
+              node_info=cube.root;
+              for (index=MaxTreeDepth-1; (ssize_t) index > 0; index--)
+              {
+                node_id=ColorToQNodeId(&cube,&pixel,index);
+                if (node_info->child[node_id] == (QNodeInfo *) NULL)
+                  break;
+                node_info=node_info->child[node_id];
+              }
+              /*
+                Find closest color among siblings and their children.
+              */
+              cube.target=pixel;
+              cube.distance=(double) (4.0*((double) QuantumRange+1.0)*
+                ((double) QuantumRange+1.0)+1.0);
+              ClosestColor(image,&cube,node_info->parent);
+              index=cube.color_number;
+              if ((entry != (QCacheInfo *) NULL) &&
+                  (node_info->parent->number_colors != 0))
+                {
+                  entry->target=pixel;
+                  entry->color_number=index;
+                }
+            }
           for (i=0; i < (ssize_t) count; i++)
           {
             if (image->storage_class == PseudoClass)
@@ -639,6 +807,8 @@ static MagickBooleanType AssignImageColors(Image *image,QCubeInfo *cube_info,
           }
       }
       image_view=DestroyCacheView(image_view);
+      if (color_cache != (QCacheInfo *) NULL)
+        color_cache=(QCacheInfo *) RelinquishMagickMemory(color_cache);
     }
   if (cube_info->quantize_info->measure_error != MagickFalse)
     (void) GetImageQuantizeError(image,exception);
@@ -752,14 +922,50 @@ static inline void SetAssociatedAlpha(const Image *image,QCubeInfo *cube_info)
   cube_info->associate_alpha=associate_alpha;
 }
 
-static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
-  const Image *image,ExceptionInfo *exception)
+static QCubeInfo *DestroyQCubeBand(QCubeInfo *band_info)
 {
-#define ClassifyImageTag  "Classify/Image"
+  QNodes
+    *nodes;
 
-  CacheView
-    *image_view;
+  while (band_info->node_queue != (QNodes *) NULL)
+  {
+    nodes=band_info->node_queue->next;
+    band_info->node_queue->nodes=(QNodeInfo *) RelinquishMagickMemory(
+      band_info->node_queue->nodes);
+    band_info->node_queue=(QNodes *) RelinquishMagickMemory(
+      band_info->node_queue);
+    band_info->node_queue=nodes;
+  }
+  band_info=(QCubeInfo *) RelinquishMagickMemory(band_info);
+  return((QCubeInfo *) NULL);
+}
 
+static QCubeInfo *AcquireQCubeBand(const QCubeInfo *cube_info)
+{
+  QCubeInfo
+    *band_info;
+
+  /*
+    A partial color tree for a band of rows, it shares the cube depth but has
+    no dither resources.
+  */
+  band_info=(QCubeInfo *) AcquireMagickMemory(sizeof(*band_info));
+  if (band_info == (QCubeInfo *) NULL)
+    return((QCubeInfo *) NULL);
+  (void) memset(band_info,0,sizeof(*band_info));
+  band_info->depth=cube_info->depth;
+  band_info->maximum_colors=cube_info->maximum_colors;
+  band_info->associate_alpha=cube_info->associate_alpha;
+  band_info->root=GetQNodeInfo(band_info,0,0,(QNodeInfo *) NULL);
+  if (band_info->root == (QNodeInfo *) NULL)
+    return(DestroyQCubeBand(band_info));
+  band_info->root->parent=band_info->root;
+  return(band_info);
+}
+
+static void ClassifyImagePixels(QCubeInfo *cube_info,const Image *image,
+  const Quantum *magick_restrict p,const size_t depth,ExceptionInfo *exception)
+{
   double
     bisect;
 
@@ -769,9 +975,6 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
     midpoint,
     pixel;
 
-  MagickBooleanType
-    proceed;
-
   QNodeInfo
     *node_info;
 
@@ -782,6 +985,258 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
 
   ssize_t
     count,
+    x;
+
+  /*
+    Classify one row of pixels to the given tree depth.
+  */
+  midpoint.red=(double) QuantumRange/2.0;
+  midpoint.green=(double) QuantumRange/2.0;
+  midpoint.blue=(double) QuantumRange/2.0;
+  midpoint.alpha=(double) QuantumRange/2.0;
+  error.alpha=0.0;
+  for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
+  {
+    /*
+      Start at the root and descend the color cube tree.
+    */
+    for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
+    {
+      PixelInfo
+        packet;
+
+      GetPixelInfoPixel(image,p+count*(ssize_t) GetPixelChannels(image),
+        &packet);
+      if (IsPixelEquivalent(image,p,&packet) == MagickFalse)
+        break;
+    }
+    AssociateAlphaPixel(image,cube_info,p,&pixel);
+    index=MaxTreeDepth-1;
+    bisect=((double) QuantumRange+1.0)/2.0;
+    mid=midpoint;
+    node_info=cube_info->root;
+    for (level=1; level <= depth; level++)
+    {
+      double
+        distance;
+
+      bisect*=0.5;
+      id=ColorToQNodeId(cube_info,&pixel,index);
+      mid.red+=(id & 1) != 0 ? bisect : -bisect;
+      mid.green+=(id & 2) != 0 ? bisect : -bisect;
+      mid.blue+=(id & 4) != 0 ? bisect : -bisect;
+      mid.alpha+=(id & 8) != 0 ? bisect : -bisect;
+      if (node_info->child[id] == (QNodeInfo *) NULL)
+        {
+          /*
+            Set colors of new node to contain pixel.
+          */
+          node_info->child[id]=GetQNodeInfo(cube_info,id,level,node_info);
+          if (node_info->child[id] == (QNodeInfo *) NULL)
+            {
+              (void) ThrowMagickException(exception,GetMagickModule(),
+                ResourceLimitError,"MemoryAllocationFailed","`%s'",
+                image->filename);
+              continue;
+            }
+          if (level == depth)
+            cube_info->colors++;
+        }
+      /*
+        Approximate the quantization error represented by this node.
+      */
+      node_info=node_info->child[id];
+      error.red=QuantumScale*(pixel.red-mid.red);
+      error.green=QuantumScale*(pixel.green-mid.green);
+      error.blue=QuantumScale*(pixel.blue-mid.blue);
+      if (cube_info->associate_alpha != MagickFalse)
+        error.alpha=QuantumScale*(pixel.alpha-mid.alpha);
+      distance=(double) (error.red*error.red+error.green*error.green+
+        error.blue*error.blue+error.alpha*error.alpha);
+      if (IsNaN(distance) != 0)
+        distance=0.0;
+      node_info->quantize_error+=count*sqrt(distance);
+      cube_info->root->quantize_error+=node_info->quantize_error;
+      index--;
+    }
+    /*
+      Sum RGB for this leaf for later derivation of the mean cube color.
+    */
+    node_info->number_unique=(size_t) ((ssize_t) node_info->number_unique+
+      count);
+    node_info->total_color.red+=count*QuantumScale*(double)
+      ClampPixel(pixel.red);
+    node_info->total_color.green+=count*QuantumScale*(double)
+      ClampPixel(pixel.green);
+    node_info->total_color.blue+=count*QuantumScale*(double)
+      ClampPixel(pixel.blue);
+    if (cube_info->associate_alpha != MagickFalse)
+      node_info->total_color.alpha+=count*QuantumScale*(double)
+        ClampPixel(pixel.alpha);
+    else
+      node_info->total_color.alpha+=count*QuantumScale*(double)
+        ClampPixel((double) OpaqueAlpha);
+    p+=(ptrdiff_t) count*(ssize_t) GetPixelChannels(image);
+  }
+}
+
+static MagickBooleanType MergeQNodeInfo(QCubeInfo *cube_info,
+  QNodeInfo *node_info,const QNodeInfo *band_node)
+{
+  size_t
+    number_children;
+
+  ssize_t
+    i;
+
+  /*
+    Sum the statistics of a band node into the color tree.
+  */
+  node_info->number_unique+=band_node->number_unique;
+  node_info->total_color.red+=band_node->total_color.red;
+  node_info->total_color.green+=band_node->total_color.green;
+  node_info->total_color.blue+=band_node->total_color.blue;
+  node_info->total_color.alpha+=band_node->total_color.alpha;
+  node_info->quantize_error+=band_node->quantize_error;
+  number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
+  for (i=0; i < (ssize_t) number_children; i++)
+  {
+    if (band_node->child[i] == (QNodeInfo *) NULL)
+      continue;
+    if (node_info->child[i] == (QNodeInfo *) NULL)
+      {
+        node_info->child[i]=GetQNodeInfo(cube_info,(size_t) i,
+          band_node->child[i]->level,node_info);
+        if (node_info->child[i] == (QNodeInfo *) NULL)
+          return(MagickFalse);
+        if (node_info->child[i]->level == cube_info->depth)
+          cube_info->colors++;
+      }
+    if (MergeQNodeInfo(cube_info,node_info->child[i],band_node->child[i]) ==
+        MagickFalse)
+      return(MagickFalse);
+  }
+  return(MagickTrue);
+}
+
+static MagickBooleanType ClassifyImageBands(QCubeInfo *cube_info,
+  const Image *image,CacheView *image_view,ssize_t *y,ExceptionInfo *exception)
+{
+#define ClassifyImageTag  "Classify/Image"
+
+  MagickBooleanType
+    proceed,
+    status;
+
+  QCubeInfo
+    **band_info;
+
+  size_t
+    number_bands,
+    rows;
+
+  ssize_t
+    i,
+    n;
+
+  /*
+    Classify fixed bands of rows into partial color trees in parallel, then
+    merge them in row order.  The bands do not depend on the number of
+    threads so the classification is the same however many threads run.  A
+    band whose merge could grow the tree past MaxQNodes is left to the serial
+    path, which prunes at exactly the same row as before.
+  */
+  rows=MagickMax(ClassifyBandExtent/MagickMax(image->columns,1),1);
+  number_bands=MagickMax((size_t) GetMagickResourceLimit(ThreadResource),1);
+  band_info=(QCubeInfo **) AcquireQuantumMemory(number_bands,
+    sizeof(*band_info));
+  if (band_info == (QCubeInfo **) NULL)
+    return(MagickTrue);
+  (void) memset(band_info,0,number_bands*sizeof(*band_info));
+  status=MagickTrue;
+  while (*y < (ssize_t) image->rows)
+  {
+    const ssize_t
+      offset = (*y);
+
+    n=(ssize_t) MagickMin(number_bands,((size_t) image->rows-(size_t) offset+
+      rows-1)/rows);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+    #pragma omp parallel for schedule(static) \
+      magick_number_threads(image,image,(size_t) n*rows,1)
+#endif
+    for (i=0; i < n; i++)
+    {
+      ssize_t
+        j;
+
+      band_info[i]=AcquireQCubeBand(cube_info);
+      if (band_info[i] == (QCubeInfo *) NULL)
+        continue;
+      for (j=offset+i*(ssize_t) rows; j < MagickMin(offset+(i+1)*(ssize_t) rows,
+           (ssize_t) image->rows); j++)
+      {
+        const Quantum
+          *magick_restrict p;
+
+        p=GetCacheViewVirtualPixels(image_view,0,j,image->columns,1,exception);
+        if (p == (const Quantum *) NULL)
+          {
+            band_info[i]=DestroyQCubeBand(band_info[i]);
+            break;
+          }
+        ClassifyImagePixels(band_info[i],image,p,band_info[i]->depth,
+          exception);
+      }
+    }
+    for (i=0; i < n; i++)
+    {
+      if ((band_info[i] == (QCubeInfo *) NULL) ||
+          ((cube_info->nodes+band_info[i]->nodes-1) > MaxQNodes))
+        break;
+      if (MergeQNodeInfo(cube_info,cube_info->root,band_info[i]->root) ==
+          MagickFalse)
+        {
+          (void) ThrowMagickException(exception,GetMagickModule(),
+            ResourceLimitError,"MemoryAllocationFailed","`%s'",
+            image->filename);
+          status=MagickFalse;
+          break;
+        }
+      band_info[i]=DestroyQCubeBand(band_info[i]);
+      *y=MagickMin(*y+(ssize_t) rows,(ssize_t) image->rows);
+      proceed=SetImageProgress(image,ClassifyImageTag,(MagickOffsetType)
+        *y-1,image->rows);
+      if (proceed == MagickFalse)
+        {
+          status=MagickFalse;
+          i++;
+          break;
+        }
+    }
+    if (i < n)
+      {
+        for ( ; i < n; i++)
+          if (band_info[i] != (QCubeInfo *) NULL)
+            band_info[i]=DestroyQCubeBand(band_info[i]);
+        break;
+      }
+  }
+  band_info=(QCubeInfo **) RelinquishMagickMemory(band_info);
+  return(status);
+}
+
+static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
+  const Image *image,ExceptionInfo *exception)
+{
+  CacheView
+    *image_view;
+
+  MagickBooleanType
+    proceed,
+    status;
+
+  ssize_t
     y;
 
   /*
@@ -799,20 +1254,12 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
           (void) TransformImageColorspace((Image *) image,sRGBColorspace,
             exception);
     }
-  midpoint.red=(double) QuantumRange/2.0;
-  midpoint.green=(double) QuantumRange/2.0;
-  midpoint.blue=(double) QuantumRange/2.0;
-  midpoint.alpha=(double) QuantumRange/2.0;
-  error.alpha=0.0;
   image_view=AcquireVirtualCacheView(image,exception);
   for (y=0; y < (ssize_t) image->rows; y++)
   {
     const Quantum
       *magick_restrict p;
 
-    ssize_t
-      x;
-
     p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
     if (p == (const Quantum *) NULL)
       break;
@@ -824,89 +1271,7 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
         PruneLevel(cube_info,cube_info->root);
         cube_info->depth--;
       }
-    for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
-    {
-      /*
-        Start at the root and descend the color cube tree.
-      */
-      for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
-      {
-        PixelInfo
-          packet;
-
-        GetPixelInfoPixel(image,p+count*(ssize_t) GetPixelChannels(image),
-          &packet);
-        if (IsPixelEquivalent(image,p,&packet) == MagickFalse)
-          break;
-      }
-      AssociateAlphaPixel(image,cube_info,p,&pixel);
-      index=MaxTreeDepth-1;
-      bisect=((double) QuantumRange+1.0)/2.0;
-      mid=midpoint;
-      node_info=cube_info->root;
-      for (level=1; level <= MaxTreeDepth; level++)
-      {
-        double
-          distance;
-
-        bisect*=0.5;
-        id=ColorToQNodeId(cube_info,&pixel,index);
-        mid.red+=(id & 1) != 0 ? bisect : -bisect;
-        mid.green+=(id & 2) != 0 ? bisect : -bisect;
-        mid.blue+=(id & 4) != 0 ? bisect : -bisect;
-        mid.alpha+=(id & 8) != 0 ? bisect : -bisect;
-        if (node_info->child[id] == (QNodeInfo *) NULL)
-          {
-            /*
-              Set colors of new node to contain pixel.
-            */
-            node_info->child[id]=GetQNodeInfo(cube_info,id,level,node_info);
-            if (node_info->child[id] == (QNodeInfo *) NULL)
-              {
-                (void) ThrowMagickException(exception,GetMagickModule(),
-                  ResourceLimitError,"MemoryAllocationFailed","`%s'",
-                  image->filename);
-                continue;
-              }
-            if (level == MaxTreeDepth)
-              cube_info->colors++;
-          }
-        /*
-          Approximate the quantization error represented by this node.
-        */
-        node_info=node_info->child[id];
-        error.red=QuantumScale*(pixel.red-mid.red);
-        error.green=QuantumScale*(pixel.green-mid.green);
-        error.blue=QuantumScale*(pixel.blue-mid.blue);
-        if (cube_info->associate_alpha != MagickFalse)
-          error.alpha=QuantumScale*(pixel.alpha-mid.alpha);
-        distance=(double) (error.red*error.red+error.green*error.green+
-          error.blue*error.blue+error.alpha*error.alpha);
-        if (IsNaN(distance) != 0)
-          distance=0.0;
-        node_info->quantize_error+=count*sqrt(distance);
-        cube_info->root->quantize_error+=node_info->quantize_error;
-        index--;
-      }
-      /*
-        Sum RGB for this leaf for later derivation of the mean cube color.
-      */
-      node_info->number_unique=(size_t) ((ssize_t) node_info->number_unique+
-        count);
-      node_info->total_color.red+=count*QuantumScale*(double)
-        ClampPixel(pixel.red);
-      node_info->total_color.green+=count*QuantumScale*(double)
-        ClampPixel(pixel.green);
-      node_info->total_color.blue+=count*QuantumScale*(double)
-        ClampPixel(pixel.blue);
-      if (cube_info->associate_alpha != MagickFalse)
-        node_info->total_color.alpha+=count*QuantumScale*(double)
-          ClampPixel(pixel.alpha);
-      else
-        node_info->total_color.alpha+=count*QuantumScale*(double)
-          ClampPixel((double) OpaqueAlpha);
-      p+=(ptrdiff_t) count*(ssize_t) GetPixelChannels(image);
-    }
+    ClassifyImagePixels(cube_info,image,p,MaxTreeDepth,exception);
     if (cube_info->colors > cube_info->maximum_colors)
       {
         PruneToCubeDepth(cube_info,cube_info->root);
@@ -917,14 +1282,18 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
     if (proceed == MagickFalse)
       break;
   }
-  for (y++; y < (ssize_t) image->rows; y++)
+  /*
+    Classify the remaining rows to the cube depth.
+  */
+  y++;
+  status=MagickTrue;
+  if (y < (ssize_t) image->rows)
+    status=ClassifyImageBands(cube_info,image,image_view,&y,exception);
+  for ( ; (status != MagickFalse) && (y < (ssize_t) image->rows); y++)
   {
     const Quantum
       *magick_restrict p;
 
-    ssize_t
-      x;
-
     p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
     if (p == (const Quantum *) NULL)
       break;
@@ -936,89 +1305,7 @@ static MagickBooleanType ClassifyImageColors(QCubeInfo *cube_info,
         PruneLevel(cube_info,cube_info->root);
         cube_info->depth--;
       }
-    for (x=0; x < (ssize_t) image->columns; x+=(ssize_t) count)
-    {
-      /*
-        Start at the root and descend the color cube tree.
-      */
-      for (count=1; (x+(ssize_t) count) < (ssize_t) image->columns; count++)
-      {
-        PixelInfo
-          packet;
-
-        GetPixelInfoPixel(image,p+count*(ssize_t) GetPixelChannels(image),
-          &packet);
-        if (IsPixelEquivalent(image,p,&packet) == MagickFalse)
-          break;
-      }
-      AssociateAlphaPixel(image,cube_info,p,&pixel);
-      index=MaxTreeDepth-1;
-      bisect=((double) QuantumRange+1.0)/2.0;
-      mid=midpoint;
-      node_info=cube_info->root;
-      for (level=1; level <= cube_info->depth; level++)
-      {
-        double
-          distance;
-
-        bisect*=0.5;
-        id=ColorToQNodeId(cube_info,&pixel,index);
-        mid.red+=(id & 1) != 0 ? bisect : -bisect;
-        mid.green+=(id & 2) != 0 ? bisect : -bisect;
-        mid.blue+=(id & 4) != 0 ? bisect : -bisect;
-        mid.alpha+=(id & 8) != 0 ? bisect : -bisect;
-        if (node_info->child[id] == (QNodeInfo *) NULL)
-          {
-            /*
-              Set colors of new node to contain pixel.
-            */
-            node_info->child[id]=GetQNodeInfo(cube_info,id,level,node_info);
-            if (node_info->child[id] == (QNodeInfo *) NULL)
-              {
-                (void) ThrowMagickException(exception,GetMagickModule(),
-                  ResourceLimitError,"MemoryAllocationFailed","%s",
-                  image->filename);
-                continue;
-              }
-            if (level == cube_info->depth)
-              cube_info->colors++;
-          }
-        /*
-          Approximate the quantization error represented by this node.
-        */
-        node_info=node_info->child[id];
-        error.red=QuantumScale*(pixel.red-mid.red);
-        error.green=QuantumScale*(pixel.green-mid.green);
-        error.blue=QuantumScale*(pixel.blue-mid.blue);
-        if (cube_info->associate_alpha != MagickFalse)
-          error.alpha=QuantumScale*(pixel.alpha-mid.alpha);
-        distance=(double) (error.red*error.red+error.green*error.green+
-          error.blue*error.blue+error.alpha*error.alpha);
-        if (IsNaN(distance) != 0)
-          distance=0.0;
-        node_info->quantize_error+=count*sqrt(distance);
-        cube_info->root->quantize_error+=node_info->quantize_error;
-        index--;
-      }
-      /*
-        Sum RGB for this leaf for later derivation of the mean cube color.
-      */
-      node_info->number_unique=(size_t) ((ssize_t) node_info->number_unique+
-        count);
-      node_info->total_color.red+=count*QuantumScale*(double)
-        ClampPixel(pixel.red);
-      node_info->total_color.green+=count*QuantumScale*(double)
-        ClampPixel(pixel.green);
-      node_info->total_color.blue+=count*QuantumScale*(double)
-        ClampPixel(pixel.blue);
-      if (cube_info->associate_alpha != MagickFalse)
-        node_info->total_color.alpha+=count*QuantumScale*(double)
-          ClampPixel(pixel.alpha);
-      else
-        node_info->total_color.alpha+=count*QuantumScale*(double)
-          ClampPixel((MagickRealType) OpaqueAlpha);
-      p+=(ptrdiff_t) count*(ssize_t) GetPixelChannels(image);
-    }
+    ClassifyImagePixels(cube_info,image,p,cube_info->depth,exception);
     proceed=SetImageProgress(image,ClassifyImageTag,(MagickOffsetType) y,
       image->rows);
     if (proceed == MagickFalse)
@@ -1104,74 +1391,138 @@ MagickExport QuantizeInfo *CloneQuantizeInfo(const QuantizeInfo *quantize_info)
 %      node in the color cube tree that is to be pruned.
 %
 */
-static void ClosestColor(const Image *image,QCubeInfo *cube_info,
-  const QNodeInfo *node_info)
+static inline double ClosestColorDistance(const QCubeInfo *cube_info,
+  const PixelInfo *magick_restrict p)
 {
-  size_t
-    number_children;
+  const DoublePixelPacket
+    *magick_restrict q;
 
-  ssize_t
-    i;
+  double
+    alpha,
+    beta,
+    distance,
+    pixel;
 
-  /*
-    Traverse any children.
-  */
-  number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
-  for (i=0; i < (ssize_t) number_children; i++)
-    if (node_info->child[i] != (QNodeInfo *) NULL)
-      ClosestColor(image,cube_info,node_info->child[i]);
-  if (node_info->number_unique != 0)
+  q=(&cube_info->target);
+  alpha=1.0;
+  beta=1.0;
+  if (cube_info->associate_alpha != MagickFalse)
     {
-      double
-        alpha,
-        beta,
-        distance,
-        pixel;
+      alpha=(MagickRealType) (QuantumScale*p->alpha);
+      beta=(MagickRealType) (QuantumScale*q->alpha);
+    }
+  pixel=alpha*p->red-beta*q->red;
+  distance=pixel*pixel;
+  pixel=alpha*p->green-beta*q->green;
+  distance+=pixel*pixel;
+  pixel=alpha*p->blue-beta*q->blue;
+  distance+=pixel*pixel;
+  if (cube_info->associate_alpha != MagickFalse)
+    {
+      pixel=p->alpha-q->alpha;
+      distance+=pixel*pixel;
+    }
+  return(distance);
+}
 
-      DoublePixelPacket
-        *magick_restrict q;
+static void ClosestColor(const Image *image,QCubeInfo *cube_info,
+  const QNodeInfo *node_info)
+{
+  const QColorKey
+    *magick_restrict keys;
 
-      PixelInfo
-        *magick_restrict p;
+  double
+    beta,
+    delta,
+    distance,
+    target;
+
+  MagickBooleanType
+    found;
+
+  ssize_t
+    i,
+    j,
+    n;
 
+  if (node_info->number_colors == 0)
+    return;
+  if ((cube_info->color_keys == (QColorKey *) NULL) ||
+      (node_info->number_colors < ColorKeysThreshold))
+    {
       /*
-        Determine if this color is "closest".
+        Scan the colors of this subtree, ties go to the last entry.
       */
-      p=image->colormap+node_info->color_number;
-      q=(&cube_info->target);
-      alpha=1.0;
-      beta=1.0;
-      if (cube_info->associate_alpha != MagickFalse)
-        {
-          alpha=(MagickRealType) (QuantumScale*p->alpha);
-          beta=(MagickRealType) (QuantumScale*q->alpha);
-        }
-      pixel=alpha*p->red-beta*q->red;
-      distance=pixel*pixel;
-      if (distance <= cube_info->distance)
-        {
-          pixel=alpha*p->green-beta*q->green;
-          distance+=pixel*pixel;
-          if (distance <= cube_info->distance)
-            {
-              pixel=alpha*p->blue-beta*q->blue;
-              distance+=pixel*pixel;
-              if (distance <= cube_info->distance)
-                {
-                  if (cube_info->associate_alpha != MagickFalse)
-                    {
-                      pixel=p->alpha-q->alpha;
-                      distance+=pixel*pixel;
-                    }
-                  if (distance <= cube_info->distance)
-                    {
-                      cube_info->distance=distance;
-                      cube_info->color_number=node_info->color_number;
-                    }
-                }
-            }
-        }
+      for (i=0; i < (ssize_t) node_info->number_colors; i++)
+      {
+        distance=ClosestColorDistance(cube_info,image->colormap+
+          node_info->first_color+(size_t) i);
+        if (distance <= cube_info->distance)
+          {
+            cube_info->distance=distance;
+            cube_info->color_number=node_info->first_color+(size_t) i;
+          }
+      }
+      return;
     }
+  /*
+    Search outward from the target along the colors sorted by red, stopping
+    once the red distance alone exceeds the closest distance so far.  A
+    little slack keeps the bound conservative should the compiler contract
+    the products.
+  */
+  keys=cube_info->color_keys+node_info->level*cube_info->number_keys+
+    node_info->first_color;
+  n=(ssize_t) node_info->number_colors;
+  beta=1.0;
+  if (cube_info->associate_alpha != MagickFalse)
+    beta=(MagickRealType) (QuantumScale*cube_info->target.alpha);
+  target=beta*cube_info->target.red;
+  i=0;
+  for (j=n; i < j; )
+  {
+    ssize_t
+      k;
+
+    k=i+(j-i)/2;
+    if (keys[k].red < target)
+      i=k+1;
+    else
+      j=k;
+  }
+  found=MagickFalse;
+  for (j=i; j < n; j++)
+  {
+    delta=keys[j].red-target;
+    if ((delta*delta) > ((1.0+1.0e-6)*cube_info->distance+1.0e-6))
+      break;
+    distance=ClosestColorDistance(cube_info,image->colormap+
+      keys[j].color_number);
+    if ((distance < cube_info->distance) || ((distance == cube_info->distance) &&
+        ((found == MagickFalse) ||
+         (keys[j].color_number > cube_info->color_number))))
+      {
+        cube_info->distance=distance;
+        cube_info->color_number=keys[j].color_number;
+        found=MagickTrue;
+      }
+  }
+  for (j=i-1; j >= 0; j--)
+  {
+    delta=target-keys[j].red;
+    if ((delta*delta) > ((1.0+1.0e-6)*cube_info->distance+1.0e-6))
+      break;
+    distance=ClosestColorDistance(cube_info,image->colormap+
+      keys[j].color_number);
+    if ((distance < cube_info->distance) || ((distance == cube_info->distance) &&
+        ((found == MagickFalse) ||
+         (keys[j].color_number > cube_info->color_number))))
+      {
+        cube_info->distance=distance;
+        cube_info->color_number=keys[j].color_number;
+        found=MagickTrue;
+      }
+  }
 }
 
 /*
@@ -1258,8 +1609,10 @@ static void DefineImageColormap(Image *image,QCubeInfo *cube_info,
     i;
 
   /*
-    Traverse any children.
+    Traverse any children.  Entries are numbered in post-order so the colors
+    of any subtree are a contiguous run of the colormap.
   */
+  node_info->first_color=image->colors;
   number_children=cube_info->associate_alpha == MagickFalse ? 8UL : 16UL;
   for (i=0; i < (ssize_t) number_children; i++)
     if (node_info->child[i] != (QNodeInfo *) NULL)
@@ -1327,6 +1680,7 @@ static void DefineImageColormap(Image *image,QCubeInfo *cube_info,
         }
       node_info->color_number=image->colors++;
     }
+  node_info->number_colors=image->colors-node_info->first_color;
 }
 
 /*
@@ -1370,6 +1724,9 @@ static void DestroyQCubeInfo(QCubeInfo *cube_info)
   } while (cube_info->node_queue != (QNodes *) NULL);
   if (cube_info->memory_info != (MemoryInfo *) NULL)
     cube_info->memory_info=RelinquishVirtualMemory(cube_info->memory_info);
+  if (cube_info->color_keys != (QColorKey *) NULL)
+    cube_info->color_keys=(QColorKey *) RelinquishMagickMemory(
+      cube_info->color_keys);
   cube_info->quantize_info=DestroyQuantizeInfo(cube_info->quantize_info);
   cube_info=(QCubeInfo *) RelinquishMagickMemory(cube_info);
 }
@@ -1516,7 +1873,9 @@ static MagickBooleanType FloydSteinbergDither(Image *image,QCubeInfo *cube_info,
     y;
 
   /*
-    Distribute quantization error using Floyd-Steinberg.
+    Distribute quantization error using Floyd-Steinberg.  The scan stays
+    serial: each serpentine row starts at the last pixel of the row above,
+    and the color cache keeps the first pixel that lands in a bucket.
   */
   pixels=AcquirePixelTLS(image->columns);
   if (pixels == (DoublePixelPacket **) NULL)
@@ -1657,8 +2016,6 @@ static MagickBooleanType FloydSteinbergDither(Image *image,QCubeInfo *cube_info,
             SetPixelAlpha(image,ClampToQuantum(image->colormap[index].alpha),
               q+u*(ssize_t) GetPixelChannels(image));
         }
-      if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
-        status=MagickFalse;
       /*
         Store the error.
       */
@@ -1668,17 +2025,19 @@ static MagickBooleanType FloydSteinbergDither(Image *image,QCubeInfo *cube_info,
       current[u].blue=pixel.blue-color.blue;
       if (cube.associate_alpha != MagickFalse)
         current[u].alpha=pixel.alpha-color.alpha;
-      if (image->progress_monitor != (MagickProgressMonitor) NULL)
-        {
-          MagickBooleanType
-            proceed;
-
-          proceed=SetImageProgress(image,DitherImageTag,(MagickOffsetType) y,
-            image->rows);
-          if (proceed == MagickFalse)
-            status=MagickFalse;
-        }
     }
+    if (SyncCacheViewAuthenticPixels(image_view,exception) == MagickFalse)
+      status=MagickFalse;
+    if (image->progress_monitor != (MagickProgressMonitor) NULL)
+      {
+        MagickBooleanType
+          proceed;
+
+        proceed=SetImageProgress(image,DitherImageTag,(MagickOffsetType) y,
+          image->rows);
+        if (proceed == MagickFalse)
+          status=MagickFalse;
+      }
   }
   image_view=DestroyCacheView(image_view);
   pixels=DestroyPixelTLS(pixels);
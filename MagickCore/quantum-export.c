@@ -341,6 +341,161 @@ static void ExportPixelChannel(const Image *image,QuantumInfo *quantum_info,
   }
 }
 
+static MagickBooleanType ExportQuantumChannels(const Image *image,
+  const QuantumInfo *quantum_info,const MagickSizeType number_pixels,
+  const Quantum *magick_restrict p,unsigned char *magick_restrict q,
+  const PixelChannel *channels,const size_t number_channels)
+{
+  MagickBooleanType
+    contiguous;
+
+  size_t
+    extent;
+
+  ssize_t
+    i,
+    offset[MaxPixelChannels],
+    x;
+
+  /*
+    Unpadded 8 and 16-bit samples are converted in one pass the compiler can
+    vectorize when the pixels hold exactly these channels in this order, and
+    with a per-pixel gather otherwise.
+  */
+  if ((quantum_info->pad != 0) ||
+      (quantum_info->format == FloatingPointQuantumFormat) ||
+      ((quantum_info->depth != 8) && (quantum_info->depth != 16)))
+    return(MagickFalse);
+  contiguous=GetPixelChannels(image) == number_channels ? MagickTrue :
+    MagickFalse;
+  for (i=0; i < (ssize_t) number_channels; i++)
+  {
+    if (GetPixelChannelTraits(image,channels[i]) == UndefinedPixelTrait)
+      return(MagickFalse);
+    offset[i]=image->channel_map[channels[i]].offset;
+    if (offset[i] != i)
+      contiguous=MagickFalse;
+  }
+  extent=(size_t) number_pixels*number_channels;
+  if (quantum_info->depth == 8)
+    {
+      if (contiguous != MagickFalse)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+          #pragma omp simd
+#endif
+          for (x=0; x < (ssize_t) extent; x++)
+            q[x]=ScaleQuantumToChar(p[x]);
+          return(MagickTrue);
+        }
+      for (x=0; x < (ssize_t) number_pixels; x++)
+      {
+        for (i=0; i < (ssize_t) number_channels; i++)
+          *q++=ScaleQuantumToChar(p[offset[i]]);
+        p+=(ptrdiff_t) GetPixelChannels(image);
+      }
+      return(MagickTrue);
+    }
+  if (contiguous != MagickFalse)
+    {
+      if (quantum_info->endian == LSBEndian)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+          #pragma omp simd
+#endif
+          for (x=0; x < (ssize_t) extent; x++)
+          {
+            unsigned short
+              pixel;
+
+            pixel=ScaleQuantumToShort(p[x]);
+            q[2*x]=(unsigned char) pixel;
+            q[2*x+1]=(unsigned char) (pixel >> 8);
+          }
+          return(MagickTrue);
+        }
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+      #pragma omp simd
+#endif
+      for (x=0; x < (ssize_t) extent; x++)
+      {
+        unsigned short
+          pixel;
+
+        pixel=ScaleQuantumToShort(p[x]);
+        q[2*x]=(unsigned char) (pixel >> 8);
+        q[2*x+1]=(unsigned char) pixel;
+      }
+      return(MagickTrue);
+    }
+  for (x=0; x < (ssize_t) number_pixels; x++)
+  {
+    for (i=0; i < (ssize_t) number_channels; i++)
+      q=PopShortPixel(quantum_info->endian,ScaleQuantumToShort(p[offset[i]]),
+        q);
+    p+=(ptrdiff_t) GetPixelChannels(image);
+  }
+  return(MagickTrue);
+}
+
+static MagickBooleanType ExportLumaQuantum(const Image *image,
+  const QuantumInfo *quantum_info,const MagickSizeType number_pixels,
+  const Quantum *magick_restrict p,unsigned char *magick_restrict q)
+{
+  ssize_t
+    x;
+
+  /*
+    A single channel image has its red, green, and blue at offset 0, so the
+    luma is computed as GetPixelLuma() would, in a vectorizable pass.
+  */
+  if ((quantum_info->pad != 0) || (GetPixelChannels(image) != 1) ||
+      (quantum_info->format == FloatingPointQuantumFormat) ||
+      ((quantum_info->depth != 8) && (quantum_info->depth != 16)))
+    return(MagickFalse);
+  if (quantum_info->depth == 8)
+    {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+      #pragma omp simd
+#endif
+      for (x=0; x < (ssize_t) number_pixels; x++)
+        q[x]=ScaleQuantumToChar(ClampToQuantum(0.212656*(MagickRealType)
+          p[x]+0.715158*(MagickRealType) p[x]+0.072186*(MagickRealType) p[x]));
+      return(MagickTrue);
+    }
+  if (quantum_info->endian == LSBEndian)
+    {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+      #pragma omp simd
+#endif
+      for (x=0; x < (ssize_t) number_pixels; x++)
+      {
+        unsigned short
+          pixel;
+
+        pixel=ScaleQuantumToShort(ClampToQuantum(0.212656*(MagickRealType)
+          p[x]+0.715158*(MagickRealType) p[x]+0.072186*(MagickRealType) p[x]));
+        q[2*x]=(unsigned char) pixel;
+        q[2*x+1]=(unsigned char) (pixel >> 8);
+      }
+      return(MagickTrue);
+    }
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+  #pragma omp simd
+#endif
+  for (x=0; x < (ssize_t) number_pixels; x++)
+  {
+    unsigned short
+      pixel;
+
+    pixel=ScaleQuantumToShort(ClampToQuantum(0.212656*(MagickRealType) p[x]+
+      0.715158*(MagickRealType) p[x]+0.072186*(MagickRealType) p[x]));
+    q[2*x]=(unsigned char) (pixel >> 8);
+    q[2*x+1]=(unsigned char) pixel;
+  }
+  return(MagickTrue);
+}
+
 static void ExportAlphaQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const Quantum *magick_restrict p,
   unsigned char *magick_restrict q,ExceptionInfo *exception)
@@ -358,6 +513,9 @@ static void ExportBGRQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const Quantum *magick_restrict p,
   unsigned char *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { BluePixelChannel,GreenPixelChannel,RedPixelChannel };
+
   QuantumAny
     range;
 
@@ -367,6 +525,9 @@ static void ExportBGRQuantum(const Image *image,QuantumInfo *quantum_info,
   ssize_t
     bit;
 
+  if (ExportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      3) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -659,12 +820,19 @@ static void ExportBGRAQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const Quantum *magick_restrict p,
   unsigned char *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { BluePixelChannel,GreenPixelChannel,RedPixelChannel,
+      AlphaPixelChannel };
+
   QuantumAny
     range;
 
   ssize_t
     x;
 
+  if (ExportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      4) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -1794,6 +1962,8 @@ static void ExportGrayQuantum(const Image *image,QuantumInfo *quantum_info,
   ssize_t
     x;
 
+  if (ExportLumaQuantum(image,quantum_info,number_pixels,p,q) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 1:
@@ -2864,6 +3034,9 @@ static void ExportRGBQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const Quantum *magick_restrict p,
   unsigned char *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { RedPixelChannel,GreenPixelChannel,BluePixelChannel };
+
   QuantumAny
     range;
 
@@ -2873,6 +3046,9 @@ static void ExportRGBQuantum(const Image *image,QuantumInfo *quantum_info,
   ssize_t
     bit;
 
+  if (ExportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      3) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -3168,12 +3344,19 @@ static void ExportRGBAQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const Quantum *magick_restrict p,
   unsigned char *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { RedPixelChannel,GreenPixelChannel,BluePixelChannel,
+      AlphaPixelChannel };
+
   QuantumAny
     range;
 
   ssize_t
     x;
 
+  if (ExportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      4) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -436,6 +436,96 @@ static void ImportPixelChannel(const Image *image,QuantumInfo *quantum_info,
   }
 }
 
+static MagickBooleanType ImportQuantumChannels(const Image *image,
+  const QuantumInfo *quantum_info,const MagickSizeType number_pixels,
+  const unsigned char *magick_restrict p,Quantum *magick_restrict q,
+  const PixelChannel *channels,const size_t number_channels)
+{
+  MagickBooleanType
+    contiguous;
+
+  size_t
+    extent;
+
+  ssize_t
+    i,
+    offset[MaxPixelChannels],
+    x;
+
+  /*
+    Unpadded 8 and 16-bit samples that fill every pixel channel are converted
+    in one pass the compiler can vectorize; anything else returns MagickFalse.
+  */
+  if ((quantum_info->pad != 0) || (quantum_info->min_is_white != MagickFalse) ||
+      (quantum_info->format == FloatingPointQuantumFormat) ||
+      ((quantum_info->depth != 8) && (quantum_info->depth != 16)) ||
+      (GetPixelChannels(image) != number_channels))
+    return(MagickFalse);
+  contiguous=MagickTrue;
+  for (i=0; i < (ssize_t) number_channels; i++)
+  {
+    if (GetPixelChannelTraits(image,channels[i]) == UndefinedPixelTrait)
+      return(MagickFalse);
+    offset[i]=image->channel_map[channels[i]].offset;
+    if (offset[i] != i)
+      contiguous=MagickFalse;
+  }
+  extent=(size_t) number_pixels*number_channels;
+  if (quantum_info->depth == 8)
+    {
+      if (contiguous != MagickFalse)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+          #pragma omp simd
+#endif
+          for (x=0; x < (ssize_t) extent; x++)
+            q[x]=ScaleCharToQuantum(p[x]);
+          return(MagickTrue);
+        }
+      for (x=0; x < (ssize_t) number_pixels; x++)
+      {
+        for (i=0; i < (ssize_t) number_channels; i++)
+          q[offset[i]]=ScaleCharToQuantum(p[i]);
+        p+=(ptrdiff_t) number_channels;
+        q+=(ptrdiff_t) number_channels;
+      }
+      return(MagickTrue);
+    }
+  if (contiguous != MagickFalse)
+    {
+      if (quantum_info->endian == LSBEndian)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+          #pragma omp simd
+#endif
+          for (x=0; x < (ssize_t) extent; x++)
+            q[x]=ScaleShortToQuantum((unsigned short) (p[2*x] |
+              (p[2*x+1] << 8)));
+          return(MagickTrue);
+        }
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+      #pragma omp simd
+#endif
+      for (x=0; x < (ssize_t) extent; x++)
+        q[x]=ScaleShortToQuantum((unsigned short) ((p[2*x] << 8) |
+          p[2*x+1]));
+      return(MagickTrue);
+    }
+  for (x=0; x < (ssize_t) number_pixels; x++)
+  {
+    unsigned short
+      pixel;
+
+    for (i=0; i < (ssize_t) number_channels; i++)
+    {
+      p=PushShortPixel(quantum_info->endian,p,&pixel);
+      q[offset[i]]=ScaleShortToQuantum(pixel);
+    }
+    q+=(ptrdiff_t) number_channels;
+  }
+  return(MagickTrue);
+}
+
 static void ImportAlphaQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q,ExceptionInfo *exception)
@@ -453,6 +543,9 @@ static void ImportBGRQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { BluePixelChannel,GreenPixelChannel,RedPixelChannel };
+
   QuantumAny
     range;
 
@@ -464,6 +557,9 @@ static void ImportBGRQuantum(const Image *image,QuantumInfo *quantum_info,
 
   assert(image != (Image *) NULL);
   assert(image->signature == MagickCoreSignature);
+  if (ImportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      3) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -799,6 +895,10 @@ static void ImportBGRAQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { BluePixelChannel,GreenPixelChannel,RedPixelChannel,
+      AlphaPixelChannel };
+
   QuantumAny
     range;
 
@@ -807,6 +907,9 @@ static void ImportBGRAQuantum(const Image *image,QuantumInfo *quantum_info,
 
   assert(image != (Image *) NULL);
   assert(image->signature == MagickCoreSignature);
+  if (ImportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      4) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -2050,6 +2153,9 @@ static void ImportGrayQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { GrayPixelChannel };
+
   QuantumAny
     range;
 
@@ -2061,6 +2167,9 @@ static void ImportGrayQuantum(const Image *image,QuantumInfo *quantum_info,
 
   assert(image != (Image *) NULL);
   assert(image->signature == MagickCoreSignature);
+  if (ImportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      1) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 1:
@@ -3434,6 +3543,9 @@ static void ImportRGBQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { RedPixelChannel,GreenPixelChannel,BluePixelChannel };
+
   QuantumAny
     range;
 
@@ -3445,6 +3557,9 @@ static void ImportRGBQuantum(const Image *image,QuantumInfo *quantum_info,
 
   assert(image != (Image *) NULL);
   assert(image->signature == MagickCoreSignature);
+  if (ImportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      3) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -3780,6 +3895,10 @@ static void ImportRGBAQuantum(const Image *image,QuantumInfo *quantum_info,
   const MagickSizeType number_pixels,const unsigned char *magick_restrict p,
   Quantum *magick_restrict q)
 {
+  static const PixelChannel
+    channels[] = { RedPixelChannel,GreenPixelChannel,BluePixelChannel,
+      AlphaPixelChannel };
+
   QuantumAny
     range;
 
@@ -3788,6 +3907,9 @@ static void ImportRGBAQuantum(const Image *image,QuantumInfo *quantum_info,
 
   assert(image != (Image *) NULL);
   assert(image->signature == MagickCoreSignature);
+  if (ImportQuantumChannels(image,quantum_info,number_pixels,p,q,channels,
+      4) != MagickFalse)
+    return;
   switch (quantum_info->depth)
   {
     case 8:
@@ -40,7 +40,9 @@
   Include declarations.
 */
 #include "MagickCore/studio.h"
+#include "MagickCore/artifact.h"
 #include "MagickCore/cache.h"
+#include "MagickCore/cache-view.h"
 #include "MagickCore/exception.h"
 #include "MagickCore/exception-private.h"
 #include "MagickCore/property.h"
@@ -53,12 +55,19 @@
 #include "MagickCore/signature.h"
 #include "MagickCore/signature-private.h"
 #include "MagickCore/string_.h"
+#include "MagickCore/thread-private.h"
 #include "MagickCore/timer-private.h"
 /*
   Define declarations.
 */
+#define SignatureBandRows  16
 #define SignatureBlocksize  64
 #define SignatureDigestsize  32
+#define XXH64Prime1  MagickULLConstant(0x9E3779B185EBCA87)
+#define XXH64Prime2  MagickULLConstant(0xC2B2AE3D27D4EB4F)
+#define XXH64Prime3  MagickULLConstant(0x165667B19E3779F9)
+#define XXH64Prime4  MagickULLConstant(0x85EBCA77C2B2AE63)
+#define XXH64Prime5  MagickULLConstant(0x27D4EB2F165667C5)
 
 /*
   Typedef declarations.
@@ -462,6 +471,12 @@ MagickPrivate void SetSignatureDigest(SignatureInfo *signature_info,
 %  signature uniquely identifies the image and is convenient for determining
 %  if an image has been modified or whether two images are identical.
 %
+%  Define signature:algorithm to choose another digest: sha256-tree hashes
+%  bands of rows with SHA-256 in parallel and then hashes the band digests,
+%  and xxh64 does the same with the non-cryptographic XXH64 hash.  Neither
+%  matches the default sha256 signature, but both are independent of the
+%  number of threads.
+%
 %  The format of the SignatureImage method is:
 %
 %      MagickBooleanType SignatureImage(Image *image,ExceptionInfo *exception)
@@ -473,6 +488,285 @@ MagickPrivate void SetSignatureDigest(SignatureInfo *signature_info,
 %    o exception: return any errors or warnings in this structure.
 %
 */
+
+static size_t ExportSignaturePixels(const Image *image,const Quantum *p,
+  const MagickBooleanType lsb_first,unsigned char *pixels)
+{
+  float
+    pixel;
+
+  ssize_t
+    x;
+
+  unsigned char
+    *q;
+
+  /*
+    Serialize the updatable channels of a row as 32-bit big-endian floats.
+  */
+  q=pixels;
+  for (x=0; x < (ssize_t) image->columns; x++)
+  {
+    ssize_t
+      i;
+
+    if (GetPixelReadMask(image,p) <= (QuantumRange/2))
+      {
+        p+=(ptrdiff_t) GetPixelChannels(image);
+        continue;
+      }
+    for (i=0; i < (ssize_t) GetPixelChannels(image); i++)
+    {
+      ssize_t
+        j;
+
+      PixelChannel channel = GetPixelChannelChannel(image,i);
+      PixelTrait traits = GetPixelChannelTraits(image,channel);
+      if ((traits & UpdatePixelTrait) == 0)
+        continue;
+      pixel=(float) (QuantumScale*(double) p[i]);
+      if (lsb_first == MagickFalse)
+        for (j=(ssize_t) sizeof(pixel)-1; j >= 0; j--)
+          *q++=(unsigned char) ((unsigned char *) &pixel)[j];
+      else
+        for (j=0; j < (ssize_t) sizeof(pixel); j++)
+          *q++=(unsigned char) ((unsigned char *) &pixel)[j];
+    }
+    p+=(ptrdiff_t) GetPixelChannels(image);
+  }
+  return((size_t) (q-pixels));
+}
+
+static inline MagickSizeType ReadXXH64Long(const unsigned char *p)
+{
+  return((MagickSizeType) p[0] | ((MagickSizeType) p[1] << 8) |
+    ((MagickSizeType) p[2] << 16) | ((MagickSizeType) p[3] << 24) |
+    ((MagickSizeType) p[4] << 32) | ((MagickSizeType) p[5] << 40) |
+    ((MagickSizeType) p[6] << 48) | ((MagickSizeType) p[7] << 56));
+}
+
+static inline MagickSizeType RotateXXH64(const MagickSizeType x,
+  const unsigned int n)
+{
+  return((x << n) | (x >> (64-n)));
+}
+
+static inline MagickSizeType RoundXXH64(MagickSizeType accumulator,
+  const MagickSizeType value)
+{
+  accumulator+=value*XXH64Prime2;
+  accumulator=RotateXXH64(accumulator,31);
+  return(accumulator*XXH64Prime1);
+}
+
+static inline MagickSizeType MergeXXH64(MagickSizeType accumulator,
+  const MagickSizeType value)
+{
+  accumulator^=RoundXXH64(0,value);
+  return(accumulator*XXH64Prime1+XXH64Prime4);
+}
+
+static MagickSizeType XXH64(const unsigned char *message,const size_t length)
+{
+  const unsigned char
+    *p,
+    *q;
+
+  MagickSizeType
+    digest;
+
+  /*
+    XXH64 with a zero seed, reading the message as little-endian words.
+  */
+  p=message;
+  q=message+length;
+  if (length >= 32)
+    {
+      MagickSizeType
+        v1 = XXH64Prime1+XXH64Prime2,
+        v2 = XXH64Prime2,
+        v3 = 0,
+        v4 = (MagickSizeType) 0-XXH64Prime1;
+
+      for ( ; (q-p) >= 32; p+=32)
+      {
+        v1=RoundXXH64(v1,ReadXXH64Long(p));
+        v2=RoundXXH64(v2,ReadXXH64Long(p+8));
+        v3=RoundXXH64(v3,ReadXXH64Long(p+16));
+        v4=RoundXXH64(v4,ReadXXH64Long(p+24));
+      }
+      digest=RotateXXH64(v1,1)+RotateXXH64(v2,7)+RotateXXH64(v3,12)+
+        RotateXXH64(v4,18);
+      digest=MergeXXH64(digest,v1);
+      digest=MergeXXH64(digest,v2);
+      digest=MergeXXH64(digest,v3);
+      digest=MergeXXH64(digest,v4);
+    }
+  else
+    digest=XXH64Prime5;
+  digest+=(MagickSizeType) length;
+  for ( ; (q-p) >= 8; p+=8)
+  {
+    digest^=RoundXXH64(0,ReadXXH64Long(p));
+    digest=RotateXXH64(digest,27)*XXH64Prime1+XXH64Prime4;
+  }
+  if ((q-p) >= 4)
+    {
+      digest^=((MagickSizeType) p[0] | ((MagickSizeType) p[1] << 8) |
+        ((MagickSizeType) p[2] << 16) | ((MagickSizeType) p[3] << 24))*
+        XXH64Prime1;
+      digest=RotateXXH64(digest,23)*XXH64Prime2+XXH64Prime3;
+      p+=4;
+    }
+  for ( ; p < q; p++)
+  {
+    digest^=(MagickSizeType) (*p)*XXH64Prime5;
+    digest=RotateXXH64(digest,11)*XXH64Prime1;
+  }
+  digest^=digest >> 33;
+  digest*=XXH64Prime2;
+  digest^=digest >> 29;
+  digest*=XXH64Prime3;
+  digest^=digest >> 32;
+  return(digest);
+}
+
+static char *SignatureImageBands(const Image *image,
+  const MagickBooleanType lsb_first,const MagickBooleanType xxh64,
+  ExceptionInfo *exception)
+{
+  CacheView
+    *image_view;
+
+  char
+    *hex_signature;
+
+  MagickBooleanType
+    status;
+
+  size_t
+    digestsize,
+    extent,
+    number_bands;
+
+  ssize_t
+    band;
+
+  StringInfo
+    *digests;
+
+  /*
+    Hash fixed bands of rows in parallel, then hash the band digests in order.
+  */
+  digestsize=xxh64 != MagickFalse ? sizeof(MagickSizeType) :
+    SignatureDigestsize;
+  number_bands=(image->rows+SignatureBandRows-1)/SignatureBandRows;
+  extent=GetPixelChannels(image)*image->columns*sizeof(float);
+  digests=AcquireStringInfo(MagickMax(number_bands,1)*digestsize);
+  SetStringInfoLength(digests,number_bands*digestsize);
+  status=MagickTrue;
+  image_view=AcquireVirtualCacheView(image,exception);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for schedule(static) shared(status) \
+    magick_number_threads(image,image,number_bands,1)
+#endif
+  for (band=0; band < (ssize_t) number_bands; band++)
+  {
+    size_t
+      length;
+
+    ssize_t
+      y;
+
+    StringInfo
+      *pixels;
+
+    unsigned char
+      *digest;
+
+    if (status == MagickFalse)
+      continue;
+    pixels=AcquireStringInfo(SignatureBandRows*extent);
+    length=0;
+    for (y=band*SignatureBandRows; y < MagickMin((band+1)*SignatureBandRows,
+         (ssize_t) image->rows); y++)
+    {
+      const Quantum
+        *magick_restrict p;
+
+      p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
+      if (p == (const Quantum *) NULL)
+        {
+          status=MagickFalse;
+          break;
+        }
+      length+=ExportSignaturePixels(image,p,lsb_first,
+        GetStringInfoDatum(pixels)+length);
+    }
+    SetStringInfoLength(pixels,length);
+    digest=GetStringInfoDatum(digests)+band*(ssize_t) digestsize;
+    if (xxh64 != MagickFalse)
+      {
+        MagickSizeType
+          value;
+
+        ssize_t
+          i;
+
+        value=XXH64(GetStringInfoDatum(pixels),length);
+        for (i=0; i < (ssize_t) digestsize; i++)
+          digest[i]=(unsigned char) (value >> (8*(digestsize-i-1)));
+      }
+    else
+      {
+        SignatureInfo
+          *signature_info;
+
+        signature_info=AcquireSignatureInfo();
+        UpdateSignature(signature_info,pixels);
+        FinalizeSignature(signature_info);
+        (void) memcpy(digest,GetStringInfoDatum(GetSignatureDigest(
+          signature_info)),digestsize);
+        signature_info=DestroySignatureInfo(signature_info);
+      }
+    pixels=DestroyStringInfo(pixels);
+  }
+  image_view=DestroyCacheView(image_view);
+  if (status == MagickFalse)
+    {
+      digests=DestroyStringInfo(digests);
+      return((char *) NULL);
+    }
+  if (xxh64 != MagickFalse)
+    {
+      MagickSizeType
+        value;
+
+      ssize_t
+        i;
+
+      value=XXH64(GetStringInfoDatum(digests),GetStringInfoLength(digests));
+      SetStringInfoLength(digests,digestsize);
+      for (i=0; i < (ssize_t) digestsize; i++)
+        GetStringInfoDatum(digests)[i]=(unsigned char) (value >>
+          (8*(digestsize-i-1)));
+      hex_signature=StringInfoToHexString(digests);
+    }
+  else
+    {
+      SignatureInfo
+        *signature_info;
+
+      signature_info=AcquireSignatureInfo();
+      UpdateSignature(signature_info,digests);
+      FinalizeSignature(signature_info);
+      hex_signature=StringInfoToHexString(GetSignatureDigest(signature_info));
+      signature_info=DestroySignatureInfo(signature_info);
+    }
+  digests=DestroyStringInfo(digests);
+  return(hex_signature);
+}
+
 MagickExport MagickBooleanType SignatureImage(Image *image,
   ExceptionInfo *exception)
 {
@@ -482,8 +776,8 @@ MagickExport MagickBooleanType SignatureImage(Image *image,
   char
     *hex_signature;
 
-  float
-    pixel;
+  const char
+    *artifact;
 
   const Quantum
     *p;
@@ -508,54 +802,39 @@ MagickExport MagickBooleanType SignatureImage(Image *image,
   if (IsEventLogging() != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",image->filename);
   signature_info=AcquireSignatureInfo();
+  artifact=GetImageArtifact(image,"signature:algorithm");
+  if ((artifact != (const char *) NULL) &&
+      ((LocaleCompare(artifact,"sha256-tree") == 0) ||
+       (LocaleCompare(artifact,"xxh64") == 0)))
+    {
+      hex_signature=SignatureImageBands(image,signature_info->lsb_first,
+        LocaleCompare(artifact,"xxh64") == 0 ? MagickTrue : MagickFalse,
+        exception);
+      signature_info=DestroySignatureInfo(signature_info);
+      if (hex_signature == (char *) NULL)
+        return(MagickFalse);
+      (void) DeleteImageProperty(image,"signature");
+      (void) SetImageProperty(image,"signature",hex_signature,exception);
+      hex_signature=DestroyString(hex_signature);
+      return(MagickTrue);
+    }
+  if ((artifact != (const char *) NULL) &&
+      (LocaleCompare(artifact,"sha256") != 0))
+    (void) ThrowMagickException(exception,GetMagickModule(),OptionWarning,
+      "UnrecognizedOption","`signature:algorithm=%s'",artifact);
   signature=AcquireStringInfo(GetPixelChannels(image)*image->columns*
-    sizeof(pixel));
+    sizeof(float));
   image_view=AcquireVirtualCacheView(image,exception);
   for (y=0; y < (ssize_t) image->rows; y++)
   {
-    ssize_t
-      x;
-
-    unsigned char
-      *q;
-
     p=GetCacheViewVirtualPixels(image_view,0,y,image->columns,1,exception);
     if (p == (const Quantum *) NULL)
       break;
     SetStringInfoLength(signature,GetPixelChannels(image)*image->columns*
-      sizeof(pixel));
+      sizeof(float));
     pixels=GetStringInfoDatum(signature);
-    q=pixels;
-    for (x=0; x < (ssize_t) image->columns; x++)
-    {
-      ssize_t
-        i;
-
-      if (GetPixelReadMask(image,p) <= (QuantumRange/2))
-        {
-          p+=(ptrdiff_t) GetPixelChannels(image);
-          continue;
-        }
-      for (i=0; i < (ssize_t) GetPixelChannels(image); i++)
-      {
-        ssize_t
-          j;
-
-        PixelChannel channel = GetPixelChannelChannel(image,i);
-        PixelTrait traits = GetPixelChannelTraits(image,channel);
-        if ((traits & UpdatePixelTrait) == 0)
-          continue;
-        pixel=(float) (QuantumScale*(double) p[i]);
-        if (signature_info->lsb_first == MagickFalse)
-          for (j=(ssize_t) sizeof(pixel)-1; j >= 0; j--)
-            *q++=(unsigned char) ((unsigned char *) &pixel)[j];
-        else
-          for (j=0; j < (ssize_t) sizeof(pixel); j++)
-            *q++=(unsigned char) ((unsigned char *) &pixel)[j];
-      }
-      p+=(ptrdiff_t) GetPixelChannels(image);
-    }
-    SetStringInfoLength(signature,(size_t) (q-pixels));
+    SetStringInfoLength(signature,ExportSignaturePixels(image,p,
+      signature_info->lsb_first,pixels));
     UpdateSignature(signature_info,signature);
   }
   image_view=DestroyCacheView(image_view);
@@ -46,13 +46,17 @@
 #include "MagickCore/cache.h"
 #include "MagickCore/cache-private.h"
 #include "MagickCore/color-private.h"
+#include "MagickCore/colorspace.h"
 #include "MagickCore/composite-private.h"
 #include "MagickCore/constitute.h"
+#include "MagickCore/enhance.h"
 #include "MagickCore/exception.h"
 #include "MagickCore/exception-private.h"
 #include "MagickCore/geometry.h"
 #include "MagickCore/memory_.h"
 #include "MagickCore/memory-private.h"
+#include "MagickCore/monitor.h"
+#include "MagickCore/option.h"
 #include "MagickCore/pixel.h"
 #include "MagickCore/pixel-accessor.h"
 #include "MagickCore/pixel-private.h"
@@ -60,13 +64,49 @@
 #include "MagickCore/quantum.h"
 #include "MagickCore/quantum-private.h"
 #include "MagickCore/semaphore.h"
+#include "MagickCore/statistic-private.h"
 #include "MagickCore/stream.h"
 #include "MagickCore/stream-private.h"
 #include "MagickCore/string_.h"
+#include "MagickCore/string-private.h"
 
 /*
   Typedef declarations.
 */
+typedef struct _StreamPipeline
+{
+  Image
+    *image,
+    *resize_image;
+
+  RectangleInfo
+    extract,
+    geometry;
+
+  ColorspaceType
+    colorspace;
+
+  double
+    black_point,
+    gamma,
+    level_gamma,
+    white_point,
+    *x_vector,
+    *y_vector;
+
+  MagickBooleanType
+    flip,
+    flop,
+    level,
+    negate;
+
+  MagickOffsetType
+    offset;
+
+  ssize_t
+    y;
+} StreamPipeline;
+
 struct _StreamInfo
 {
   const ImageInfo
@@ -96,6 +136,9 @@ struct _StreamInfo
   ssize_t
     y;
 
+  StreamPipeline
+    *pipeline;
+
   ExceptionInfo
     *exception;
 
@@ -271,6 +314,21 @@ static void DestroyPixelStream(Image *image)
 %    o stream_info: the stream info.
 %
 */
+
+static StreamPipeline *DestroyStreamPipeline(StreamPipeline *pipeline)
+{
+  if (pipeline->image != (Image *) NULL)
+    pipeline->image=DestroyImage(pipeline->image);
+  if (pipeline->resize_image != (Image *) NULL)
+    pipeline->resize_image=DestroyImage(pipeline->resize_image);
+  if (pipeline->x_vector != (double *) NULL)
+    pipeline->x_vector=(double *) RelinquishMagickMemory(pipeline->x_vector);
+  if (pipeline->y_vector != (double *) NULL)
+    pipeline->y_vector=(double *) RelinquishMagickMemory(pipeline->y_vector);
+  pipeline=(StreamPipeline *) RelinquishMagickMemory(pipeline);
+  return(pipeline);
+}
+
 MagickExport StreamInfo *DestroyStreamInfo(StreamInfo *stream_info)
 {
   assert(stream_info != (StreamInfo *) NULL);
@@ -289,6 +347,8 @@ MagickExport StreamInfo *DestroyStreamInfo(StreamInfo *stream_info)
     }
   if (stream_info->quantum_info != (QuantumInfo *) NULL)
     stream_info->quantum_info=DestroyQuantumInfo(stream_info->quantum_info);
+  if (stream_info->pipeline != (StreamPipeline *) NULL)
+    stream_info->pipeline=DestroyStreamPipeline(stream_info->pipeline);
   stream_info->signature=(~MagickCoreSignature);
   stream_info=(StreamInfo *) RelinquishMagickMemory(stream_info);
   return(stream_info);
@@ -1192,6 +1252,9 @@ MagickExport void SetStreamInfoStorageType(StreamInfo *stream_info,
 %
 %  StreamImage() streams pixels from an image and writes them in a user
 %  defined format and storage type (e.g. RGBA as 8-bit unsigned char).
+%  The stream:flop, stream:level, stream:gamma, stream:negate,
+%  stream:colorspace, stream:resize, and stream:flip defines transform each
+%  row on its way through, in that order.
 %
 %  The format of the StreamImage() method is:
 %
@@ -1208,6 +1271,456 @@ MagickExport void SetStreamInfoStorageType(StreamInfo *stream_info,
 %
 */
 
+static MagickBooleanType AcquireStreamPipeline(StreamInfo *stream_info,
+  const Image *image,const size_t packet_size,ExceptionInfo *exception)
+{
+  const char
+    *option;
+
+  GeometryInfo
+    geometry_info;
+
+  MagickStatusType
+    flags;
+
+  StreamPipeline
+    *pipeline;
+
+  ssize_t
+    colorspace;
+
+  /*
+    Gather the stream:* operators, in the order they are applied.
+  */
+  if (stream_info->pipeline != (StreamPipeline *) NULL)
+    stream_info->pipeline=DestroyStreamPipeline(stream_info->pipeline);
+  pipeline=(StreamPipeline *) AcquireCriticalMemory(sizeof(*pipeline));
+  (void) memset(pipeline,0,sizeof(*pipeline));
+  pipeline->extract=stream_info->extract_info;
+  if ((pipeline->extract.width == 0) || (pipeline->extract.height == 0))
+    SetGeometry(image,&pipeline->extract);
+  if ((pipeline->extract.x < 0) || (pipeline->extract.y < 0) ||
+      (pipeline->extract.x >= (ssize_t) image->columns) ||
+      (pipeline->extract.y >= (ssize_t) image->rows))
+    {
+      pipeline=DestroyStreamPipeline(pipeline);
+      (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+        "GeometryDoesNotContainImage","`%s'",image->filename);
+      return(MagickFalse);
+    }
+  pipeline->extract.width=MagickMin(pipeline->extract.width,image->columns-
+    (size_t) pipeline->extract.x);
+  pipeline->extract.height=MagickMin(pipeline->extract.height,image->rows-
+    (size_t) pipeline->extract.y);
+  pipeline->flop=IsStringTrue(GetImageOption(stream_info->image_info,
+    "stream:flop"));
+  option=GetImageOption(stream_info->image_info,"stream:level");
+  if (option != (const char *) NULL)
+    {
+      flags=ParseGeometry(option,&geometry_info);
+      pipeline->black_point=geometry_info.rho;
+      pipeline->white_point=(double) QuantumRange;
+      if ((flags & SigmaValue) != 0)
+        pipeline->white_point=geometry_info.sigma;
+      pipeline->level_gamma=1.0;
+      if ((flags & XiValue) != 0)
+        pipeline->level_gamma=geometry_info.xi;
+      if ((flags & PercentValue) != 0)
+        {
+          pipeline->black_point*=(double) QuantumRange/100.0;
+          pipeline->white_point*=(double) QuantumRange/100.0;
+        }
+      if ((flags & SigmaValue) == 0)
+        pipeline->white_point=(double) QuantumRange-pipeline->black_point;
+      pipeline->level=MagickTrue;
+    }
+  pipeline->gamma=1.0;
+  option=GetImageOption(stream_info->image_info,"stream:gamma");
+  if (option != (const char *) NULL)
+    pipeline->gamma=StringToDouble(option,(char **) NULL);
+  pipeline->negate=IsStringTrue(GetImageOption(stream_info->image_info,
+    "stream:negate"));
+  pipeline->colorspace=UndefinedColorspace;
+  option=GetImageOption(stream_info->image_info,"stream:colorspace");
+  if (option != (const char *) NULL)
+    {
+      colorspace=ParseCommandOption(MagickColorspaceOptions,MagickFalse,
+        option);
+      if (colorspace < 0)
+        {
+          pipeline=DestroyStreamPipeline(pipeline);
+          (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+            "UnrecognizedColorspace","`%s'",option);
+          return(MagickFalse);
+        }
+      pipeline->colorspace=(ColorspaceType) colorspace;
+    }
+  pipeline->geometry=pipeline->extract;
+  option=GetImageOption(stream_info->image_info,"stream:resize");
+  if (option != (const char *) NULL)
+    {
+      (void) ParseMetaGeometry(option,&pipeline->geometry.x,
+        &pipeline->geometry.y,&pipeline->geometry.width,
+        &pipeline->geometry.height);
+      if ((pipeline->geometry.width == 0) || (pipeline->geometry.height == 0))
+        {
+          pipeline=DestroyStreamPipeline(pipeline);
+          (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+            "GeometryDimensionsAreZero","`%s'",option);
+          return(MagickFalse);
+        }
+    }
+  pipeline->flip=IsStringTrue(GetImageOption(stream_info->image_info,
+    "stream:flip"));
+  if ((pipeline->flop == MagickFalse) && (pipeline->level == MagickFalse) &&
+      (fabs(pipeline->gamma-1.0) < MagickEpsilon) &&
+      (pipeline->negate == MagickFalse) &&
+      (pipeline->colorspace == UndefinedColorspace) &&
+      (pipeline->geometry.width == pipeline->extract.width) &&
+      (pipeline->geometry.height == pipeline->extract.height) &&
+      (pipeline->flip == MagickFalse))
+    {
+      /*
+        No operators, stream the pixels as is.
+      */
+      pipeline=DestroyStreamPipeline(pipeline);
+      return(MagickTrue);
+    }
+  if (pipeline->flip != MagickFalse)
+    {
+      if (IsBlobSeekable(stream_info->stream) == MagickFalse)
+        {
+          pipeline=DestroyStreamPipeline(pipeline);
+          (void) ThrowMagickException(exception,GetMagickModule(),OptionError,
+            "InvalidUseOfOption","`%s': %s","stream:flip",
+            stream_info->stream->filename);
+          return(MagickFalse);
+        }
+      pipeline->offset=TellBlob(stream_info->stream);
+    }
+  /*
+    The working row holds one extracted scanline in the source pixel layout.
+  */
+  pipeline->image=CloneImage(image,pipeline->extract.width,1,MagickTrue,
+    exception);
+  if (pipeline->image == (Image *) NULL)
+    {
+      pipeline=DestroyStreamPipeline(pipeline);
+      return(MagickFalse);
+    }
+  (void) SetImageProgressMonitor(pipeline->image,(MagickProgressMonitor) NULL,
+    (void *) NULL);
+  if (pipeline->geometry.width > image->columns)
+    {
+      (void) RelinquishAlignedMemory(stream_info->pixels);
+      stream_info->pixels=(unsigned char *) AcquireAlignedMemory(
+        pipeline->geometry.width,packet_size);
+      if (stream_info->pixels == (unsigned char *) NULL)
+        {
+          pipeline=DestroyStreamPipeline(pipeline);
+          (void) ThrowMagickException(exception,GetMagickModule(),
+            ResourceLimitError,"MemoryAllocationFailed","`%s'",
+            image->filename);
+          return(MagickFalse);
+        }
+    }
+  stream_info->pipeline=pipeline;
+  return(MagickTrue);
+}
+
+static MagickBooleanType WriteStreamPipelineRow(StreamInfo *stream_info,
+  Image *image,const size_t packet_size,ExceptionInfo *exception)
+{
+  MagickOffsetType
+    offset;
+
+  size_t
+    length;
+
+  ssize_t
+    count;
+
+  StreamPipeline
+    *pipeline;
+
+  /*
+    Write the next output row, bottom-up when flipping.
+  */
+  pipeline=stream_info->pipeline;
+  if (GetAuthenticPixels(image,0,0,image->columns,1,exception) ==
+      (Quantum *) NULL)
+    return(MagickFalse);
+  if (StreamImagePixels(stream_info,image,exception) == MagickFalse)
+    return(MagickFalse);
+  length=packet_size*image->columns;
+  if (pipeline->flip != MagickFalse)
+    {
+      offset=pipeline->offset+(MagickOffsetType) length*((MagickOffsetType)
+        pipeline->geometry.height-pipeline->y-1);
+      if (SeekBlob(stream_info->stream,offset,SEEK_SET) != offset)
+        return(MagickFalse);
+    }
+  count=WriteBlob(stream_info->stream,length,stream_info->pixels);
+  if (count != (ssize_t) length)
+    return(MagickFalse);
+  pipeline->y++;
+  if ((pipeline->flip != MagickFalse) &&
+      (pipeline->y == (ssize_t) pipeline->geometry.height))
+    {
+      offset=pipeline->offset+(MagickOffsetType) (length*
+        pipeline->geometry.height);
+      if (SeekBlob(stream_info->stream,offset,SEEK_SET) != offset)
+        return(MagickFalse);
+    }
+  return(MagickTrue);
+}
+
+static MagickBooleanType ResizeStreamPipelineRow(StreamInfo *stream_info,
+  const ssize_t y,const size_t packet_size,ExceptionInfo *exception)
+{
+  const Quantum
+    *p;
+
+  double
+    alpha;
+
+  MagickSizeType
+    extent,
+    offset,
+    x_offset,
+    y_offset;
+
+  Quantum
+    *q;
+
+  size_t
+    channels,
+    columns,
+    rows;
+
+  ssize_t
+    i,
+    j,
+    x;
+
+  StreamPipeline
+    *pipeline;
+
+  /*
+    Area-average the row into the output grid, as ScaleImage() does, and
+    write each output row as soon as the input rows it covers are in.
+  */
+  pipeline=stream_info->pipeline;
+  channels=GetPixelChannels(pipeline->image);
+  columns=pipeline->geometry.width;
+  rows=pipeline->geometry.height;
+  if (pipeline->resize_image == (Image *) NULL)
+    {
+      pipeline->resize_image=CloneImage(pipeline->image,columns,1,MagickTrue,
+        exception);
+      if (pipeline->resize_image == (Image *) NULL)
+        return(MagickFalse);
+      pipeline->x_vector=(double *) AcquireQuantumMemory(columns,channels*
+        sizeof(*pipeline->x_vector));
+      pipeline->y_vector=(double *) AcquireQuantumMemory(columns,channels*
+        sizeof(*pipeline->y_vector));
+      if ((pipeline->x_vector == (double *) NULL) ||
+          (pipeline->y_vector == (double *) NULL))
+        {
+          (void) ThrowMagickException(exception,GetMagickModule(),
+            ResourceLimitError,"MemoryAllocationFailed","`%s'",
+            pipeline->image->filename);
+          return(MagickFalse);
+        }
+      (void) memset(pipeline->y_vector,0,columns*channels*
+        sizeof(*pipeline->y_vector));
+    }
+  if (GetPixelChannels(pipeline->resize_image) != channels)
+    return(MagickFalse);
+  p=GetVirtualPixels(pipeline->image,0,0,pipeline->image->columns,1,
+    exception);
+  if (p == (const Quantum *) NULL)
+    return(MagickFalse);
+  /*
+    Input column x spans [x*columns,(x+1)*columns) and output column j spans
+    [j*width,(j+1)*width); each contributes by the length of the overlap.
+  */
+  (void) memset(pipeline->x_vector,0,columns*channels*
+    sizeof(*pipeline->x_vector));
+  offset=0;
+  for (x=0, j=0; x < (ssize_t) pipeline->image->columns; )
+  {
+    double
+      weight;
+
+    x_offset=(MagickSizeType) (x+1)*columns;
+    y_offset=(MagickSizeType) (j+1)*pipeline->image->columns;
+    extent=MagickMin(x_offset,y_offset)-offset;
+    weight=(double) extent/pipeline->image->columns;
+    alpha=1.0;
+    if (pipeline->image->alpha_trait != UndefinedPixelTrait)
+      alpha=QuantumScale*(double) GetPixelAlpha(pipeline->image,p);
+    for (i=0; i < (ssize_t) channels; i++)
+    {
+      double
+        pixel;
+
+      PixelChannel channel = GetPixelChannelChannel(pipeline->image,i);
+      PixelTrait traits = GetPixelChannelTraits(pipeline->image,channel);
+      if (traits == UndefinedPixelTrait)
+        continue;
+      pixel=(double) p[i];
+      if (((traits & BlendPixelTrait) != 0) && (channel != AlphaPixelChannel))
+        pixel*=alpha;
+      pipeline->x_vector[j*(ssize_t) channels+i]+=weight*pixel;
+    }
+    offset+=extent;
+    if (offset == x_offset)
+      {
+        p+=(ptrdiff_t) channels;
+        x++;
+      }
+    if (offset == y_offset)
+      j++;
+  }
+  /*
+    Input row y spans [y*rows,(y+1)*rows) and output row pipeline->y spans
+    [pipeline->y*height,(pipeline->y+1)*height).
+  */
+  offset=(MagickSizeType) y*rows;
+  while (offset < ((MagickSizeType) (y+1)*rows))
+  {
+    double
+      weight;
+
+    y_offset=(MagickSizeType) (pipeline->y+1)*pipeline->extract.height;
+    extent=MagickMin((MagickSizeType) (y+1)*rows,y_offset)-offset;
+    weight=(double) extent/pipeline->extract.height;
+    for (i=0; i < (ssize_t) (columns*channels); i++)
+      pipeline->y_vector[i]+=weight*pipeline->x_vector[i];
+    offset+=extent;
+    if (offset != y_offset)
+      continue;
+    q=QueueAuthenticPixels(pipeline->resize_image,0,0,columns,1,exception);
+    if (q == (Quantum *) NULL)
+      return(MagickFalse);
+    for (x=0; x < (ssize_t) columns; x++)
+    {
+      const double
+        *pixels = pipeline->y_vector+x*(ssize_t) channels;
+
+      alpha=1.0;
+      if (pipeline->resize_image->alpha_trait != UndefinedPixelTrait)
+        alpha=MagickSafeReciprocal(QuantumScale*pixels[GetPixelChannelOffset(
+          pipeline->resize_image,AlphaPixelChannel)]);
+      for (i=0; i < (ssize_t) channels; i++)
+      {
+        double
+          pixel;
+
+        PixelChannel channel = GetPixelChannelChannel(pipeline->resize_image,
+          i);
+        PixelTrait traits = GetPixelChannelTraits(pipeline->resize_image,
+          channel);
+        if (traits == UndefinedPixelTrait)
+          continue;
+        pixel=pixels[i];
+        if (((traits & BlendPixelTrait) != 0) &&
+            (channel != AlphaPixelChannel))
+          pixel*=alpha;
+        q[i]=ClampToQuantum(pixel);
+      }
+      q+=(ptrdiff_t) channels;
+    }
+    if (SyncAuthenticPixels(pipeline->resize_image,exception) == MagickFalse)
+      return(MagickFalse);
+    (void) memset(pipeline->y_vector,0,columns*channels*
+      sizeof(*pipeline->y_vector));
+    if (WriteStreamPipelineRow(stream_info,pipeline->resize_image,packet_size,
+        exception) == MagickFalse)
+      return(MagickFalse);
+  }
+  return(MagickTrue);
+}
+
+static MagickBooleanType StreamPipelinePixels(StreamInfo *stream_info,
+  const Image *image,const size_t packet_size,ExceptionInfo *exception)
+{
+  const Quantum
+    *p;
+
+  MagickStatusType
+    status;
+
+  Quantum
+    *q;
+
+  size_t
+    channels;
+
+  ssize_t
+    x;
+
+  StreamPipeline
+    *pipeline;
+
+  /*
+    Run one extracted row through flop, level, gamma, negate, colorspace,
+    resize and flip.
+  */
+  pipeline=stream_info->pipeline;
+  if (pipeline->image->colorspace != image->colorspace)
+    (void) SetImageColorspace(pipeline->image,image->colorspace,exception);
+  channels=GetPixelChannels(image);
+  if (GetPixelChannels(pipeline->image) != channels)
+    return(MagickFalse);
+  p=GetAuthenticPixelQueue(image);
+  if (p == (const Quantum *) NULL)
+    return(MagickFalse);
+  p+=(ptrdiff_t) channels*pipeline->extract.x;
+  q=QueueAuthenticPixels(pipeline->image,0,0,pipeline->image->columns,1,
+    exception);
+  if (q == (Quantum *) NULL)
+    return(MagickFalse);
+  if (pipeline->flop == MagickFalse)
+    (void) memcpy(q,p,pipeline->image->columns*channels*sizeof(*q));
+  else
+    {
+      q+=(ptrdiff_t) channels*(ssize_t) (pipeline->image->columns-1);
+      for (x=0; x < (ssize_t) pipeline->image->columns; x++)
+      {
+        (void) memcpy(q,p,channels*sizeof(*q));
+        p+=(ptrdiff_t) channels;
+        q-=(ptrdiff_t) channels;
+      }
+    }
+  if (SyncAuthenticPixels(pipeline->image,exception) == MagickFalse)
+    return(MagickFalse);
+  status=MagickTrue;
+  if (pipeline->level != MagickFalse)
+    status&=(MagickStatusType) LevelImage(pipeline->image,
+      pipeline->black_point,pipeline->white_point,pipeline->level_gamma,
+      exception);
+  if (fabs(pipeline->gamma-1.0) >= MagickEpsilon)
+    status&=(MagickStatusType) GammaImage(pipeline->image,pipeline->gamma,
+      exception);
+  if (pipeline->negate != MagickFalse)
+    status&=(MagickStatusType) NegateImage(pipeline->image,MagickFalse,
+      exception);
+  if (pipeline->colorspace != UndefinedColorspace)
+    status&=(MagickStatusType) TransformImageColorspace(pipeline->image,
+      pipeline->colorspace,exception);
+  if (status == MagickFalse)
+    return(MagickFalse);
+  if ((pipeline->geometry.width == pipeline->extract.width) &&
+      (pipeline->geometry.height == pipeline->extract.height))
+    return(WriteStreamPipelineRow(stream_info,pipeline->image,packet_size,
+      exception));
+  return(ResizeStreamPipelineRow(stream_info,stream_info->y-
+    pipeline->extract.y,packet_size,exception));
+}
+
+
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
 #endif
@@ -1269,6 +1782,26 @@ static size_t WriteStreamImage(const Image *image,const void *pixels,
           &stream_info->extract_info);
       stream_info->y=0;
       write_info=DestroyImageInfo(write_info);
+      if (AcquireStreamPipeline(stream_info,image,packet_size,
+          stream_info->exception) == MagickFalse)
+        return(0);
+    }
+  if (stream_info->pipeline != (StreamPipeline *) NULL)
+    {
+      MagickBooleanType
+        status;
+
+      /*
+        Pass the pixel row through the stream operators.
+      */
+      status=MagickTrue;
+      if ((stream_info->y >= stream_info->pipeline->extract.y) &&
+          (stream_info->y < (stream_info->pipeline->extract.y+(ssize_t)
+           stream_info->pipeline->extract.height)))
+        status=StreamPipelinePixels(stream_info,image,packet_size,
+          stream_info->exception);
+      stream_info->y++;
+      return(status == MagickFalse ? 0 : columns);
     }
   extract_info=stream_info->extract_info;
   if ((extract_info.width == 0) || (extract_info.height == 0))
@@ -205,6 +205,9 @@ static MagickBooleanType
 static MagickBooleanType DecodeImage(Image *image,const size_t compression,
   unsigned char *pixels,const size_t number_pixels)
 {
+  BlobReader
+    reader;
+
   int
     byte,
     count;
@@ -224,6 +227,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
   if (IsEventLogging() != MagickFalse)
     (void) LogMagickEvent(TraceEvent,GetMagickModule(),"%s",image->filename);
   (void) memset(pixels,0,number_pixels*sizeof(*pixels));
+  GetBlobReader(image,&reader);
   byte=0;
   x=0;
   p=pixels;
@@ -235,7 +239,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
 
     if ((p < pixels) || (p >= q))
       break;
-    count=ReadBlobByte(image);
+    count=ReadBlobReaderByte(&reader);
     if (count == EOF)
       break;
     if (count > 0)
@@ -244,7 +248,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
           Encoded mode.
         */
         count=(int) MagickMin((ssize_t) count,(ssize_t) (q-p));
-        byte=ReadBlobByte(image);
+        byte=ReadBlobReaderByte(&reader);
         if (byte == EOF)
           break;
         if (compression == BI_RLE8)
@@ -265,7 +269,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
         /*
           Escape mode.
         */
-        count=ReadBlobByte(image);
+        count=ReadBlobReaderByte(&reader);
         if (count == EOF)
           break;
         if (count == 0x01)
@@ -287,13 +291,19 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
             /*
               Delta mode.
             */
-            byte=ReadBlobByte(image);
+            byte=ReadBlobReaderByte(&reader);
             if (byte == EOF)
-              return(MagickFalse);
+              {
+                SyncBlobReader(&reader);
+                return(MagickFalse);
+              }
             x+=byte;
-            byte=ReadBlobByte(image);
+            byte=ReadBlobReaderByte(&reader);
             if (byte == EOF)
-              return(MagickFalse);
+              {
+                SyncBlobReader(&reader);
+                return(MagickFalse);
+              }
             y+=byte;
             p=pixels+y*(ssize_t) image->columns+x;
             break;
@@ -309,7 +319,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
             if (compression == BI_RLE8)
               for (i=0; i < (ssize_t) count; i++)
               {
-                byte=ReadBlobByte(image);
+                byte=ReadBlobReaderByte(&reader);
                 if (byte == EOF)
                   break;
                 *p++=(unsigned char) byte;
@@ -319,7 +329,7 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
               {
                 if ((i & 0x01) == 0)
                   {
-                    byte=ReadBlobByte(image);
+                    byte=ReadBlobReaderByte(&reader);
                     if (byte == EOF)
                       break;
                   }
@@ -333,12 +343,12 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
             if (compression == BI_RLE8)
               {
                 if ((count & 0x01) != 0)
-                  if (ReadBlobByte(image) == EOF)
+                  if (ReadBlobReaderByte(&reader) == EOF)
                     break;
               }
             else
               if (((count & 0x03) == 1) || ((count & 0x03) == 2))
-                if (ReadBlobByte(image) == EOF)
+                if (ReadBlobReaderByte(&reader) == EOF)
                   break;
             break;
           }
@@ -349,8 +359,9 @@ static MagickBooleanType DecodeImage(Image *image,const size_t compression,
     if (status == MagickFalse)
       break;
   }
-  (void) ReadBlobByte(image);  /* end of line */
-  (void) ReadBlobByte(image);
+  (void) ReadBlobReaderByte(&reader);  /* end of line */
+  (void) ReadBlobReaderByte(&reader);
+  SyncBlobReader(&reader);
   return((p-pixels) < (ssize_t) number_pixels ? MagickFalse : MagickTrue);
 }
 
@@ -17,8 +17,14 @@
 #define MAGICK_CODERS_PRIVATE_H
 
 #include "MagickCore/attribute.h"
+#include "MagickCore/blob-private.h"
+#include "MagickCore/cache.h"
 #include "MagickCore/colorspace-private.h"
+#include "MagickCore/exception-private.h"
+#include "MagickCore/image-private.h"
+#include "MagickCore/monitor-private.h"
 #include "MagickCore/property.h"
+#include "MagickCore/quantum.h"
 #include "MagickCore/string_.h"
 #include "MagickCore/thread-private.h"
 
@@ -36,6 +42,52 @@ extern ModuleExport size_t \
 extern ModuleExport void \
   Unregister ## coder ## Image(void);
 
+static inline MagickBooleanType ImportCoderQuantumRows(Image *image,
+  QuantumInfo *quantum_info,const QuantumType quantum_type,
+  unsigned char *pixels,const void **stream,size_t *length,ssize_t *count,
+  ExceptionInfo *exception)
+{
+  MagickBooleanType
+    status;
+
+  ssize_t
+    y;
+
+  /*
+    Import each row straight from the blob into the image.  The first row
+    must already be in stream; on return the row after the image is.
+  */
+  status=MagickTrue;
+  for (y=0; y < (ssize_t) image->rows; y++)
+  {
+    Quantum
+      *magick_restrict q;
+
+    if (*count != (ssize_t) *length)
+      {
+        ThrowFileException(exception,CorruptImageError,"UnexpectedEndOfFile",
+          image->filename);
+        return(MagickFalse);
+      }
+    q=QueueAuthenticPixels(image,0,y,image->columns,1,exception);
+    if (q == (Quantum *) NULL)
+      break;
+    *length=ImportQuantumPixels(image,(CacheView *) NULL,quantum_info,
+      quantum_type,(unsigned char *) *stream,exception);
+    if (SyncAuthenticPixels(image,exception) == MagickFalse)
+      break;
+    if (image->previous == (Image *) NULL)
+      {
+        status=SetImageProgress(image,LoadImageTag,(MagickOffsetType) y,
+          image->rows);
+        if (status == MagickFalse)
+          break;
+      }
+    *stream=ReadBlobStream(image,*length,pixels,count);
+  }
+  return(status);
+}
+
 static inline ImageType IdentifyImageCoderType(const Image *image,
   ExceptionInfo *exception)
 {
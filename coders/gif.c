@@ -72,6 +72,7 @@
 #include "MagickCore/static.h"
 #include "MagickCore/string_.h"
 #include "MagickCore/string-private.h"
+#include "MagickCore/thread-private.h"
 #include "MagickCore/module.h"
 
 /*
@@ -83,6 +84,27 @@
 /*
   Typedef declarations.
 */
+typedef struct _GIFFrameInfo
+{
+  MagickBooleanType
+    status;
+
+  ssize_t
+    opacity;
+
+  short
+    *code_table;
+
+  size_t
+    bits_per_pixel,
+    *code_key,
+    extent,
+    length;
+
+  unsigned char
+    *data;
+} GIFFrameInfo;
+
 typedef struct _LZWCodeInfo
 {
   unsigned char
@@ -517,12 +539,15 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity,
 %                                                                             %
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %
-%  EncodeImage compresses an image via GIF-coding.
+%  EncodeImage compresses an image via GIF-coding.  The compressed data
+%  sub-blocks are accumulated in the frame buffer rather than written to the
+%  image blob so that frames can be encoded concurrently and emitted in order.
 %
 %  The format of the EncodeImage method is:
 %
 %      MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
-%        const size_t data_size)
+%        const size_t data_size,GIFFrameInfo *frame_info,
+%        ExceptionInfo *exception)
 %
 %  A description of each parameter follows:
 %
@@ -532,12 +557,45 @@ static MagickBooleanType DecodeImage(Image *image,const ssize_t opacity,
 %
 %    o data_size:  The number of bits in the compressed packet.
 %
+%    o frame_info: the frame buffer.
+%
+%    o exception: return any errors or warnings in this structure.
+%
 */
+
+static MagickBooleanType WriteGIFPacket(GIFFrameInfo *frame_info,
+  const unsigned char *packet,const size_t length)
+{
+  /*
+    Append a data sub-block (length byte followed by the packet).
+  */
+  if ((frame_info->length+length+1) > frame_info->extent)
+    {
+      unsigned char
+        *data;
+
+      size_t
+        extent;
+
+      extent=MagickMax(2*frame_info->extent,frame_info->length+length+1);
+      extent=MagickMax(extent,4096);
+      data=(unsigned char *) ResizeQuantumMemory(frame_info->data,extent,
+        sizeof(*frame_info->data));
+      if (data == (unsigned char *) NULL)
+        return(MagickFalse);
+      frame_info->data=data;
+      frame_info->extent=extent;
+    }
+  frame_info->data[frame_info->length++]=(unsigned char) length;
+  (void) memcpy(frame_info->data+frame_info->length,packet,length);
+  frame_info->length+=length;
+  return(MagickTrue);
+}
+
 static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
-  const size_t data_size,ExceptionInfo *exception)
+  const size_t data_size,GIFFrameInfo *frame_info,ExceptionInfo *exception)
 {
 #define MaxCode(number_bits)  ((one << (number_bits))-1)
-#define MaxHashTable  5003
 #define MaxGIFBits  12UL
 #define MaxGIFTable  (1UL << MaxGIFBits)
 #define GIFOutputCode(code) \
@@ -558,8 +616,8 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     packet[length++]=(unsigned char) (datum & 0xff); \
     if (length == 255) \
       { \
-        (void) WriteBlobByte(image,(unsigned char) length); \
-        (void) WriteBlob(image,length,packet); \
+        if (WriteGIFPacket(frame_info,packet,length) == MagickFalse) \
+          status=MagickFalse; \
         length=0; \
       } \
     datum>>=8; \
@@ -575,12 +633,15 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     } \
 }
 
+  MagickBooleanType
+    status;
+
   Quantum
     index;
 
   short
-    *hash_code,
-    *hash_prefix,
+    code,
+    *code_table,
     waiting_code;
 
   size_t
@@ -591,52 +652,51 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     free_code,
     length,
     max_code,
-    next_pixel,
     number_bits,
     one,
     pass;
 
+  size_t
+    *code_key,
+    key;
+
   ssize_t
-    displacement,
     offset,
-    k,
     y;
 
   unsigned char
-    *packet,
-    *hash_suffix;
+    *packet;
 
   /*
-    Allocate encoder tables.
+    Allocate encoder tables.  The string table is a direct-indexed trie: the
+    child of code c with suffix s is code_table[(c << 8) | s].  The table is
+    zeroed once per frame buffer; code_key records the slot each code took so
+    only those slots are cleared at a clear code and at the end of the frame.
   */
   assert(image != (Image *) NULL);
   one=1;
-  packet=(unsigned char *) AcquireQuantumMemory(256,sizeof(*packet));
-  hash_code=(short *) AcquireQuantumMemory(MaxHashTable,sizeof(*hash_code));
-  hash_prefix=(short *) AcquireQuantumMemory(MaxHashTable,sizeof(*hash_prefix));
-  hash_suffix=(unsigned char *) AcquireQuantumMemory(MaxHashTable,
-    sizeof(*hash_suffix));
-  if ((packet == (unsigned char *) NULL) || (hash_code == (short *) NULL) ||
-      (hash_prefix == (short *) NULL) ||
-      (hash_suffix == (unsigned char *) NULL))
+  if (frame_info->code_table == (short *) NULL)
     {
-      if (packet != (unsigned char *) NULL)
-        packet=(unsigned char *) RelinquishMagickMemory(packet);
-      if (hash_code != (short *) NULL)
-        hash_code=(short *) RelinquishMagickMemory(hash_code);
-      if (hash_prefix != (short *) NULL)
-        hash_prefix=(short *) RelinquishMagickMemory(hash_prefix);
-      if (hash_suffix != (unsigned char *) NULL)
-        hash_suffix=(unsigned char *) RelinquishMagickMemory(hash_suffix);
-      return(MagickFalse);
+      frame_info->code_table=(short *) AcquireQuantumMemory(MaxGIFTable << 8,
+        sizeof(*frame_info->code_table));
+      frame_info->code_key=(size_t *) AcquireQuantumMemory(MaxGIFTable,
+        sizeof(*frame_info->code_key));
+      if ((frame_info->code_table == (short *) NULL) ||
+          (frame_info->code_key == (size_t *) NULL))
+        return(MagickFalse);
+      (void) memset(frame_info->code_table,0,(MaxGIFTable << 8)*
+        sizeof(*frame_info->code_table));
     }
+  code_table=frame_info->code_table;
+  code_key=frame_info->code_key;
+  packet=(unsigned char *) AcquireQuantumMemory(256,sizeof(*packet));
+  if (packet == (unsigned char *) NULL)
+    return(MagickFalse);
   /*
     Initialize GIF encoder.
   */
   (void) memset(packet,0,256*sizeof(*packet));
-  (void) memset(hash_code,0,MaxHashTable*sizeof(*hash_code));
-  (void) memset(hash_prefix,0,MaxHashTable*sizeof(*hash_prefix));
-  (void) memset(hash_suffix,0,MaxHashTable*sizeof(*hash_suffix));
+  status=MagickTrue;
   number_bits=data_size;
   max_code=MaxCode(number_bits);
   clear_code=(size_t) ((short) one << (data_size-1));
@@ -671,62 +731,31 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
     for (x=(ssize_t) (y == 0 ? 1 : 0); x < (ssize_t) image->columns; x++)
     {
       /*
-        Probe hash table.
+        Look up the string extended by this pixel.
       */
-      next_pixel=MagickFalse;
-      displacement=1;
       index=(Quantum) ((size_t) GetPixelIndex(image,p) & 0xff);
       p+=(ptrdiff_t) GetPixelChannels(image);
-      k=(ssize_t) (((size_t) index << (MaxGIFBits-8))+(size_t) waiting_code);
-      if (k >= MaxHashTable)
-        k-=MaxHashTable;
-      if (k < 0)
-        continue;
-      if (hash_code[k] > 0)
+      key=((size_t) waiting_code << 8) | (size_t) index;
+      code=code_table[key];
+      if (code != 0)
         {
-          if ((hash_prefix[k] == waiting_code) &&
-              (hash_suffix[k] == (unsigned char) index))
-            {
-              waiting_code=hash_code[k];
-              continue;
-            }
-          if (k != 0)
-            displacement=MaxHashTable-k;
-          for ( ; ; )
-          {
-            k-=displacement;
-            if (k < 0)
-              k+=MaxHashTable;
-            if (hash_code[k] == 0)
-              break;
-            if ((hash_prefix[k] == waiting_code) &&
-                (hash_suffix[k] == (unsigned char) index))
-              {
-                waiting_code=hash_code[k];
-                next_pixel=MagickTrue;
-                break;
-              }
-          }
-          if (next_pixel != MagickFalse)
-            continue;
+          waiting_code=code;
+          continue;
         }
       GIFOutputCode(waiting_code);
       if (free_code < MaxGIFTable)
         {
-          hash_code[k]=(short) free_code++;
-          hash_prefix[k]=waiting_code;
-          hash_suffix[k]=(unsigned char) index;
+          code_table[key]=(short) free_code;
+          code_key[free_code]=key;
+          free_code++;
         }
       else
         {
-          /*
-            Fill the hash table with empty entries.
-          */
-          for (k=0; k < MaxHashTable; k++)
-            hash_code[k]=0;
           /*
             Reset compressor and issue a clear code.
           */
+          for (code=(short) (clear_code+2); code < (short) free_code; code++)
+            code_table[code_key[code]]=0;
           free_code=clear_code+2;
           GIFOutputCode(clear_code);
           number_bits=data_size;
@@ -790,27 +819,24 @@ static MagickBooleanType EncodeImage(const ImageInfo *image_info,Image *image,
       packet[length++]=(unsigned char) (datum & 0xff);
       if (length == 255)
         {
-          (void) WriteBlobByte(image,(unsigned char) length);
-          (void) WriteBlob(image,length,packet);
+          if (WriteGIFPacket(frame_info,packet,length) == MagickFalse)
+            status=MagickFalse;
           length=0;
         }
     }
   /*
     Flush accumulated data.
   */
-  if (length > 0)
-    {
-      (void) WriteBlobByte(image,(unsigned char) length);
-      (void) WriteBlob(image,length,packet);
-    }
+  if ((length > 0) &&
+      (WriteGIFPacket(frame_info,packet,length) == MagickFalse))
+    status=MagickFalse;
   /*
-    Free encoder memory.
+    Leave the string table empty for the next frame and free encoder memory.
   */
-  hash_suffix=(unsigned char *) RelinquishMagickMemory(hash_suffix);
-  hash_prefix=(short *) RelinquishMagickMemory(hash_prefix);
-  hash_code=(short *) RelinquishMagickMemory(hash_code);
+  for (code=(short) (clear_code+2); code < (short) free_code; code++)
+    code_table[code_key[code]]=0;
   packet=(unsigned char *) RelinquishMagickMemory(packet);
-  return(MagickTrue);
+  return(status);
 }
 
 /*
@@ -1491,21 +1517,101 @@ ModuleExport void UnregisterGIFImage(void)
 %    o exception: return any errors or warnings in this structure.
 %
 */
-static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image,
-  ExceptionInfo *exception)
+static MagickBooleanType EncodeGIFFrame(const ImageInfo *image_info,
+  Image *image,GIFFrameInfo *frame_info,ExceptionInfo *exception)
 {
-  ImageInfo
-    *write_info;
+  size_t
+    bits_per_pixel,
+    one;
+
+  ssize_t
+    i,
+    opacity;
 
+  /*
+    Reduce the frame to a colormap and LZW-encode its pixels.
+  */
+  one=1;
+  if (IssRGBCompatibleColorspace(image->colorspace) == MagickFalse)
+    (void) TransformImageColorspace(image,sRGBColorspace,exception);
+  opacity=(-1);
+  if (IsImageOpaque(image,exception) != MagickFalse)
+    {
+      if ((image->storage_class == DirectClass) || (image->colors > 256))
+        (void) SetImageType(image,PaletteType,exception);
+    }
+  else
+    {
+      double
+        alpha,
+        beta;
+
+      /*
+        Identify transparent colormap index.
+      */
+      if ((image->storage_class == DirectClass) || (image->colors > 256))
+        (void) SetImageType(image,PaletteBilevelAlphaType,exception);
+      for (i=0; i < (ssize_t) image->colors; i++)
+        if (image->colormap[i].alpha != (double) OpaqueAlpha)
+          {
+            if (opacity < 0)
+              {
+                opacity=i;
+                continue;
+              }
+            alpha=fabs(image->colormap[i].alpha-(double) TransparentAlpha);
+            beta=fabs(image->colormap[opacity].alpha-(double)
+              TransparentAlpha);
+            if (alpha < beta)
+              opacity=i;
+          }
+      if (opacity == -1)
+        {
+          (void) SetImageType(image,PaletteBilevelAlphaType,exception);
+          for (i=0; i < (ssize_t) image->colors; i++)
+            if (image->colormap[i].alpha != (double) OpaqueAlpha)
+              {
+                if (opacity < 0)
+                  {
+                    opacity=i;
+                    continue;
+                  }
+                alpha=fabs(image->colormap[i].alpha-(double)
+                  TransparentAlpha);
+                beta=fabs(image->colormap[opacity].alpha-(double)
+                  TransparentAlpha);
+                if (alpha < beta)
+                  opacity=i;
+              }
+        }
+      if (opacity >= 0)
+        {
+          image->colormap[opacity].red=image->transparent_color.red;
+          image->colormap[opacity].green=image->transparent_color.green;
+          image->colormap[opacity].blue=image->transparent_color.blue;
+        }
+    }
+  frame_info->opacity=opacity;
+  if ((image->storage_class == DirectClass) || (image->colors > 256))
+    return(MagickFalse);
+  for (bits_per_pixel=1; bits_per_pixel < 8; bits_per_pixel++)
+    if ((one << bits_per_pixel) >= image->colors)
+      break;
+  frame_info->bits_per_pixel=bits_per_pixel;
+  return(EncodeImage(image_info,image,(size_t) MagickMax(bits_per_pixel,2)+1,
+    frame_info,exception));
+}
+
+static MagickBooleanType WriteGIFFrame(const ImageInfo *image_info,
+  Image *image,const GIFFrameInfo *frame_info,unsigned char *global_colormap,
+  unsigned char *colormap,ExceptionInfo *exception)
+{
   int
     c;
 
   MagickBooleanType
     status;
 
-  MagickOffsetType
-    scene;
-
   RectangleInfo
     page;
 
@@ -1513,7 +1619,6 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image,
     bits_per_pixel,
     delay,
     length,
-    number_scenes,
     one;
 
   ssize_t
@@ -1522,10 +1627,303 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image,
     opacity;
 
   unsigned char
-    *colormap,
-    *global_colormap,
     *q;
 
+  /*
+    Write the frame extensions, descriptor, and its encoded pixels.
+  */
+  one=1;
+  opacity=frame_info->opacity;
+  bits_per_pixel=frame_info->bits_per_pixel;
+  q=colormap;
+  for (i=0; i < (ssize_t) image->colors; i++)
+  {
+    *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].red));
+    *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].green));
+    *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].blue));
+  }
+  for ( ; i < (ssize_t) (one << bits_per_pixel); i++)
+  {
+    *q++=(unsigned char) 0x0;
+    *q++=(unsigned char) 0x0;
+    *q++=(unsigned char) 0x0;
+  }
+  if ((GetPreviousImageInList(image) == (Image *) NULL) ||
+      (image_info->adjoin == MagickFalse))
+    {
+      /*
+        Write global colormap.
+      */
+      c=0x80;
+      c|=(8-1) << 4;  /* color resolution */
+      c|=(int) (bits_per_pixel-1);   /* size of global colormap */
+      (void) WriteBlobByte(image,(unsigned char) c);
+      for (j=0; j < (ssize_t) image->colors; j++)
+        if (IsPixelInfoEquivalent(&image->background_color,image->colormap+j))
+          break;
+      (void) WriteBlobByte(image,(unsigned char)
+        (j == (ssize_t) image->colors ? 0 : j));  /* background color */
+      (void) WriteBlobByte(image,(unsigned char) 0x00);  /* reserved */
+      length=(size_t) (3*(one << bits_per_pixel));
+      (void) WriteBlob(image,length,colormap);
+      for (j=0; j < 768; j++)
+        global_colormap[j]=colormap[j];
+    }
+  if (LocaleCompare(image_info->magick,"GIF87") != 0)
+    {
+      const char
+        *value;
+
+      if ((GetPreviousImageInList(image) == (Image *) NULL) &&
+          (GetNextImageInList(image) != (Image *) NULL) &&
+          (image->iterations != 1))
+        {
+          /*
+            Write Netscape Loop extension.
+          */
+          (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+             "  Writing GIF Extension %s","NETSCAPE2.0");
+          (void) WriteBlobByte(image,(unsigned char) 0x21);
+          (void) WriteBlobByte(image,(unsigned char) 0xff);
+          (void) WriteBlobByte(image,(unsigned char) 0x0b);
+          (void) WriteBlob(image,11,(unsigned char *) "NETSCAPE2.0");
+          (void) WriteBlobByte(image,(unsigned char) 0x03);
+          (void) WriteBlobByte(image,(unsigned char) 0x01);
+          (void) WriteBlobLSBShort(image,(unsigned short) (image->iterations ?
+            image->iterations-1 : 0));
+          (void) WriteBlobByte(image,(unsigned char) 0x00);
+        }
+      /*
+        Write graphics control extension.
+      */
+      (void) WriteBlobByte(image,(unsigned char) 0x21);
+      (void) WriteBlobByte(image,(unsigned char) 0xf9);
+      (void) WriteBlobByte(image,(unsigned char) 0x04);
+      c=(int) (image->dispose << 2);
+      if (opacity >= 0)
+        c|=0x01;
+      (void) WriteBlobByte(image,(unsigned char) c);
+      delay=(size_t) (100*image->delay/MagickMax((size_t)
+        image->ticks_per_second,1));
+      (void) WriteBlobLSBShort(image,(unsigned short) delay);
+      (void) WriteBlobByte(image,(unsigned char) (opacity >= 0 ? opacity :
+        0));
+      (void) WriteBlobByte(image,(unsigned char) 0x00);
+      if (fabs(image->gamma-1.0/2.2) > MagickEpsilon)
+        {
+          char
+            attributes[MagickPathExtent];
+
+          ssize_t
+            count;
+
+          /*
+            Write ImageMagick extension.
+          */
+          (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+             "  Writing GIF Extension %s","ImageMagick");
+          (void) WriteBlobByte(image,(unsigned char) 0x21);
+          (void) WriteBlobByte(image,(unsigned char) 0xff);
+          (void) WriteBlobByte(image,(unsigned char) 0x0b);
+          (void) WriteBlob(image,11,(unsigned char *) "ImageMagick");
+          count=FormatLocaleString(attributes,MagickPathExtent,"gamma=%g",
+            image->gamma);
+          (void) WriteBlobByte(image,(unsigned char) count);
+          (void) WriteBlob(image,(size_t) count,(unsigned char *) attributes);
+          (void) WriteBlobByte(image,(unsigned char) 0x00);
+        }
+      value=GetImageProperty(image,"comment",exception);
+      if (value != (const char *) NULL)
+        {
+          const char
+            *p;
+
+          size_t
+            count;
+
+          /*
+            Write comment extension.
+          */
+          (void) WriteBlobByte(image,(unsigned char) 0x21);
+          (void) WriteBlobByte(image,(unsigned char) 0xfe);
+          for (p=value; *p != '\0'; )
+          {
+            count=MagickMin(strlen(p),255);
+            (void) WriteBlobByte(image,(unsigned char) count);
+            for (i=0; i < (ssize_t) count; i++)
+              (void) WriteBlobByte(image,(unsigned char) *p++);
+          }
+          (void) WriteBlobByte(image,(unsigned char) 0x00);
+        }
+      ResetImageProfileIterator(image);
+      for ( ; ; )
+      {
+        char
+          *name;
+
+        const StringInfo
+          *profile;
+
+        name=GetNextImageProfile(image);
+        if (name == (const char *) NULL)
+          break;
+        profile=GetImageProfile(image,name);
+        if (profile != (StringInfo *) NULL)
+        {
+          if ((LocaleCompare(name,"ICC") == 0) ||
+              (LocaleCompare(name,"ICM") == 0) ||
+              (LocaleCompare(name,"IPTC") == 0) ||
+              (LocaleCompare(name,"8BIM") == 0) ||
+              (LocaleNCompare(name,"gif:",4) == 0))
+          {
+             ssize_t
+               offset;
+
+             unsigned char
+               *datum;
+
+             datum=GetStringInfoDatum(profile);
+             length=GetStringInfoLength(profile);
+             (void) WriteBlobByte(image,(unsigned char) 0x21);
+             (void) WriteBlobByte(image,(unsigned char) 0xff);
+             (void) WriteBlobByte(image,(unsigned char) 0x0b);
+             if ((LocaleCompare(name,"ICC") == 0) ||
+                 (LocaleCompare(name,"ICM") == 0))
+               {
+                 /*
+                   Write ICC extension.
+                 */
+                 (void) WriteBlob(image,11,(unsigned char *) "ICCRGBG1012");
+                 (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+                   "  Writing GIF Extension %s","ICCRGBG1012");
+               }
+             else
+               if ((LocaleCompare(name,"IPTC") == 0))
+                 {
+                   /*
+                     Write IPTC extension.
+                   */
+                   (void) WriteBlob(image,11,(unsigned char *) "MGKIPTC0000");
+                   (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+                     "  Writing GIF Extension %s","MGKIPTC0000");
+                 }
+               else
+                 if ((LocaleCompare(name,"8BIM") == 0))
+                   {
+                     /*
+                       Write 8BIM extension.
+                     */
+                      (void) WriteBlob(image,11,(unsigned char *)
+                        "MGK8BIM0000");
+                      (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+                        "  Writing GIF Extension %s","MGK8BIM0000");
+                   }
+                 else
+                   {
+                     char
+                       extension[MagickPathExtent];
+
+                     /*
+                       Write generic extension.
+                     */
+                     (void) memset(extension,0,sizeof(extension));
+                     (void) CopyMagickString(extension,name+4,
+                       sizeof(extension));
+                     (void) WriteBlob(image,11,(unsigned char *) extension);
+                     (void) LogMagickEvent(CoderEvent,GetMagickModule(),
+                       "  Writing GIF Extension %s",name);
+                   }
+             offset=0;
+             while ((ssize_t) length > offset)
+             {
+               size_t
+                 block_length;
+
+               if (((ssize_t) length-offset) < 255)
+                 block_length=(size_t) ((ssize_t) length-offset);
+               else
+                 block_length=255;
+               (void) WriteBlobByte(image,(unsigned char) block_length);
+               (void) WriteBlob(image,(size_t) block_length,datum+offset);
+               offset+=(ssize_t) block_length;
+             }
+             (void) WriteBlobByte(image,(unsigned char) 0x00);
+          }
+        }
+      }
+    }
+  (void) WriteBlobByte(image,',');  /* image separator */
+  /*
+    Write the image header.
+  */
+  page.x=image->page.x;
+  page.y=image->page.y;
+  if ((image->page.width != 0) && (image->page.height != 0))
+    page=image->page;
+  (void) WriteBlobLSBShort(image,(unsigned short) (page.x < 0 ? 0 : page.x));
+  (void) WriteBlobLSBShort(image,(unsigned short) (page.y < 0 ? 0 : page.y));
+  (void) WriteBlobLSBShort(image,(unsigned short) image->columns);
+  (void) WriteBlobLSBShort(image,(unsigned short) image->rows);
+  c=0x00;
+  if (image_info->interlace != NoInterlace)
+    c|=0x40;  /* pixel data is interlaced */
+  for (j=0; j < (ssize_t) (3*image->colors); j++)
+    if (colormap[j] != global_colormap[j])
+      break;
+  if (j == (ssize_t) (3*image->colors))
+    (void) WriteBlobByte(image,(unsigned char) c);
+  else
+    {
+      c|=0x80;
+      c|=(int) (bits_per_pixel-1);   /* size of local colormap */
+      (void) WriteBlobByte(image,(unsigned char) c);
+      length=(size_t) (3*(one << bits_per_pixel));
+      (void) WriteBlob(image,length,colormap);
+    }
+  /*
+    Write the image data.
+  */
+  c=(int) MagickMax(bits_per_pixel,2);
+  (void) WriteBlobByte(image,(unsigned char) c);
+  status=MagickTrue;
+  if (WriteBlob(image,frame_info->length,frame_info->data) !=
+      (ssize_t) frame_info->length)
+    status=MagickFalse;
+  (void) WriteBlobByte(image,(unsigned char) 0x00);
+  return(status);
+}
+
+static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image,
+  ExceptionInfo *exception)
+{
+  GIFFrameInfo
+    *frames;
+
+  Image
+    **images;
+
+  ImageInfo
+    *write_info;
+
+  MagickBooleanType
+    encode_status,
+    status;
+
+  RectangleInfo
+    page;
+
+  size_t
+    number_frames,
+    number_scenes,
+    number_threads;
+
+  ssize_t
+    i;
+
+  unsigned char
+    *colormap,
+    *global_colormap;
+
   /*
     Open output image file.
   */
@@ -1583,350 +1981,99 @@ static MagickBooleanType WriteGIFImage(const ImageInfo *image_info,Image *image,
   (void) WriteBlobLSBShort(image,(unsigned short) page.width);
   (void) WriteBlobLSBShort(image,(unsigned short) page.height);
   /*
-    Write images to file.
+    Reduce and encode the frames concurrently, one buffer per thread, and
+    write each frame as soon as the frames before it are written.
   */
-  scene=0;
-  one=1;
   number_scenes=GetImageListLength(image);
-  do
-  {
-    if (IssRGBCompatibleColorspace(image->colorspace) == MagickFalse)
-      (void) TransformImageColorspace(image,sRGBColorspace,exception);
-    opacity=(-1);
-    if (IsImageOpaque(image,exception) != MagickFalse)
-      {
-        if ((image->storage_class == DirectClass) || (image->colors > 256))
-          (void) SetImageType(image,PaletteType,exception);
-      }
-    else
-      {
-        double
-          alpha,
-          beta;
-
-        /*
-          Identify transparent colormap index.
-        */
-        if ((image->storage_class == DirectClass) || (image->colors > 256))
-          (void) SetImageType(image,PaletteBilevelAlphaType,exception);
-        for (i=0; i < (ssize_t) image->colors; i++)
-          if (image->colormap[i].alpha != (double) OpaqueAlpha)
-            {
-              if (opacity < 0)
-                {
-                  opacity=i;
-                  continue;
-                }
-              alpha=fabs(image->colormap[i].alpha-(double) TransparentAlpha);
-              beta=fabs(image->colormap[opacity].alpha-(double)
-                TransparentAlpha);
-              if (alpha < beta)
-                opacity=i;
-            }
-        if (opacity == -1)
-          {
-            (void) SetImageType(image,PaletteBilevelAlphaType,exception);
-            for (i=0; i < (ssize_t) image->colors; i++)
-              if (image->colormap[i].alpha != (double) OpaqueAlpha)
-                {
-                  if (opacity < 0)
-                    {
-                      opacity=i;
-                      continue;
-                    }
-                  alpha=fabs(image->colormap[i].alpha-(double)
-                    TransparentAlpha);
-                  beta=fabs(image->colormap[opacity].alpha-(double)
-                    TransparentAlpha);
-                  if (alpha < beta)
-                    opacity=i;
-                }
-          }
-        if (opacity >= 0)
-          {
-            image->colormap[opacity].red=image->transparent_color.red;
-            image->colormap[opacity].green=image->transparent_color.green;
-            image->colormap[opacity].blue=image->transparent_color.blue;
-          }
-      }
-    if ((image->storage_class == DirectClass) || (image->colors > 256))
-      ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
-    for (bits_per_pixel=1; bits_per_pixel < 8; bits_per_pixel++)
-      if ((one << bits_per_pixel) >= image->colors)
-        break;
-    q=colormap;
-    for (i=0; i < (ssize_t) image->colors; i++)
-    {
-      *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].red));
-      *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].green));
-      *q++=ScaleQuantumToChar(ClampToQuantum(image->colormap[i].blue));
-    }
-    for ( ; i < (ssize_t) (one << bits_per_pixel); i++)
+  number_frames=1;
+  if (write_info->adjoin != MagickFalse)
+    number_frames=number_scenes-(size_t) GetImageIndexInList(image);
+  number_threads=MagickMax(MagickMin(number_frames,(size_t)
+    GetMagickResourceLimit(ThreadResource)),1);
+  images=(Image **) AcquireQuantumMemory(number_frames,sizeof(*images));
+  frames=(GIFFrameInfo *) AcquireQuantumMemory(number_threads,sizeof(*frames));
+  if ((images == (Image **) NULL) || (frames == (GIFFrameInfo *) NULL))
     {
-      *q++=(unsigned char) 0x0;
-      *q++=(unsigned char) 0x0;
-      *q++=(unsigned char) 0x0;
+      if (images != (Image **) NULL)
+        images=(Image **) RelinquishMagickMemory(images);
+      if (frames != (GIFFrameInfo *) NULL)
+        frames=(GIFFrameInfo *) RelinquishMagickMemory(frames);
+      global_colormap=(unsigned char *) RelinquishMagickMemory(global_colormap);
+      colormap=(unsigned char *) RelinquishMagickMemory(colormap);
+      write_info=DestroyImageInfo(write_info);
+      ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
     }
-    if ((GetPreviousImageInList(image) == (Image *) NULL) ||
-        (write_info->adjoin == MagickFalse))
-      {
-        /*
-          Write global colormap.
-        */
-        c=0x80;
-        c|=(8-1) << 4;  /* color resolution */
-        c|=(int) (bits_per_pixel-1);   /* size of global colormap */
-        (void) WriteBlobByte(image,(unsigned char) c);
-        for (j=0; j < (ssize_t) image->colors; j++)
-          if (IsPixelInfoEquivalent(&image->background_color,image->colormap+j))
-            break;
-        (void) WriteBlobByte(image,(unsigned char)
-          (j == (ssize_t) image->colors ? 0 : j));  /* background color */
-        (void) WriteBlobByte(image,(unsigned char) 0x00);  /* reserved */
-        length=(size_t) (3*(one << bits_per_pixel));
-        (void) WriteBlob(image,length,colormap);
-        for (j=0; j < 768; j++)
-          global_colormap[j]=colormap[j];
-      }
-    if (LocaleCompare(write_info->magick,"GIF87") != 0)
-      {
-        const char
-          *value;
+  (void) memset(frames,0,number_threads*sizeof(*frames));
+  images[0]=image;
+  for (i=1; i < (ssize_t) number_frames; i++)
+    images[i]=SyncNextImageInList(images[i-1]);
+  status=MagickTrue;
+  encode_status=MagickTrue;
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+  #pragma omp parallel for ordered schedule(static,1) \
+    shared(encode_status,status) num_threads((int) number_threads)
+#endif
+  for (i=0; i < (ssize_t) number_frames; i++)
+  {
+    const int
+      id = GetOpenMPThreadId();
 
-        if ((GetPreviousImageInList(image) == (Image *) NULL) &&
-            (GetNextImageInList(image) != (Image *) NULL) &&
-            (image->iterations != 1))
-          {
-            /*
-              Write Netscape Loop extension.
-            */
-            (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-               "  Writing GIF Extension %s","NETSCAPE2.0");
-            (void) WriteBlobByte(image,(unsigned char) 0x21);
-            (void) WriteBlobByte(image,(unsigned char) 0xff);
-            (void) WriteBlobByte(image,(unsigned char) 0x0b);
-            (void) WriteBlob(image,11,(unsigned char *) "NETSCAPE2.0");
-            (void) WriteBlobByte(image,(unsigned char) 0x03);
-            (void) WriteBlobByte(image,(unsigned char) 0x01);
-            (void) WriteBlobLSBShort(image,(unsigned short) (image->iterations ?
-              image->iterations-1 : 0));
-            (void) WriteBlobByte(image,(unsigned char) 0x00);
-          }
-        /*
-          Write graphics control extension.
-        */
-        (void) WriteBlobByte(image,(unsigned char) 0x21);
-        (void) WriteBlobByte(image,(unsigned char) 0xf9);
-        (void) WriteBlobByte(image,(unsigned char) 0x04);
-        c=(int) (image->dispose << 2);
-        if (opacity >= 0)
-          c|=0x01;
-        (void) WriteBlobByte(image,(unsigned char) c);
-        delay=(size_t) (100*image->delay/MagickMax((size_t)
-          image->ticks_per_second,1));
-        (void) WriteBlobLSBShort(image,(unsigned short) delay);
-        (void) WriteBlobByte(image,(unsigned char) (opacity >= 0 ? opacity :
-          0));
-        (void) WriteBlobByte(image,(unsigned char) 0x00);
-        if (fabs(image->gamma-1.0/2.2) > MagickEpsilon)
-          {
-            char
-              attributes[MagickPathExtent];
+    MagickBooleanType
+      frame_status;
 
-            ssize_t
-              count;
+    MagickProgressMonitor
+      progress_monitor;
 
-            /*
-              Write ImageMagick extension.
-            */
-            (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-               "  Writing GIF Extension %s","ImageMagick");
-            (void) WriteBlobByte(image,(unsigned char) 0x21);
-            (void) WriteBlobByte(image,(unsigned char) 0xff);
-            (void) WriteBlobByte(image,(unsigned char) 0x0b);
-            (void) WriteBlob(image,11,(unsigned char *) "ImageMagick");
-            count=FormatLocaleString(attributes,MagickPathExtent,"gamma=%g",
-              image->gamma);
-            (void) WriteBlobByte(image,(unsigned char) count);
-            (void) WriteBlob(image,(size_t) count,(unsigned char *) attributes);
-            (void) WriteBlobByte(image,(unsigned char) 0x00);
-          }
-        value=GetImageProperty(image,"comment",exception);
-        if (value != (const char *) NULL)
+    /*
+      Progress is only reported from the ordered write below, which is also
+      the only place status is read or written.
+    */
+    progress_monitor=SetImageProgressMonitor(images[i],
+      (MagickProgressMonitor) NULL,images[i]->client_data);
+    frames[id].length=0;
+    frame_status=EncodeGIFFrame(write_info,images[i],frames+id,exception);
+    (void) SetImageProgressMonitor(images[i],progress_monitor,
+      images[i]->client_data);
+#if defined(MAGICKCORE_OPENMP_SUPPORT)
+    #pragma omp ordered
+#endif
+    if (status != MagickFalse)
+      {
+        if (frame_status == MagickFalse)
           {
-            const char
-              *p;
-
-            size_t
-              count;
-
-            /*
-              Write comment extension.
-            */
-            (void) WriteBlobByte(image,(unsigned char) 0x21);
-            (void) WriteBlobByte(image,(unsigned char) 0xfe);
-            for (p=value; *p != '\0'; )
-            {
-              count=MagickMin(strlen(p),255);
-              (void) WriteBlobByte(image,(unsigned char) count);
-              for (i=0; i < (ssize_t) count; i++)
-                (void) WriteBlobByte(image,(unsigned char) *p++);
-            }
-            (void) WriteBlobByte(image,(unsigned char) 0x00);
+            encode_status=MagickFalse;
+            status=MagickFalse;
           }
-        ResetImageProfileIterator(image);
-        for ( ; ; )
-        {
-          char
-            *name;
-
-          const StringInfo
-            *profile;
-
-          name=GetNextImageProfile(image);
-          if (name == (const char *) NULL)
-            break;
-          profile=GetImageProfile(image,name);
-          if (profile != (StringInfo *) NULL)
+        else
           {
-            if ((LocaleCompare(name,"ICC") == 0) ||
-                (LocaleCompare(name,"ICM") == 0) ||
-                (LocaleCompare(name,"IPTC") == 0) ||
-                (LocaleCompare(name,"8BIM") == 0) ||
-                (LocaleNCompare(name,"gif:",4) == 0))
-            {
-               ssize_t
-                 offset;
-
-               unsigned char
-                 *datum;
-
-               datum=GetStringInfoDatum(profile);
-               length=GetStringInfoLength(profile);
-               (void) WriteBlobByte(image,(unsigned char) 0x21);
-               (void) WriteBlobByte(image,(unsigned char) 0xff);
-               (void) WriteBlobByte(image,(unsigned char) 0x0b);
-               if ((LocaleCompare(name,"ICC") == 0) ||
-                   (LocaleCompare(name,"ICM") == 0))
-                 {
-                   /*
-                     Write ICC extension.
-                   */
-                   (void) WriteBlob(image,11,(unsigned char *) "ICCRGBG1012");
-                   (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-                     "  Writing GIF Extension %s","ICCRGBG1012");
-                 }
-               else
-                 if ((LocaleCompare(name,"IPTC") == 0))
-                   {
-                     /*
-                       Write IPTC extension.
-                     */
-                     (void) WriteBlob(image,11,(unsigned char *) "MGKIPTC0000");
-                     (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-                       "  Writing GIF Extension %s","MGKIPTC0000");
-                   }
-                 else
-                   if ((LocaleCompare(name,"8BIM") == 0))
-                     {
-                       /*
-                         Write 8BIM extension.
-                       */
-                        (void) WriteBlob(image,11,(unsigned char *)
-                          "MGK8BIM0000");
-                        (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-                          "  Writing GIF Extension %s","MGK8BIM0000");
-                     }
-                   else
-                     {
-                       char
-                         extension[MagickPathExtent];
-
-                       /*
-                         Write generic extension.
-                       */
-                       (void) memset(extension,0,sizeof(extension));
-                       (void) CopyMagickString(extension,name+4,
-                         sizeof(extension));
-                       (void) WriteBlob(image,11,(unsigned char *) extension);
-                       (void) LogMagickEvent(CoderEvent,GetMagickModule(),
-                         "  Writing GIF Extension %s",name);
-                     }
-               offset=0;
-               while ((ssize_t) length > offset)
-               {
-                 size_t
-                   block_length;
-
-                 if (((ssize_t) length-offset) < 255)
-                   block_length=(size_t) ((ssize_t) length-offset);
-                 else
-                   block_length=255;
-                 (void) WriteBlobByte(image,(unsigned char) block_length);
-                 (void) WriteBlob(image,(size_t) block_length,datum+offset);
-                 offset+=(ssize_t) block_length;
-               }
-               (void) WriteBlobByte(image,(unsigned char) 0x00);
-            }
+            status=WriteGIFFrame(write_info,images[i],frames+id,
+              global_colormap,colormap,exception);
+            if ((status != MagickFalse) &&
+                (i < ((ssize_t) number_frames-1)))
+              status=SetImageProgress(images[i+1],SaveImagesTag,
+                (MagickOffsetType) i+1,number_scenes);
           }
-        }
       }
-    (void) WriteBlobByte(image,',');  /* image separator */
-    /*
-      Write the image header.
-    */
-    page.x=image->page.x;
-    page.y=image->page.y;
-    if ((image->page.width != 0) && (image->page.height != 0))
-      page=image->page;
-    (void) WriteBlobLSBShort(image,(unsigned short) (page.x < 0 ? 0 : page.x));
-    (void) WriteBlobLSBShort(image,(unsigned short) (page.y < 0 ? 0 : page.y));
-    (void) WriteBlobLSBShort(image,(unsigned short) image->columns);
-    (void) WriteBlobLSBShort(image,(unsigned short) image->rows);
-    c=0x00;
-    if (write_info->interlace != NoInterlace)
-      c|=0x40;  /* pixel data is interlaced */
-    for (j=0; j < (ssize_t) (3*image->colors); j++)
-      if (colormap[j] != global_colormap[j])
-        break;
-    if (j == (ssize_t) (3*image->colors))
-      (void) WriteBlobByte(image,(unsigned char) c);
-    else
-      {
-        c|=0x80;
-        c|=(int) (bits_per_pixel-1);   /* size of local colormap */
-        (void) WriteBlobByte(image,(unsigned char) c);
-        length=(size_t) (3*(one << bits_per_pixel));
-        (void) WriteBlob(image,length,colormap);
-      }
-    /*
-      Write the image data.
-    */
-    c=(int) MagickMax(bits_per_pixel,2);
-    (void) WriteBlobByte(image,(unsigned char) c);
-    status=EncodeImage(write_info,image,(size_t) MagickMax(bits_per_pixel,2)+1,
-      exception);
-    if (status == MagickFalse)
-      {
-        global_colormap=(unsigned char *) RelinquishMagickMemory(
-          global_colormap);
-        colormap=(unsigned char *) RelinquishMagickMemory(colormap);
-        write_info=DestroyImageInfo(write_info);
-        ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
-      }
-    (void) WriteBlobByte(image,(unsigned char) 0x00);
-    if (GetNextImageInList(image) == (Image *) NULL)
-      break;
-    image=SyncNextImageInList(image);
-    scene++;
-    status=SetImageProgress(image,SaveImagesTag,scene,number_scenes);
-    if (status == MagickFalse)
-      break;
-  } while (write_info->adjoin != MagickFalse);
-  (void) WriteBlobByte(image,';'); /* terminator */
+  }
+  images=(Image **) RelinquishMagickMemory(images);
   global_colormap=(unsigned char *) RelinquishMagickMemory(global_colormap);
   colormap=(unsigned char *) RelinquishMagickMemory(colormap);
   write_info=DestroyImageInfo(write_info);
+  for (i=0; i < (ssize_t) number_threads; i++)
+  {
+    if (frames[i].data != (unsigned char *) NULL)
+      frames[i].data=(unsigned char *) RelinquishMagickMemory(frames[i].data);
+    if (frames[i].code_table != (short *) NULL)
+      frames[i].code_table=(short *) RelinquishMagickMemory(
+        frames[i].code_table);
+    if (frames[i].code_key != (size_t *) NULL)
+      frames[i].code_key=(size_t *) RelinquishMagickMemory(
+        frames[i].code_key);
+  }
+  frames=(GIFFrameInfo *) RelinquishMagickMemory(frames);
+  if (encode_status == MagickFalse)
+    ThrowWriterException(ResourceLimitError,"MemoryAllocationFailed");
+  (void) WriteBlobByte(image,';'); /* terminator */
   if (CloseBlob(image) == MagickFalse)
     status=MagickFalse;
   return(status);
@@ -63,6 +63,7 @@
 #include "MagickCore/string_.h"
 #include "MagickCore/module.h"
 #include "MagickCore/utility.h"
+#include "coders/coders-private.h"
 
 /*
   Forward declarations.
@@ -217,6 +218,7 @@ static Image *ReadGRAYImage(const ImageInfo *image_info,
     status=SetImageExtent(image,image->columns,image->rows,exception);
     if (status == MagickFalse)
       break;
+    (void) SetImageColorspace(image,GRAYColorspace,exception);
     switch (image_info->interlace)
     {
       case NoInterlace:
@@ -230,6 +232,17 @@ static Image *ReadGRAYImage(const ImageInfo *image_info,
             length=GetQuantumExtent(canvas_image,quantum_info,quantum_type);
             stream=ReadBlobStream(image,length,pixels,&count);
           }
+        if ((image->extract_info.x == 0) && (image->extract_info.y == 0) &&
+            (canvas_image->columns == image->columns) &&
+            (image->extract_info.height == image->rows))
+          {
+            /*
+              Not cropped: import straight from the blob into the image.
+            */
+            status=ImportCoderQuantumRows(image,quantum_info,quantum_type,
+              pixels,&stream,&length,&count,exception);
+            break;
+          }
         for (y=0; y < (ssize_t) image->extract_info.height; y++)
         {
           const Quantum
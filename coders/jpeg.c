@@ -83,6 +83,7 @@
 #include "MagickCore/string_.h"
 #include "MagickCore/string-private.h"
 #include "MagickCore/token.h"
+#include "MagickCore/transform.h"
 #include "MagickCore/utility.h"
 #include "MagickCore/xml-tree.h"
 #include "MagickCore/xml-tree-private.h"
@@ -162,6 +163,17 @@ typedef struct _SourceManager
 } SourceManager;
 #endif
 
+typedef struct _JPEGTransformInfo
+{
+  MagickBooleanType
+    transpose,
+    flip,
+    flop;
+
+  RectangleInfo
+    crop;
+} JPEGTransformInfo;
+
 typedef struct _QuantizationTable
 {
   char
@@ -1079,6 +1091,38 @@ static void JPEGDestroyImageProfiles(JPEGClientInfo *client_info)
   }
 }
 
+static MagickBooleanType GetJPEGRegion(const ImageInfo *image_info,
+  const Image *image,RectangleInfo *region)
+{
+  MagickStatusType
+    flags;
+
+  RectangleInfo
+    geometry;
+
+  /*
+    Only decode the iMCU rows and columns that intersect the extract geometry.
+  */
+  if ((image_info->extract == (char *) NULL) ||
+      (image_info->stream != (StreamHandler) NULL))
+    return(MagickFalse);
+  if ((image->page.x != 0) || (image->page.y != 0))
+    return(MagickFalse);
+  SetGeometry(image,&geometry);
+  flags=ParseAbsoluteGeometry(image_info->extract,&geometry);
+  if (((flags & XValue) == 0) && ((flags & YValue) == 0))
+    return(MagickFalse);
+  if ((geometry.width == 0) || (geometry.height == 0) || (geometry.x < 0) ||
+      (geometry.y < 0) ||
+      ((geometry.x+(ssize_t) geometry.width) > (ssize_t) image->columns) ||
+      ((geometry.y+(ssize_t) geometry.height) > (ssize_t) image->rows))
+    return(MagickFalse);
+  if ((geometry.width == image->columns) && (geometry.height == image->rows))
+    return(MagickFalse);
+  *region=geometry;
+  return(MagickTrue);
+}
+
 static Image *ReadOneJPEGImage(const ImageInfo *image_info,
   struct jpeg_decompress_struct *jpeg_info,MagickOffsetType *offset,
   ExceptionInfo *exception)
@@ -1112,9 +1156,13 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
   QuantumAny
     range;
 
+  RectangleInfo
+    region;
+
   size_t
     bytes_per_pixel,
-    max_memory_to_use;
+    max_memory_to_use,
+    skip_columns;
 
   ssize_t
     i,
@@ -1417,6 +1465,28 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
       (void) CloseBlob(image);
       return(GetFirstImageInList(image));
     }
+  region.width=image->columns;
+  region.height=image->rows;
+  region.x=0;
+  region.y=0;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && (LIBJPEG_TURBO_VERSION_NUMBER >= 1005000)
+  if ((jpeg_info->quantize_colors == 0) && (jpeg_info->data_precision <= 8) &&
+      (GetJPEGRegion(image_info,image,&region) != MagickFalse))
+    {
+      /*
+        Decode only the extract region; ReadImage() then skips its crop.
+      */
+      if ((image->page.width == 0) || (image->page.height == 0))
+        {
+          image->page.width=image->columns;
+          image->page.height=image->rows;
+        }
+      image->page.x=region.x;
+      image->page.y=region.y;
+      image->columns=region.width;
+      image->rows=region.height;
+    }
+#endif
   status=SetImageExtent(image,image->columns,image->rows,exception);
   if (status == MagickFalse)
     {
@@ -1431,8 +1501,40 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
       client_info=JPEGCleanup(jpeg_info,client_info);
       ThrowReaderException(CorruptImageError,"ImageTypeNotSupported");
     }
+  skip_columns=0;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && (LIBJPEG_TURBO_VERSION_NUMBER >= 1005000)
+  if ((image->columns != (size_t) jpeg_info->output_width) ||
+      (image->rows != (size_t) jpeg_info->output_height))
+    {
+      JDIMENSION
+        x_offset,
+        width;
+
+      /*
+        Widen the crop by a pixel on each side so fancy upsampling sees the
+        same neighbors as a full decode; libjpeg then aligns it to iMCUs.
+      */
+      x_offset=(JDIMENSION) region.x;
+      width=(JDIMENSION) region.width;
+      if (x_offset > 0)
+        {
+          x_offset--;
+          width++;
+        }
+      if ((x_offset+width) < jpeg_info->output_width)
+        width++;
+      jpeg_crop_scanline(jpeg_info,&x_offset,&width);
+      skip_columns=(size_t) region.x-x_offset;
+      if ((region.y != 0) &&
+          (jpeg_skip_scanlines(jpeg_info,(JDIMENSION) region.y) != (JDIMENSION) region.y))
+        {
+          client_info=JPEGCleanup(jpeg_info,client_info);
+          ThrowReaderException(CorruptImageError,"InsufficientImageDataInFile");
+        }
+    }
+#endif
   bytes_per_pixel=((size_t) jpeg_info->data_precision+7)/8;
-  memory_info=AcquireVirtualMemory((size_t) image->columns,
+  memory_info=AcquireVirtualMemory((size_t) jpeg_info->output_width,
     (size_t) jpeg_info->output_components*bytes_per_pixel);
   if (memory_info == (MemoryInfo *) NULL)
     {
@@ -1440,7 +1542,7 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
       ThrowReaderException(ResourceLimitError,"MemoryAllocationFailed");
     }
   jpeg_pixels=(JSAMPLE *) GetVirtualMemoryBlob(memory_info);
-  (void) memset(jpeg_pixels,0,(size_t) (image->columns*
+  (void) memset(jpeg_pixels,0,(size_t) (jpeg_info->output_width*
     (size_t) jpeg_info->output_components*sizeof(*jpeg_pixels)));
   /*
     Convert JPEG pixels to pixel packets.
@@ -1523,7 +1625,8 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
     q=QueueAuthenticPixels(image,0,y,image->columns,1,exception);
     if (q == (Quantum *) NULL)
       break;
-    p=jpeg_pixels;
+    p=jpeg_pixels+skip_columns*(size_t) jpeg_info->output_components*
+      bytes_per_pixel;
     switch (jpeg_info->output_components)
     {
       case 1:
@@ -1604,8 +1707,11 @@ static Image *ReadOneJPEGImage(const ImageInfo *image_info,
   if (status != MagickFalse)
     {
       client_info->finished=MagickTrue;
-      if (setjmp(client_info->error_recovery) == 0)
-        (void) jpeg_finish_decompress(jpeg_info);
+      if (image->rows != (size_t) jpeg_info->output_height)
+        jpeg_abort_decompress(jpeg_info);
+      else
+        if (setjmp(client_info->error_recovery) == 0)
+          (void) jpeg_finish_decompress(jpeg_info);
     }
   /*
     Free jpeg resources.
@@ -2387,6 +2493,843 @@ static inline void JPEGSetSample(const struct jpeg_compress_struct *jpeg_info,
     (*(unsigned short *) q)=(unsigned short) ScaleQuantumToAny(pixel,range);
 }
 
+static inline void TransposeJPEGTransform(JPEGTransformInfo *transform_info)
+{
+  MagickBooleanType
+    flip;
+
+  /*
+    A transpose that follows a flip or flop swaps the mirrored axes.
+  */
+  flip=transform_info->flip;
+  transform_info->flip=transform_info->flop;
+  transform_info->flop=flip;
+  transform_info->transpose=transform_info->transpose == MagickFalse ?
+    MagickTrue : MagickFalse;
+}
+
+static inline void RotateJPEGTransform(JPEGTransformInfo *transform_info,
+  const ssize_t degrees)
+{
+  switch (((degrees % 360)+360) % 360)
+  {
+    case 90:
+    {
+      TransposeJPEGTransform(transform_info);
+      transform_info->flop=transform_info->flop == MagickFalse ? MagickTrue :
+        MagickFalse;
+      break;
+    }
+    case 180:
+    {
+      transform_info->flip=transform_info->flip == MagickFalse ? MagickTrue :
+        MagickFalse;
+      transform_info->flop=transform_info->flop == MagickFalse ? MagickTrue :
+        MagickFalse;
+      break;
+    }
+    case 270:
+    {
+      TransposeJPEGTransform(transform_info);
+      transform_info->flip=transform_info->flip == MagickFalse ? MagickTrue :
+        MagickFalse;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+static MagickBooleanType GetJPEGTransform(const char *transform,
+  const OrientationType orientation,JPEGTransformInfo *transform_info)
+{
+  char
+    operation[MagickPathExtent];
+
+  const char
+    *p;
+
+  MagickBooleanType
+    status;
+
+  /*
+    Compose a comma separated list of lossless operations, e.g.
+    auto-orient,rotate:90,crop:640x480+0+0, into one transform.  Crop must be
+    the last operation.
+  */
+  (void) memset(transform_info,0,sizeof(*transform_info));
+  status=MagickTrue;
+  for (p=transform; (*p != '\0') && (status != MagickFalse); )
+  {
+    char
+      *argument;
+
+    size_t
+      length;
+
+    length=strcspn(p,",");
+    (void) CopyMagickString(operation,p,MagickMin(length+1,MagickPathExtent));
+    p+=(ptrdiff_t) length;
+    if (*p == ',')
+      p++;
+    StripString(operation);
+    argument=strchr(operation,':');
+    if (argument != (char *) NULL)
+      *argument++='\0';
+    if (transform_info->crop.width != 0)
+      status=MagickFalse;
+    else if (LocaleCompare(operation,"auto-orient") == 0)
+      switch (orientation)
+      {
+        case TopRightOrientation:
+        {
+          transform_info->flop=transform_info->flop == MagickFalse ?
+            MagickTrue : MagickFalse;
+          break;
+        }
+        case BottomRightOrientation: RotateJPEGTransform(transform_info,180);
+          break;
+        case BottomLeftOrientation:
+        {
+          transform_info->flip=transform_info->flip == MagickFalse ?
+            MagickTrue : MagickFalse;
+          break;
+        }
+        case LeftTopOrientation: TransposeJPEGTransform(transform_info); break;
+        case RightTopOrientation: RotateJPEGTransform(transform_info,90); break;
+        case RightBottomOrientation:
+        {
+          RotateJPEGTransform(transform_info,90);
+          transform_info->flip=transform_info->flip == MagickFalse ?
+            MagickTrue : MagickFalse;
+          break;
+        }
+        case LeftBottomOrientation: RotateJPEGTransform(transform_info,270);
+          break;
+        default: break;
+      }
+    else if (LocaleCompare(operation,"crop") == 0)
+      {
+        MagickStatusType
+          flags;
+
+        flags=NoValue;
+        if (argument != (char *) NULL)
+          flags=ParseAbsoluteGeometry(argument,&transform_info->crop);
+        if (((flags & WidthValue) == 0) || ((flags & HeightValue) == 0) ||
+            (transform_info->crop.width == 0) ||
+            (transform_info->crop.height == 0) ||
+            (transform_info->crop.x < 0) || (transform_info->crop.y < 0))
+          status=MagickFalse;
+      }
+    else if (LocaleCompare(operation,"flip") == 0)
+      transform_info->flip=transform_info->flip == MagickFalse ? MagickTrue :
+        MagickFalse;
+    else if (LocaleCompare(operation,"flop") == 0)
+      transform_info->flop=transform_info->flop == MagickFalse ? MagickTrue :
+        MagickFalse;
+    else if ((LocaleCompare(operation,"rotate") == 0) &&
+             (argument != (char *) NULL) && ((StringToLong(argument) % 90) == 0))
+      RotateJPEGTransform(transform_info,StringToLong(argument));
+    else if (LocaleCompare(operation,"transpose") == 0)
+      TransposeJPEGTransform(transform_info);
+    else if (LocaleCompare(operation,"transverse") == 0)
+      {
+        RotateJPEGTransform(transform_info,90);
+        transform_info->flip=transform_info->flip == MagickFalse ? MagickTrue :
+          MagickFalse;
+      }
+    else
+      status=MagickFalse;
+  }
+  return(status);
+}
+
+static MagickBooleanType GetJPEGTransformCrop(
+  const JPEGTransformInfo *transform_info,const size_t columns,
+  const size_t rows,const ssize_t mcu_width,const ssize_t mcu_height,
+  RectangleInfo *crop,RectangleInfo *trim)
+{
+  /*
+    Edge iMCUs that would move are trimmed, as with jpegtran -trim, so the
+    transformed image loses trim->x leading columns and trim->y leading rows.
+    The crop is relative to the trimmed image and aligned to its iMCU grid.
+  */
+  trim->width=columns;
+  trim->height=rows;
+  trim->x=0;
+  trim->y=0;
+  if (transform_info->flop != MagickFalse)
+    {
+      trim->x=(ssize_t) (columns % (size_t) mcu_width);
+      trim->width-=(size_t) trim->x;
+    }
+  if (transform_info->flip != MagickFalse)
+    {
+      trim->y=(ssize_t) (rows % (size_t) mcu_height);
+      trim->height-=(size_t) trim->y;
+    }
+  crop->width=trim->width;
+  crop->height=trim->height;
+  crop->x=0;
+  crop->y=0;
+  if (transform_info->crop.width != 0)
+    {
+      RectangleInfo
+        geometry;
+
+      geometry=transform_info->crop;
+      geometry.x-=trim->x;
+      geometry.y-=trim->y;
+      if (geometry.x < 0)
+        {
+          geometry.width=(size_t) MagickMax((ssize_t) geometry.width+
+            geometry.x,0);
+          geometry.x=0;
+        }
+      if (geometry.y < 0)
+        {
+          geometry.height=(size_t) MagickMax((ssize_t) geometry.height+
+            geometry.y,0);
+          geometry.y=0;
+        }
+      geometry.width+=(size_t) (geometry.x % mcu_width);
+      geometry.x-=geometry.x % mcu_width;
+      geometry.height+=(size_t) (geometry.y % mcu_height);
+      geometry.y-=geometry.y % mcu_height;
+      if ((geometry.x+(ssize_t) geometry.width) > (ssize_t) trim->width)
+        geometry.width=(size_t) MagickMax((ssize_t) trim->width-geometry.x,0);
+      if ((geometry.y+(ssize_t) geometry.height) > (ssize_t) trim->height)
+        geometry.height=(size_t) MagickMax((ssize_t) trim->height-geometry.y,
+          0);
+      *crop=geometry;
+    }
+  if ((crop->width == 0) || (crop->height == 0))
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
+static void ResetJPEGOrientation(StringInfo *profile)
+{
+  MagickBooleanType
+    msb;
+
+  size_t
+    entries,
+    length,
+    offset;
+
+  ssize_t
+    i;
+
+  unsigned char
+    *datum;
+
+  /*
+    Set the EXIF orientation tag of IFD0 to top-left.
+  */
+  datum=GetStringInfoDatum(profile);
+  length=GetStringInfoLength(profile);
+  if ((length >= 6) && (memcmp(datum,"Exif\0\0",6) == 0))
+    {
+      datum+=(ptrdiff_t) 6;
+      length-=6;
+    }
+  if (length < 8)
+    return;
+  if ((datum[0] == 'M') && (datum[1] == 'M'))
+    msb=MagickTrue;
+  else if ((datum[0] == 'I') && (datum[1] == 'I'))
+    msb=MagickFalse;
+  else
+    return;
+  if (msb != MagickFalse)
+    offset=((size_t) datum[4] << 24) | ((size_t) datum[5] << 16) |
+      ((size_t) datum[6] << 8) | (size_t) datum[7];
+  else
+    offset=((size_t) datum[7] << 24) | ((size_t) datum[6] << 16) |
+      ((size_t) datum[5] << 8) | (size_t) datum[4];
+  if ((offset+2) > length)
+    return;
+  entries=msb != MagickFalse ? ((size_t) datum[offset] << 8) |
+    datum[offset+1] : ((size_t) datum[offset+1] << 8) | datum[offset];
+  for (i=0; i < (ssize_t) entries; i++)
+  {
+    unsigned char
+      *entry;
+
+    entry=datum+offset+2+12*i;
+    if ((size_t) (entry-datum+12) > length)
+      break;
+    if ((msb != MagickFalse) && (entry[0] == 0x01) && (entry[1] == 0x12))
+      {
+        entry[8]=0;
+        entry[9]=1;
+        break;
+      }
+    if ((msb == MagickFalse) && (entry[1] == 0x01) && (entry[0] == 0x12))
+      {
+        entry[8]=1;
+        entry[9]=0;
+        break;
+      }
+  }
+}
+
+static MagickBooleanType WriteJPEGTransform(const ImageInfo *image_info,
+  Image *image,const char *transform,MagickBooleanType *status,
+  ExceptionInfo *exception)
+{
+  ExceptionInfo
+    *sans_exception;
+
+  Image
+    *ping_image,
+    *volatile source = (Image *) NULL;
+
+  ImageInfo
+    *read_info;
+
+  JPEGClientInfo
+    *client_info = (JPEGClientInfo *) NULL;
+
+  JPEGTransformInfo
+    transform_info;
+
+  jvirt_barray_ptr
+    *destination_arrays,
+    *source_arrays;
+
+  const char
+    *option;
+
+  int
+    c,
+    max_h_samp_factor,
+    max_v_samp_factor;
+
+  RectangleInfo
+    crop,
+    trim;
+
+  ssize_t
+    i;
+
+  struct jpeg_compress_struct
+    jpeg_info;
+
+  struct jpeg_decompress_struct
+    source_info;
+
+  struct jpeg_error_mgr
+    jpeg_error,
+    source_error;
+
+  unsigned char
+    magick[3];
+
+  volatile MagickBooleanType
+    started = MagickFalse;
+
+  /*
+    Transform the DCT coefficients of the source JPEG without re-encoding.
+    This is only possible when the pixels are still those of the source.
+  */
+  if (GetJPEGTransform(transform,image->orientation,&transform_info) == MagickFalse)
+    return(MagickFalse);
+  if (IsTaintImage(image) != MagickFalse)
+    return(MagickFalse);
+  read_info=CloneImageInfo(image_info);
+  (void) CopyMagickString(read_info->filename,image->magick_filename,
+    MagickPathExtent);
+  sans_exception=AcquireExceptionInfo();
+  ping_image=PingImage(read_info,sans_exception);
+  sans_exception=DestroyExceptionInfo(sans_exception);
+  if ((ping_image == (Image *) NULL) ||
+      (LocaleCompare(ping_image->magick,"JPEG") != 0) ||
+      (ping_image->columns != image->columns) ||
+      (ping_image->rows != image->rows) ||
+      (ping_image->orientation != image->orientation))
+    {
+      if (ping_image != (Image *) NULL)
+        ping_image=DestroyImageList(ping_image);
+      read_info=DestroyImageInfo(read_info);
+      return(MagickFalse);
+    }
+  ping_image=DestroyImageList(ping_image);
+  source=AcquireImage(read_info,exception);
+  *status=OpenBlob(read_info,source,ReadBinaryBlobMode,exception);
+  read_info=DestroyImageInfo(read_info);
+  if ((*status == MagickFalse) || (ReadBlob(source,3,magick) != 3) ||
+      (IsJPEG(magick,3) == MagickFalse) || (SeekBlob(source,0,SEEK_SET) != 0))
+    {
+      source=DestroyImage(source);
+      return(MagickFalse);
+    }
+  client_info=(JPEGClientInfo *) AcquireMagickMemory(sizeof(*client_info));
+  if (client_info == (JPEGClientInfo *) NULL)
+    {
+      source=DestroyImage(source);
+      return(MagickFalse);
+    }
+  (void) memset(client_info,0,sizeof(*client_info));
+  (void) memset(&jpeg_info,0,sizeof(jpeg_info));
+  (void) memset(&source_info,0,sizeof(source_info));
+  (void) memset(&jpeg_error,0,sizeof(jpeg_error));
+  (void) memset(&source_error,0,sizeof(source_error));
+  source_info.err=jpeg_std_error(&source_error);
+  source_info.err->emit_message=(void (*)(j_common_ptr,int)) JPEGWarningHandler;
+  source_info.err->error_exit=(void (*)(j_common_ptr)) JPEGErrorHandler;
+  jpeg_info.err=jpeg_std_error(&jpeg_error);
+  jpeg_info.err->emit_message=(void (*)(j_common_ptr,int)) JPEGWarningHandler;
+  jpeg_info.err->error_exit=(void (*)(j_common_ptr)) JPEGErrorHandler;
+  client_info->exception=exception;
+  client_info->image=source;
+  if (setjmp(client_info->error_recovery) != 0)
+    {
+      jpeg_destroy_compress(&jpeg_info);
+      jpeg_destroy_decompress(&source_info);
+      client_info=(JPEGClientInfo *) RelinquishMagickMemory(client_info);
+      source=DestroyImage(source);
+      *status=MagickFalse;
+      return(started);
+    }
+  source_info.client_data=(void *) client_info;
+  jpeg_create_decompress(&source_info);
+  JPEGSourceManager(&source_info,source);
+  (void) jpeg_read_header(&source_info,TRUE);
+  max_h_samp_factor=source_info.max_h_samp_factor;
+  max_v_samp_factor=source_info.max_v_samp_factor;
+  if (transform_info.transpose != MagickFalse)
+    {
+      max_h_samp_factor=source_info.max_v_samp_factor;
+      max_v_samp_factor=source_info.max_h_samp_factor;
+    }
+  if (GetJPEGTransformCrop(&transform_info,(size_t) (transform_info.transpose !=
+      MagickFalse ? source_info.image_height : source_info.image_width),
+      (size_t) (transform_info.transpose != MagickFalse ?
+      source_info.image_width : source_info.image_height),(ssize_t)
+      max_h_samp_factor*DCTSIZE,(ssize_t) max_v_samp_factor*DCTSIZE,&crop,
+      &trim) == MagickFalse)
+    {
+      jpeg_destroy_decompress(&source_info);
+      client_info=(JPEGClientInfo *) RelinquishMagickMemory(client_info);
+      source=DestroyImage(source);
+      return(MagickFalse);
+    }
+  destination_arrays=(jvirt_barray_ptr *) (*source_info.mem->alloc_small)(
+    (j_common_ptr) &source_info,JPOOL_IMAGE,(size_t)
+    source_info.num_components*sizeof(*destination_arrays));
+  for (c=0; c < source_info.num_components; c++)
+  {
+    int
+      h_samp_factor,
+      v_samp_factor;
+
+    size_t
+      height_in_blocks,
+      width_in_blocks;
+
+    h_samp_factor=source_info.comp_info[c].h_samp_factor;
+    v_samp_factor=source_info.comp_info[c].v_samp_factor;
+    if (transform_info.transpose != MagickFalse)
+      {
+        h_samp_factor=source_info.comp_info[c].v_samp_factor;
+        v_samp_factor=source_info.comp_info[c].h_samp_factor;
+      }
+    width_in_blocks=(crop.width*(size_t) h_samp_factor+(size_t)
+      (max_h_samp_factor*DCTSIZE)-1)/(size_t) (max_h_samp_factor*DCTSIZE);
+    height_in_blocks=(crop.height*(size_t) v_samp_factor+(size_t)
+      (max_v_samp_factor*DCTSIZE)-1)/(size_t) (max_v_samp_factor*DCTSIZE);
+    destination_arrays[c]=(*source_info.mem->request_virt_barray)(
+      (j_common_ptr) &source_info,JPOOL_IMAGE,FALSE,(JDIMENSION)
+      (h_samp_factor*((width_in_blocks+(size_t) h_samp_factor-1)/(size_t)
+      h_samp_factor)),(JDIMENSION) (v_samp_factor*((height_in_blocks+
+      (size_t) v_samp_factor-1)/(size_t) v_samp_factor)),(JDIMENSION)
+      v_samp_factor);
+  }
+  source_arrays=jpeg_read_coefficients(&source_info);
+  for (c=0; c < source_info.num_components; c++)
+  {
+    jpeg_component_info
+      *component;
+
+    ssize_t
+      columns,
+      full_columns,
+      full_rows,
+      h_samp_factor,
+      rows,
+      source_columns,
+      source_rows,
+      v_samp_factor,
+      x,
+      y;
+
+    component=source_info.comp_info+c;
+    h_samp_factor=(ssize_t) component->h_samp_factor;
+    v_samp_factor=(ssize_t) component->v_samp_factor;
+    source_columns=h_samp_factor*(((ssize_t) component->width_in_blocks+
+      h_samp_factor-1)/h_samp_factor);
+    source_rows=v_samp_factor*(((ssize_t) component->height_in_blocks+
+      v_samp_factor-1)/v_samp_factor);
+    if (transform_info.transpose != MagickFalse)
+      {
+        h_samp_factor=(ssize_t) component->v_samp_factor;
+        v_samp_factor=(ssize_t) component->h_samp_factor;
+      }
+    columns=(((ssize_t) crop.width*h_samp_factor+max_h_samp_factor*DCTSIZE-1)/
+      (max_h_samp_factor*DCTSIZE)+h_samp_factor-1)/h_samp_factor*h_samp_factor;
+    rows=(((ssize_t) crop.height*v_samp_factor+max_v_samp_factor*DCTSIZE-1)/
+      (max_v_samp_factor*DCTSIZE)+v_samp_factor-1)/v_samp_factor*v_samp_factor;
+    full_columns=(transform_info.transpose != MagickFalse ? source_rows :
+      source_columns);
+    full_rows=(transform_info.transpose != MagickFalse ? source_columns :
+      source_rows);
+    if (transform_info.flop != MagickFalse)
+      full_columns=(ssize_t) (transform_info.transpose != MagickFalse ?
+        source_info.image_height : source_info.image_width)/
+        (max_h_samp_factor*DCTSIZE)*h_samp_factor;
+    if (transform_info.flip != MagickFalse)
+      full_rows=(ssize_t) (transform_info.transpose != MagickFalse ?
+        source_info.image_width : source_info.image_height)/
+        (max_v_samp_factor*DCTSIZE)*v_samp_factor;
+    for (y=0; y < rows; y+=v_samp_factor)
+    {
+      JBLOCKARRAY
+        blocks;
+
+      ssize_t
+        j;
+
+      blocks=(*source_info.mem->access_virt_barray)((j_common_ptr)
+        &source_info,destination_arrays[c],(JDIMENSION) y,(JDIMENSION)
+        v_samp_factor,TRUE);
+      for (j=0; j < v_samp_factor; j++)
+        for (x=0; x < columns; x++)
+        {
+          JBLOCKARRAY
+            source_blocks;
+
+          JCOEFPTR
+            p,
+            q;
+
+          ssize_t
+            k,
+            u,
+            v,
+            x_offset,
+            y_offset;
+
+          q=blocks[j][x];
+          x_offset=x+crop.x*h_samp_factor/(max_h_samp_factor*DCTSIZE);
+          y_offset=y+j+crop.y*v_samp_factor/(max_v_samp_factor*DCTSIZE);
+          if (transform_info.flop != MagickFalse)
+            x_offset=full_columns-1-x_offset;
+          if (transform_info.flip != MagickFalse)
+            y_offset=full_rows-1-y_offset;
+          if (transform_info.transpose != MagickFalse)
+            {
+              k=x_offset;
+              x_offset=y_offset;
+              y_offset=k;
+            }
+          if ((x_offset < 0) || (x_offset >= source_columns) ||
+              (y_offset < 0) || (y_offset >= source_rows))
+            {
+              (void) memset(q,0,sizeof(JBLOCK));
+              continue;
+            }
+          source_blocks=(*source_info.mem->access_virt_barray)((j_common_ptr)
+            &source_info,source_arrays[c],(JDIMENSION) y_offset,1,FALSE);
+          p=source_blocks[0][x_offset];
+          for (v=0; v < DCTSIZE; v++)
+            for (u=0; u < DCTSIZE; u++)
+            {
+              k=v*DCTSIZE+u;
+              q[k]=transform_info.transpose != MagickFalse ?
+                p[u*DCTSIZE+v] : p[k];
+              if (((transform_info.flop != MagickFalse) && ((u & 0x01) != 0)) ^
+                  ((transform_info.flip != MagickFalse) && ((v & 0x01) != 0)))
+                q[k]=(JCOEF) -q[k];
+            }
+        }
+    }
+  }
+  /*
+    Write the transformed coefficients.
+  */
+  started=MagickTrue;
+  jpeg_info.client_data=(void *) client_info;
+  client_info->image=image;
+  jpeg_create_compress(&jpeg_info);
+  JPEGDestinationManager(&jpeg_info,image);
+  jpeg_copy_critical_parameters(&source_info,&jpeg_info);
+  jpeg_info.image_width=(JDIMENSION) crop.width;
+  jpeg_info.image_height=(JDIMENSION) crop.height;
+  if (transform_info.transpose != MagickFalse)
+    {
+      UINT16
+        density;
+
+      for (c=0; c < jpeg_info.num_components; c++)
+      {
+        int
+          samp_factor;
+
+        samp_factor=jpeg_info.comp_info[c].h_samp_factor;
+        jpeg_info.comp_info[c].h_samp_factor=
+          jpeg_info.comp_info[c].v_samp_factor;
+        jpeg_info.comp_info[c].v_samp_factor=samp_factor;
+      }
+      for (i=0; i < NUM_QUANT_TBLS; i++)
+      {
+        JQUANT_TBL
+          *table;
+
+        ssize_t
+          u,
+          v;
+
+        table=jpeg_info.quant_tbl_ptrs[i];
+        if (table == (JQUANT_TBL *) NULL)
+          continue;
+        for (v=0; v < DCTSIZE; v++)
+          for (u=v+1; u < DCTSIZE; u++)
+          {
+            UINT16
+              quantum;
+
+            quantum=table->quantval[v*DCTSIZE+u];
+            table->quantval[v*DCTSIZE+u]=table->quantval[u*DCTSIZE+v];
+            table->quantval[u*DCTSIZE+v]=quantum;
+          }
+      }
+      density=jpeg_info.X_density;
+      jpeg_info.X_density=jpeg_info.Y_density;
+      jpeg_info.Y_density=density;
+    }
+  option=GetImageOption(image_info,"jpeg:optimize-coding");
+  jpeg_info.optimize_coding=IsStringFalse(option) != MagickFalse ? FALSE :
+    TRUE;
+#if (JPEG_LIB_VERSION >= 61) && defined(C_PROGRESSIVE_SUPPORTED)
+  if ((LocaleCompare(image_info->magick,"PJPEG") == 0) ||
+      (image_info->interlace != NoInterlace))
+    jpeg_simple_progression(&jpeg_info);
+#endif
+  jpeg_write_coefficients(&jpeg_info,destination_arrays);
+  option=GetImageProperty(image,"comment",exception);
+  if (option != (char *) NULL)
+    {
+      size_t
+        length;
+
+      length=strlen(option);
+      for (i=0; i < (ssize_t) length; i+=65533L)
+        jpeg_write_marker(&jpeg_info,JPEG_COM,(unsigned char *) option+i,
+          (unsigned int) MagickMin((size_t) strlen(option+i),65533L));
+    }
+  if (image->profiles != (void *) NULL)
+    {
+      const StringInfo
+        *profile;
+
+      profile=GetImageProfile(image,"exif");
+      if ((profile != (const StringInfo *) NULL) &&
+          (image->orientation != UndefinedOrientation) &&
+          (image->orientation != TopLeftOrientation) &&
+          (strstr(transform,"auto-orient") != (char *) NULL))
+        {
+          Image
+            *profile_image;
+
+          /*
+            The coefficients are now upright; so is the EXIF orientation.
+          */
+          profile_image=CloneImage(image,1,1,MagickTrue,exception);
+          if (profile_image != (Image *) NULL)
+            {
+              StringInfo
+                *exif_profile;
+
+              exif_profile=CloneStringInfo(profile);
+              ResetJPEGOrientation(exif_profile);
+              (void) SetImageProfile(profile_image,"exif",exif_profile,
+                exception);
+              exif_profile=DestroyStringInfo(exif_profile);
+              WriteProfiles(&jpeg_info,profile_image,exception);
+              profile_image=DestroyImage(profile_image);
+            }
+        }
+      else
+        WriteProfiles(&jpeg_info,image,exception);
+    }
+  jpeg_finish_compress(&jpeg_info);
+  jpeg_destroy_compress(&jpeg_info);
+  client_info->image=source;
+  (void) jpeg_finish_decompress(&source_info);
+  jpeg_destroy_decompress(&source_info);
+  client_info=(JPEGClientInfo *) RelinquishMagickMemory(client_info);
+  source=DestroyImage(source);
+  *status=MagickTrue;
+  return(MagickTrue);
+}
+
+static void GetJPEGSamplingFactors(const ImageInfo *image_info,
+  const Image *image,ssize_t *max_h_samp_factor,ssize_t *max_v_samp_factor,
+  ExceptionInfo *exception)
+{
+  char
+    **factors;
+
+  const char
+    *sampling_factor;
+
+  ssize_t
+    i;
+
+  /*
+    The largest sampling factors the encoder would use, 1x1 when unknown.
+  */
+  *max_h_samp_factor=1;
+  *max_v_samp_factor=1;
+  sampling_factor=image_info->sampling_factor;
+  if (sampling_factor == (const char *) NULL)
+    sampling_factor=GetImageOption(image_info,"jpeg:sampling-factor");
+  if (sampling_factor == (const char *) NULL)
+    sampling_factor=GetImageProperty(image,"jpeg:sampling-factor",exception);
+  factors=SamplingFactorToList(sampling_factor);
+  if (factors == (char **) NULL)
+    return;
+  for (i=0; i < MAX_COMPONENTS; i++)
+  {
+    GeometryInfo
+      geometry_info;
+
+    MagickStatusType
+      flags;
+
+    if (factors[i] == (char *) NULL)
+      break;
+    flags=ParseGeometry(factors[i],&geometry_info);
+    if ((flags & SigmaValue) == 0)
+      geometry_info.sigma=geometry_info.rho;
+    if ((geometry_info.rho >= 1.0) && (geometry_info.rho <= 4.0))
+      *max_h_samp_factor=MagickMax(*max_h_samp_factor,(ssize_t)
+        geometry_info.rho);
+    if ((geometry_info.sigma >= 1.0) && (geometry_info.sigma <= 4.0))
+      *max_v_samp_factor=MagickMax(*max_v_samp_factor,(ssize_t)
+        geometry_info.sigma);
+    factors[i]=(char *) RelinquishMagickMemory(factors[i]);
+  }
+  factors=(char **) RelinquishMagickMemory(factors);
+}
+
+static Image *TransformJPEGPixels(const ImageInfo *image_info,
+  const Image *image,const char *transform,ExceptionInfo *exception)
+{
+  Image
+    *next_image,
+    *transform_image;
+
+  JPEGTransformInfo
+    transform_info;
+
+  RectangleInfo
+    crop,
+    trim;
+
+  ssize_t
+    max_h_samp_factor,
+    max_v_samp_factor;
+
+  /*
+    Apply the transform to the pixels when the source coefficients cannot be
+    used: transpose first, then mirror, then crop.  The output geometry is
+    that of the lossless transform, edge iMCUs included.
+  */
+  if (GetJPEGTransform(transform,image->orientation,&transform_info) == MagickFalse)
+    return((Image *) NULL);
+  GetJPEGSamplingFactors(image_info,image,&max_h_samp_factor,
+    &max_v_samp_factor,exception);
+  if (transform_info.transpose != MagickFalse)
+    {
+      ssize_t
+        samp_factor;
+
+      samp_factor=max_h_samp_factor;
+      max_h_samp_factor=max_v_samp_factor;
+      max_v_samp_factor=samp_factor;
+    }
+  if (GetJPEGTransformCrop(&transform_info,transform_info.transpose !=
+      MagickFalse ? image->rows : image->columns,transform_info.transpose !=
+      MagickFalse ? image->columns : image->rows,max_h_samp_factor*DCTSIZE,
+      max_v_samp_factor*DCTSIZE,&crop,&trim) == MagickFalse)
+    return((Image *) NULL);
+  crop.x+=trim.x;
+  crop.y+=trim.y;
+  transform_image=CloneImage(image,0,0,MagickTrue,exception);
+  if (transform_image == (Image *) NULL)
+    return((Image *) NULL);
+  next_image=transform_image;
+  if (transform_info.transpose != MagickFalse)
+    next_image=TransposeImage(transform_image,exception);
+  if ((next_image != (Image *) NULL) && (next_image != transform_image))
+    {
+      transform_image=DestroyImage(transform_image);
+      transform_image=next_image;
+    }
+  if ((next_image != (Image *) NULL) && (transform_info.flip != MagickFalse))
+    {
+      next_image=FlipImage(transform_image,exception);
+      if (next_image != (Image *) NULL)
+        {
+          transform_image=DestroyImage(transform_image);
+          transform_image=next_image;
+        }
+    }
+  if ((next_image != (Image *) NULL) && (transform_info.flop != MagickFalse))
+    {
+      next_image=FlopImage(transform_image,exception);
+      if (next_image != (Image *) NULL)
+        {
+          transform_image=DestroyImage(transform_image);
+          transform_image=next_image;
+        }
+    }
+  if ((next_image != (Image *) NULL) &&
+      ((crop.width != transform_image->columns) ||
+       (crop.height != transform_image->rows)))
+    {
+      /*
+        Crop relative to the transformed pixels, not the virtual canvas.
+      */
+      transform_image->page.x=0;
+      transform_image->page.y=0;
+      transform_image->page.width=0;
+      transform_image->page.height=0;
+      next_image=CropImage(transform_image,&crop,exception);
+      if (next_image != (Image *) NULL)
+        {
+          transform_image=DestroyImage(transform_image);
+          transform_image=next_image;
+          transform_image->page.x=0;
+          transform_image->page.y=0;
+          transform_image->page.width=0;
+          transform_image->page.height=0;
+        }
+    }
+  if (next_image == (Image *) NULL)
+    {
+      transform_image=DestroyImage(transform_image);
+      return((Image *) NULL);
+    }
+  if (strstr(transform,"auto-orient") != (char *) NULL)
+    transform_image->orientation=TopLeftOrientation;
+  return(transform_image);
+}
+
 static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
   Image *myImage,struct jpeg_compress_struct *jpeg_info,
   ExceptionInfo *exception)
@@ -2407,6 +3350,7 @@ static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
   Image
     *volatile image = (Image *) NULL,
     *volatile jps_image = (Image *) NULL,
+    *volatile transform_image = (Image *) NULL,
     *volatile volatile_image = (Image *) NULL;
 
   int
@@ -2463,6 +3407,30 @@ static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
         jps_image=DestroyImage(jps_image);
       return(status);
     }
+  option=GetImageOption(image_info,"jpeg:transform");
+  if ((option != (const char *) NULL) && (jps_image == (Image *) NULL) &&
+      (WriteJPEGTransform(image_info,image,option,&status,exception) != MagickFalse))
+    {
+      /*
+        Lossless DCT-domain transform of the source JPEG.
+      */
+      if (CloseBlob(image) == MagickFalse)
+        status=MagickFalse;
+      return(status);
+    }
+  if ((option != (const char *) NULL) && (jps_image == (Image *) NULL))
+    {
+      /*
+        The pixels no longer match the source JPEG, transform them instead.
+      */
+      transform_image=TransformJPEGPixels(image_info,image,option,exception);
+      if (transform_image != (Image *) NULL)
+        {
+          DestroyBlob(transform_image);
+          transform_image->blob=ReferenceBlob(image->blob);
+          image=transform_image;
+        }
+    }
   /*
     Initialize JPEG parameters.
   */
@@ -2487,6 +3455,8 @@ static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
       (void) CloseBlob(image);
       if (jps_image != (Image *) NULL)
         jps_image=DestroyImage(jps_image);
+      if (transform_image != (Image *) NULL)
+        transform_image=DestroyImage(transform_image);
       return(MagickFalse);
     }
   jpeg_info->client_data=(void *) client_info;
@@ -3033,6 +4003,8 @@ static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
       (void) CloseBlob(image);
       if (jps_image != (Image *) NULL)
         jps_image=DestroyImage(jps_image);
+      if (transform_image != (Image *) NULL)
+        transform_image=DestroyImage(transform_image);
       return(MagickFalse);
     }
   range=GetQuantumRange(jpeg_info->data_precision);
@@ -3154,6 +4126,8 @@ static MagickBooleanType WriteJPEGImage_(const ImageInfo *image_info,
     status=MagickFalse;
   if (jps_image != (Image *) NULL)
     jps_image=DestroyImage(jps_image);
+  if (transform_image != (Image *) NULL)
+    transform_image=DestroyImage(transform_image);
   return(status);
 }
 
@@ -214,11 +214,15 @@ static Image *ReadPCXImage(const ImageInfo *image_info,ExceptionInfo *exception)
   ThrowReaderException(severity,tag); \
 }
 
+  BlobReader
+    reader;
+
   Image
     *image;
 
   int
     bits,
+    c,
     id,
     mask;
 
@@ -430,21 +434,23 @@ static Image *ReadPCXImage(const ImageInfo *image_info,ExceptionInfo *exception)
       Uncompress image data.
     */
     p=pixels;
+    GetBlobReader(image,&reader);
     if (pcx_info.encoding == 0)
       while (pcx_packets != 0)
       {
-        packet=(unsigned char) ReadBlobByte(image);
-        if (EOFBlob(image) != MagickFalse)
+        c=ReadBlobReaderByte(&reader);
+        if (c == EOF)
           ThrowPCXException(CorruptImageError,"UnexpectedEndOfFile");
-        *p++=packet;
+        *p++=(unsigned char) c;
         pcx_packets--;
       }
     else
       while (pcx_packets != 0)
       {
-        packet=(unsigned char) ReadBlobByte(image);
-        if (EOFBlob(image) != MagickFalse)
+        c=ReadBlobReaderByte(&reader);
+        if (c == EOF)
           ThrowPCXException(CorruptImageError,"UnexpectedEndOfFile");
+        packet=(unsigned char) c;
         if ((packet & 0xc0) != 0xc0)
           {
             *p++=packet;
@@ -452,9 +458,10 @@ static Image *ReadPCXImage(const ImageInfo *image_info,ExceptionInfo *exception)
             continue;
           }
         count=(ssize_t) (packet & 0x3f);
-        packet=(unsigned char) ReadBlobByte(image);
-        if (EOFBlob(image) != MagickFalse)
+        c=ReadBlobReaderByte(&reader);
+        if (c == EOF)
           ThrowPCXException(CorruptImageError,"UnexpectedEndOfFile");
+        packet=(unsigned char) c;
         for ( ; count != 0; count--)
         {
           *p++=packet;
@@ -463,6 +470,7 @@ static Image *ReadPCXImage(const ImageInfo *image_info,ExceptionInfo *exception)
             break;
         }
       }
+    SyncBlobReader(&reader);
     if (image->storage_class == DirectClass)
       image->alpha_trait=pcx_info.planes > 3 ? BlendPixelTrait :
         UndefinedPixelTrait;
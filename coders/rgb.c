@@ -63,6 +63,7 @@
 #include "MagickCore/string_.h"
 #include "MagickCore/module.h"
 #include "MagickCore/utility.h"
+#include "coders/coders-private.h"
 
 /*
   Forward declarations.
@@ -233,6 +234,17 @@ static Image *ReadRGBImage(const ImageInfo *image_info,ExceptionInfo *exception)
             length=GetQuantumExtent(canvas_image,quantum_info,quantum_type);
             stream=ReadBlobStream(image,length,pixels,&count);
           }
+        if ((image->extract_info.x == 0) && (image->extract_info.y == 0) &&
+            (canvas_image->columns == image->columns) &&
+            (image->extract_info.height == image->rows))
+          {
+            /*
+              Not cropped: import straight from the blob into the image.
+            */
+            status=ImportCoderQuantumRows(image,quantum_info,quantum_type,
+              pixels,&stream,&length,&count,exception);
+            break;
+          }
         for (y=0; y < (ssize_t) image->extract_info.height; y++)
         {
           const Quantum
@@ -145,9 +145,15 @@ static MagickBooleanType
 */
 static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
 {
+  BlobReader
+    reader;
+
   const char
     *option;
 
+  const unsigned char
+    *p;
+
   Image
     *image;
 
@@ -182,7 +188,6 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
   unsigned char
     j,
     k,
-    pixels[4],
     runlength;
 
   /*
@@ -441,6 +446,7 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
   offset_stepsize=1;
   if (((unsigned char) (tga_info.attributes & 0xc0) >> 6) == 2)
     offset_stepsize=2;
+  GetBlobReader(image,&reader);
   for (y=0; y < (ssize_t) image->rows; y++)
   {
     ssize_t
@@ -465,9 +471,10 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
             }
           else
             {
-              count=ReadBlob(image,1,&runlength);
-              if (count != 1)
+              count=ReadBlobReaderByte(&reader);
+              if (count == EOF)
                 ThrowReaderException(CorruptImageError,"UnableToReadImageData");
+              runlength=(unsigned char) count;
               flag=runlength & 0x80;
               if (flag != 0)
                 runlength-=128;
@@ -481,10 +488,11 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
           {
             if ((x & 0x07) == 0)
               {
-                if (ReadBlob(image,1,pixels) != 1)
+                p=ReadBlobReaderBytes(&reader,1);
+                if (p == (const unsigned char *) NULL)
                   ThrowReaderException(CorruptImageError,
                     "UnableToReadImageData");
-                index=(Quantum) pixels[0];
+                index=(Quantum) p[0];
               }
             else
               index=(Quantum) ((size_t) index << 1);
@@ -506,9 +514,10 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
             /*
               Gray scale.
             */
-            if (ReadBlob(image,1,pixels) != 1)
+            p=ReadBlobReaderBytes(&reader,1);
+            if (p == (const unsigned char *) NULL)
               ThrowReaderException(CorruptImageError,"UnableToReadImageData");
-            index=(Quantum) pixels[0];
+            index=(Quantum) p[0];
             if (tga_info.colormap_type != 0)
               pixel=image->colormap[(ssize_t) ConstrainColormapIndex(image,
                 (ssize_t) index,exception)];
@@ -530,10 +539,11 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
             /*
               5 bits each of RGB.
             */
-            if (ReadBlob(image,2,pixels) != 2)
+            p=ReadBlobReaderBytes(&reader,2);
+            if (p == (const unsigned char *) NULL)
               ThrowReaderException(CorruptImageError,"UnableToReadImageData");
-            j=pixels[0];
-            k=pixels[1];
+            j=p[0];
+            k=p[1];
             range=GetQuantumRange(5UL);
             pixel.red=(MagickRealType) ScaleAnyToQuantum(1UL*(k & 0x7c) >> 2,
               range);
@@ -553,11 +563,12 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
             /*
               BGR pixels.
             */
-            if (ReadBlob(image,3,pixels) != 3)
+            p=ReadBlobReaderBytes(&reader,3);
+            if (p == (const unsigned char *) NULL)
               ThrowReaderException(CorruptImageError,"UnableToReadImageData");
-            pixel.blue=(MagickRealType) ScaleCharToQuantum(pixels[0]);
-            pixel.green=(MagickRealType) ScaleCharToQuantum(pixels[1]);
-            pixel.red=(MagickRealType) ScaleCharToQuantum(pixels[2]);
+            pixel.blue=(MagickRealType) ScaleCharToQuantum(p[0]);
+            pixel.green=(MagickRealType) ScaleCharToQuantum(p[1]);
+            pixel.red=(MagickRealType) ScaleCharToQuantum(p[2]);
             break;
           }
           case 32:
@@ -565,12 +576,13 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
             /*
               BGRA pixels.
             */
-            if (ReadBlob(image,4,pixels) != 4)
+            p=ReadBlobReaderBytes(&reader,4);
+            if (p == (const unsigned char *) NULL)
               ThrowReaderException(CorruptImageError,"UnableToReadImageData");
-            pixel.blue=(MagickRealType) ScaleCharToQuantum(pixels[0]);
-            pixel.green=(MagickRealType) ScaleCharToQuantum(pixels[1]);
-            pixel.red=(MagickRealType) ScaleCharToQuantum(pixels[2]);
-            pixel.alpha=(MagickRealType) ScaleCharToQuantum(pixels[3]);
+            pixel.blue=(MagickRealType) ScaleCharToQuantum(p[0]);
+            pixel.green=(MagickRealType) ScaleCharToQuantum(p[1]);
+            pixel.red=(MagickRealType) ScaleCharToQuantum(p[2]);
+            pixel.alpha=(MagickRealType) ScaleCharToQuantum(p[3]);
             break;
           }
         }
@@ -604,6 +616,7 @@ static Image *ReadTGAImage(const ImageInfo *image_info,ExceptionInfo *exception)
           break;
       }
   }
+  SyncBlobReader(&reader);
   if (EOFBlob(image) != MagickFalse)
     ThrowFileException(exception,CorruptImageError,"UnexpectedEndOfFile",
       image->filename);
@@ -1016,6 +1016,39 @@ static TIFFMethodType GetJPEGMethod(Image* image,TIFF *tiff,uint16 photometric,
   return(method);
 }
 
+static MagickBooleanType GetTIFFRegion(const ImageInfo *image_info,
+  const Image *image,const uint16 bits_per_sample,RectangleInfo *region)
+{
+  MagickStatusType
+    flags;
+
+  RectangleInfo
+    geometry;
+
+  /*
+    Only decode the strips or tiles that intersect the extract geometry.
+  */
+  if ((image_info->extract == (char *) NULL) ||
+      (image_info->stream != (StreamHandler) NULL))
+    return(MagickFalse);
+  if (((bits_per_sample % 8) != 0) || (image->page.x != 0) ||
+      (image->page.y != 0))
+    return(MagickFalse);
+  SetGeometry(image,&geometry);
+  flags=ParseAbsoluteGeometry(image_info->extract,&geometry);
+  if (((flags & XValue) == 0) && ((flags & YValue) == 0))
+    return(MagickFalse);
+  if ((geometry.width == 0) || (geometry.height == 0) || (geometry.x < 0) ||
+      (geometry.y < 0) ||
+      ((geometry.x+(ssize_t) geometry.width) > (ssize_t) image->columns) ||
+      ((geometry.y+(ssize_t) geometry.height) > (ssize_t) image->rows))
+    return(MagickFalse);
+  if ((geometry.width == image->columns) && (geometry.height == image->rows))
+    return(MagickFalse);
+  *region=geometry;
+  return(MagickTrue);
+}
+
 static ssize_t TIFFReadCustomStream(unsigned char *data,const size_t count,
   void *user_data)
 {
@@ -1199,6 +1232,9 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
   QuantumType
     image_quantum_type;
 
+  RectangleInfo
+    region;
+
   ssize_t
     i,
     scanline_size,
@@ -1618,6 +1654,63 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
             break;
         goto next_tiff_frame;
       }
+    method=ReadGenericMethod;
+    rows_per_strip=(uint32) image->rows;
+    if (TIFFGetField(tiff,TIFFTAG_ROWSPERSTRIP,&rows_per_strip) == 1)
+      {
+        char
+          buffer[MagickPathExtent];
+
+        (void) FormatLocaleString(buffer,MagickPathExtent,"%u",
+          (unsigned int) rows_per_strip);
+        (void) SetImageProperty(image,"tiff:rows-per-strip",buffer,exception);
+        method=ReadStripMethod;
+        if (rows_per_strip > (uint32) image->rows)
+          rows_per_strip=(uint32) image->rows;
+      }
+    else if (image->depth > 8)
+      method=ReadStripMethod;
+    if (TIFFIsTiled(tiff) != MagickFalse)
+      {
+        uint32
+          columns,
+          rows;
+
+        if ((TIFFGetField(tiff,TIFFTAG_TILEWIDTH,&columns) != 1) ||
+            (TIFFGetField(tiff,TIFFTAG_TILELENGTH,&rows) != 1))
+          ThrowTIFFException(CoderError,"ImageIsNotTiled");
+        if ((AcquireMagickResource(WidthResource,columns) == MagickFalse) ||
+            (AcquireMagickResource(HeightResource,rows) == MagickFalse))
+          ThrowTIFFException(ImageError,"WidthOrHeightExceedsLimit");
+        method=ReadTileMethod;
+      }
+    if ((photometric == PHOTOMETRIC_LOGLUV) ||
+        (compress_tag == COMPRESSION_CCITTFAX3))
+      method=ReadGenericMethod;
+    if (image->compression == JPEGCompression)
+      method=GetJPEGMethod(image,tiff,photometric,bits_per_sample,
+        samples_per_pixel);
+    region.width=image->columns;
+    region.height=image->rows;
+    region.x=0;
+    region.y=0;
+    if (((method == ReadStripMethod) || (method == ReadTileMethod)) &&
+        (photometric != PHOTOMETRIC_YCBCR) &&
+        (GetTIFFRegion(image_info,image,bits_per_sample,&region) != MagickFalse))
+      {
+        /*
+          Decode only the extract region; ReadImage() then skips its crop.
+        */
+        if ((image->page.width == 0) || (image->page.height == 0))
+          {
+            image->page.width=(size_t) width;
+            image->page.height=(size_t) height;
+          }
+        image->page.x=region.x;
+        image->page.y=region.y;
+        image->columns=region.width;
+        image->rows=region.height;
+      }
     status=SetImageExtent(image,image->columns,image->rows,exception);
     if (status == MagickFalse)
       {
@@ -1713,42 +1806,6 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
           (void) SetImageProperty(image,"tiff:alpha","unspecified",exception);
         (void) SetImageAlphaChannel(image,OpaqueAlphaChannel,exception);
       }
-    method=ReadGenericMethod;
-    rows_per_strip=(uint32) image->rows;
-    if (TIFFGetField(tiff,TIFFTAG_ROWSPERSTRIP,&rows_per_strip) == 1)
-      {
-        char
-          buffer[MagickPathExtent];
-
-        (void) FormatLocaleString(buffer,MagickPathExtent,"%u",
-          (unsigned int) rows_per_strip);
-        (void) SetImageProperty(image,"tiff:rows-per-strip",buffer,exception);
-        method=ReadStripMethod;
-        if (rows_per_strip > (uint32) image->rows)
-          rows_per_strip=(uint32) image->rows;
-      }
-    else if (image->depth > 8)
-      method=ReadStripMethod;
-    if (TIFFIsTiled(tiff) != MagickFalse)
-      {
-        uint32
-          columns,
-          rows;
-
-        if ((TIFFGetField(tiff,TIFFTAG_TILEWIDTH,&columns) != 1) ||
-            (TIFFGetField(tiff,TIFFTAG_TILELENGTH,&rows) != 1))
-          ThrowTIFFException(CoderError,"ImageIsNotTiled");
-        if ((AcquireMagickResource(WidthResource,columns) == MagickFalse) ||
-            (AcquireMagickResource(HeightResource,rows) == MagickFalse))
-          ThrowTIFFException(ImageError,"WidthOrHeightExceedsLimit");
-        method=ReadTileMethod;
-      }
-    if ((photometric == PHOTOMETRIC_LOGLUV) ||
-        (compress_tag == COMPRESSION_CCITTFAX3))
-      method=ReadGenericMethod;
-    if (image->compression == JPEGCompression)
-      method=GetJPEGMethod(image,tiff,photometric,bits_per_sample,
-        samples_per_pixel);
 #if defined(WORDS_BIGENDIAN)
     (void) SetQuantumEndian(image,quantum_info,MSBEndian);
 #else
@@ -1757,8 +1814,8 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
     scanline_size=TIFFScanlineSize(tiff);
     if (scanline_size <= 0)
       ThrowTIFFException(ResourceLimitError,"MemoryAllocationFailed");
-    number_pixels=MagickMax((MagickSizeType) (image->columns*samples_per_pixel*
-      pow(2.0,ceil(log(bits_per_sample)/log(2.0)))),image->columns*
+    number_pixels=MagickMax((MagickSizeType) (width*samples_per_pixel*
+      pow(2.0,ceil(log(bits_per_sample)/log(2.0)))),(MagickSizeType) width*
       rows_per_strip);
     if ((double) scanline_size > 1.5*number_pixels)
       ThrowTIFFException(CorruptImageError,"CorruptImage");
@@ -1890,6 +1947,7 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
             count,
             extent,
             length,
+            offset,
             stride,
             strip_size;
 
@@ -1914,7 +1972,9 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
           if (strip_pixels == (unsigned char *) NULL)
             ThrowTIFFException(ResourceLimitError,"MemoryAllocationFailed");
           (void) memset(strip_pixels,0,extent*sizeof(*strip_pixels));
-          strip_id=0;
+          offset=(size_t) region.x*(bits_per_sample >> 3);
+          if (interlace != PLANARCONFIG_SEPARATE)
+            offset*=samples_per_pixel;
           p=strip_pixels;
           for (i=0; i < (ssize_t) samples_per_pixel; i++)
           {
@@ -1976,13 +2036,17 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
                 break;
               if (rows_remaining == 0)
                 {
+                  uint32_t
+                    row;
+
+                  row=(uint32_t) (y+region.y);
+                  strip_id=TIFFComputeStrip(tiff,row,(uint16_t) i);
                   size=TIFFReadEncodedStrip(tiff,strip_id,strip_pixels,
                     strip_size);
                   if (size == -1)
                     break;
-                  rows_remaining=rows_per_strip;
-                  p=strip_pixels;
-                  strip_id++;
+                  rows_remaining=rows_per_strip-(row % rows_per_strip);
+                  p=strip_pixels+(row % rows_per_strip)*stride+offset;
                 }
               (void) ImportQuantumPixels(image,(CacheView *) NULL,
                 quantum_info,quantum_type,p,exception);
@@ -2012,6 +2076,7 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
             count,
             extent,
             length,
+            packet_size,
             stride,
             tile_size;
 
@@ -2045,6 +2110,9 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
           if (tile_pixels == (unsigned char *) NULL)
             ThrowTIFFException(ResourceLimitError,"MemoryAllocationFailed");
           (void) memset(tile_pixels,0,extent*sizeof(*tile_pixels));
+          packet_size=(size_t) (bits_per_sample >> 3);
+          if (interlace != PLANARCONFIG_SEPARATE)
+            packet_size*=samples_per_pixel;
           for (i=0; i < (ssize_t) samples_per_pixel; i++)
           {
             QuantumType
@@ -2091,38 +2159,45 @@ static Image *ReadTIFFImage(const ImageInfo *image_info,
                 break;
               }
             }
-            for (y=0; y < (ssize_t) image->rows; y+=rows)
+            for (y=region.y-(region.y % (ssize_t) rows);
+                 y < (region.y+(ssize_t) image->rows); y+=(ssize_t) rows)
             {
               ssize_t
+                top,
                 x;
 
               size_t
                 rows_remaining;
 
-              rows_remaining=image->rows-(size_t) y;
-              if ((ssize_t) (y+rows) < (ssize_t) image->rows)
-                rows_remaining=rows;
-              for (x=0; x < (ssize_t) image->columns; x+=columns)
+              top=MagickMax(y,region.y);
+              rows_remaining=(size_t) (MagickMin(y+(ssize_t) rows,region.y+
+                (ssize_t) image->rows)-top);
+              for (x=region.x-(region.x % (ssize_t) columns);
+                   x < (region.x+(ssize_t) image->columns); x+=(ssize_t) columns)
               {
                 size_t
                   columns_remaining,
                   row;
 
-                columns_remaining=image->columns-(size_t) x;
-                if ((x+(ssize_t) columns) < (ssize_t) image->columns)
-                  columns_remaining=columns;
+                ssize_t
+                  left;
+
+                left=MagickMax(x,region.x);
+                columns_remaining=(size_t) (MagickMin(x+(ssize_t) columns,
+                  region.x+(ssize_t) image->columns)-left);
                 size=TIFFReadTile(tiff,tile_pixels,(uint32_t) x,(uint32_t) y,
                   0,(uint16_t) i);
                 if (size == -1)
                   break;
-                p=tile_pixels;
+                p=tile_pixels+(size_t) (top-y)*stride+(size_t) (left-x)*
+                  packet_size;
                 for (row=0; row < rows_remaining; row++)
                 {
                   Quantum
                     *magick_restrict q;
 
-                  q=GetAuthenticPixels(image,x,y+(ssize_t) row,
-                    columns_remaining,1,exception);
+                  q=GetAuthenticPixels(image,left-region.x,top-region.y+
+                    (ssize_t) row,columns_remaining,1,exception);
                   if (q == (Quantum *) NULL)
                     break;
                   (void) ImportQuantumPixels(image,(CacheView *) NULL,
@@ -65,6 +65,13 @@
 #define D65Y  1.0
 #define D65Z  1.08883
 #define ReferenceEpsilon  ((double) QuantumRange*1.0e-2)
+#if (MAGICKCORE_QUANTUM_DEPTH == 8)
+#define FastForwardEpsilon  (2.0/255.0)
+#define FastInverseEpsilon  (0.5/255.0)
+#else
+#define FastForwardEpsilon  (32.0/65535.0)
+#define FastInverseEpsilon  (16.0/65535.0)
+#endif
 
 /*
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -524,6 +531,93 @@ static MagickBooleanType ValidateYUVToRGB()
   return(MagickTrue);
 }
 
+static MagickBooleanType ValidateFastColorspace(const char *name,
+  const ColorspaceType colorspace,const MagickBooleanType inverse,
+  const double tolerance,ExceptionInfo *exception)
+{
+  double
+    distortion;
+
+  Image
+    *exact_image,
+    *fast_image,
+    *image;
+
+  MagickBooleanType
+    status;
+
+  size_t
+    seed;
+
+  ssize_t
+    y;
+
+  /*
+    Compare colorspace:precision=fast to the exact conversion on an image
+    large enough for the fast path to be taken.
+  */
+  (void) FormatLocaleFile(stdout,"  %s%s (fast)",inverse == MagickFalse ?
+    "RGBTo" : name,inverse == MagickFalse ? name : "ToRGB");
+  image=AcquireImage((ImageInfo *) NULL,exception);
+  if (image == (Image *) NULL)
+    return(MagickFalse);
+  status=SetImageExtent(image,256,512,exception);
+  seed=1;
+  for (y=0; (status != MagickFalse) && (y < (ssize_t) image->rows); y++)
+  {
+    Quantum
+      *q;
+
+    ssize_t
+      x;
+
+    q=GetAuthenticPixels(image,0,y,image->columns,1,exception);
+    if (q == (Quantum *) NULL)
+      {
+        status=MagickFalse;
+        break;
+      }
+    for (x=0; x < (ssize_t) image->columns; x++)
+    {
+      seed=1103515245*seed+12345;
+      SetPixelRed(image,ScaleShortToQuantum((unsigned short) (seed >> 8)),q);
+      seed=1103515245*seed+12345;
+      SetPixelGreen(image,ScaleShortToQuantum((unsigned short) (seed >> 8)),
+        q);
+      seed=1103515245*seed+12345;
+      SetPixelBlue(image,ScaleShortToQuantum((unsigned short) (seed >> 8)),q);
+      q+=(ptrdiff_t) GetPixelChannels(image);
+    }
+    status=SyncAuthenticPixels(image,exception);
+  }
+  if ((status != MagickFalse) && (inverse != MagickFalse))
+    status=TransformImageColorspace(image,colorspace,exception);
+  exact_image=CloneImage(image,0,0,MagickTrue,exception);
+  fast_image=CloneImage(image,0,0,MagickTrue,exception);
+  image=DestroyImage(image);
+  if ((exact_image == (Image *) NULL) || (fast_image == (Image *) NULL))
+    status=MagickFalse;
+  if (status != MagickFalse)
+    {
+      (void) SetImageArtifact(fast_image,"colorspace:precision","fast");
+      status=TransformImageColorspace(exact_image,inverse == MagickFalse ?
+        colorspace : sRGBColorspace,exception);
+      if (status != MagickFalse)
+        status=TransformImageColorspace(fast_image,inverse == MagickFalse ?
+          colorspace : sRGBColorspace,exception);
+    }
+  if (status != MagickFalse)
+    status=GetImageDistortion(exact_image,fast_image,
+      PeakAbsoluteErrorMetric,&distortion,exception);
+  if (fast_image != (Image *) NULL)
+    fast_image=DestroyImage(fast_image);
+  if (exact_image != (Image *) NULL)
+    exact_image=DestroyImage(exact_image);
+  if ((status == MagickFalse) || (distortion > tolerance))
+    return(MagickFalse);
+  return(MagickTrue);
+}
+
 static size_t ValidateColorspaces(size_t *fails,ExceptionInfo *exception)
 {
   MagickBooleanType
@@ -557,7 +651,7 @@ static size_t ValidateColorspaces(size_t *fails,ExceptionInfo *exception)
   */
   (void) FormatLocaleFile(stdout,"validate colorspaces:\n");
   fail=0;
-  for (test=0; test < 26; test++)
+  for (test=0; test < 30; test++)
   {
     CatchException(exception);
     (void) FormatLocaleFile(stdout,"  test %.20g: ",(double) test);
@@ -589,6 +683,14 @@ static size_t ValidateColorspaces(size_t *fails,ExceptionInfo *exception)
       case 23: status=ValidateRGBToYPbPr(); break;
       case 24: status=ValidateYUVToRGB(); break;
       case 25: status=ValidateRGBToYUV(); break;
+      case 26: status=ValidateFastColorspace("Lab",LabColorspace,MagickFalse,
+        FastForwardEpsilon,exception); break;
+      case 27: status=ValidateFastColorspace("Lab",LabColorspace,MagickTrue,
+        FastInverseEpsilon,exception); break;
+      case 28: status=ValidateFastColorspace("LCHab",LCHabColorspace,
+        MagickFalse,FastForwardEpsilon,exception); break;
+      case 29: status=ValidateFastColorspace("LCHab",LCHabColorspace,
+        MagickTrue,FastInverseEpsilon,exception); break;
       default: status=MagickFalse;
     }
     if (status == MagickFalse)